@@ -0,0 +1,169 @@
+//
+// All-associativity simulation: hit counts for every (sets, ways) LRU cache
+// configuration in a design space, from one pass over a block stream
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "all-assoc.h"
+
+
+using namespace SimCfg;
+using std::string;
+using std::vector;
+
+
+struct AllAssocSim::StackState {
+    // One set count's stacks: a max_ways-deep LRU stack per set
+    struct Level {
+        long set_mask;
+        vector<LongAddr> stacks;        // [sets][max_ways], MRU first
+        vector<int> depth;              // [sets]: valid entries in stack
+        Level(int sets_lg, int max_ways)
+            : set_mask((1L << sets_lg) - 1),
+              stacks((1L << sets_lg) * max_ways),
+              depth(1L << sets_lg, 0) { }
+    };
+
+    int max_ways;
+    vector<Level> levels;               // [n_set_counts], fewest sets first
+
+    StackState(int min_sets_lg, int max_sets_lg, int max_ways_)
+        : max_ways(max_ways_) {
+        for (int k = min_sets_lg; k <= max_sets_lg; ++k)
+            levels.push_back(Level(k, max_ways));
+    }
+
+    void clear() {
+        for (int i = 0; i < intsize(levels); ++i) {
+            std::fill(levels[i].depth.begin(), levels[i].depth.end(), 0);
+        }
+    }
+
+    // Make "addr" MRU in its set at levels[level], and return its previous
+    // stack distance there; max_ways means "not in the stack" (a miss at
+    // every associativity).  If "known_absent", skip looking for it.
+    int touch(int level, const LongAddr& addr, bool known_absent) {
+        Level& lv = levels[level];
+        long set_num = long(addr.a & lv.set_mask);
+        LongAddr *stack = &lv.stacks[set_num * max_ways];
+        int& depth = lv.depth[set_num];
+        int pos = depth;
+        if (!known_absent) {
+            for (pos = 0; pos < depth; ++pos) {
+                if (stack[pos] == addr)
+                    break;
+            }
+        }
+        const int dist = (pos < depth) ? pos : max_ways;
+        if (pos == depth) {
+            if (depth == max_ways)
+                pos = depth - 1;        // drop the LRU entry
+            else
+                depth++;
+        }
+        for (; pos > 0; --pos)
+            stack[pos] = stack[pos - 1];
+        stack[0] = addr;
+        return dist;
+    }
+};
+
+
+AllAssocSim::AllAssocSim(const string& cfg_path)
+{
+    long min_sets = conf_int(cfg_path + "/min_sets");
+    long max_sets = conf_int(cfg_path + "/max_sets");
+    max_ways = conf_int(cfg_path + "/max_ways");
+    min_sets_lg = log2_exact(min_sets);
+    max_sets_lg = log2_exact(max_sets);
+    if ((min_sets_lg < 0) || (max_sets_lg < 0) ||
+        (max_sets_lg < min_sets_lg)) {
+        exit_printf("%s: min_sets/max_sets (%ld/%ld) must be powers of 2, "
+                    "min <= max\n", cfg_path.c_str(), min_sets, max_sets);
+    }
+    if (max_ways < 1) {
+        exit_printf("%s/max_ways (%d) must be positive\n", cfg_path.c_str(),
+                    max_ways);
+    }
+    stack = new StackState(min_sets_lg, max_sets_lg, max_ways);
+    dist_hits.resize(g_n_set_counts() * max_ways);
+    reset();
+}
+
+
+AllAssocSim::~AllAssocSim()
+{
+    delete stack;
+}
+
+
+void
+AllAssocSim::reset()
+{
+    stack->clear();
+    reset_stats();
+}
+
+
+void
+AllAssocSim::reset_stats()
+{
+    std::fill(dist_hits.begin(), dist_hits.end(), 0);
+    accesses = 0;
+}
+
+
+void
+AllAssocSim::access(mem_addr block_num, int master_id)
+{
+    LongAddr addr(block_num, master_id);
+    accesses++;
+    // Most sets first: once the block misses at one set count, it's known
+    // to miss at all smaller ones
+    bool missed = false;
+    for (int sets_idx = g_n_set_counts() - 1; sets_idx >= 0; --sets_idx) {
+        int dist = stack->touch(sets_idx, addr, missed);
+        if (dist < max_ways) {
+            dist_hits[sets_idx * max_ways + dist]++;
+        } else {
+            missed = true;
+        }
+    }
+}
+
+
+i64
+AllAssocSim::hits(int sets_idx, int ways) const
+{
+    sim_assert((sets_idx >= 0) && (sets_idx < g_n_set_counts()));
+    sim_assert((ways >= 1) && (ways <= max_ways));
+    i64 result = 0;
+    for (int dist = 0; dist < ways; ++dist)
+        result += dist_hits[sets_idx * max_ways + dist];
+    return result;
+}
+
+
+void
+AllAssocSim::print(const char *pref, const char *name) const
+{
+    printf("%s%s: all-assoc accesses: %s\n", pref, name, fmt_i64(accesses));
+    for (int sets_idx = 0; sets_idx < g_n_set_counts(); ++sets_idx) {
+        printf("%s%s: all-assoc hits, %ld sets:", pref, name,
+               g_sets(sets_idx));
+        for (int ways = 1; ways <= max_ways; ++ways)
+            printf(" %d:%s", ways, fmt_i64(hits(sets_idx, ways)));
+        printf("\n");
+    }
+}
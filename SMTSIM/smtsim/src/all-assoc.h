@@ -0,0 +1,71 @@
+// -*- C++ -*-
+//
+// All-associativity simulation: hit counts for every (sets, ways) LRU cache
+// configuration in a design space, from one pass over a block stream
+//
+
+#ifndef ALL_ASSOC_H
+#define ALL_ASSOC_H
+
+#include <string>
+#include <vector>
+
+
+// Relevant paper:
+//
+// Evaluating Associativity in CPU Caches; Mark D. Hill, Alan Jay Smith;
+// IEEE Transactions on Computers 38(12), 1989
+//
+// An LRU set's stack distance for an access -- the number of other blocks
+// in its set referenced since the block's last reference -- gives its hits
+// at every associativity at once: it hits with w ways iff the distance is
+// below w.  Only distances below "max_ways" matter, so each set count keeps
+// a max_ways-deep stack per set, all in one flat array.
+//
+// With bit-selection set indexing, each set at 2^k sets is split in two at
+// 2^(k+1) sets, so a block's distance can only shrink as sets are added.
+// The stacks are updated from the most sets down: once an access misses at
+// one set count, it misses at every smaller one, without searching them.
+
+
+class AllAssocSim {
+public:
+    // Reads "min_sets", "max_sets" (powers of 2), and "max_ways" from config
+    // subtree "cfg_path"
+    explicit AllAssocSim(const std::string& cfg_path);
+    ~AllAssocSim();
+
+    // Note an access to the given block (address >> block_bytes_lg)
+    void access(mem_addr block_num, int master_id);
+
+    void reset();               // flush all state and zero stats
+    void reset_stats();
+
+    int g_n_set_counts() const { return max_sets_lg - min_sets_lg + 1; }
+    long g_sets(int sets_idx) const { return 1L << (min_sets_lg + sets_idx); }
+    int g_max_ways() const { return max_ways; }
+    i64 g_accesses() const { return accesses; }
+
+    // Hits for a cache of g_sets(sets_idx) sets and "ways" ways, for ways in
+    // [1, max_ways]
+    i64 hits(int sets_idx, int ways) const;
+
+    void print(const char *pref, const char *name) const;
+
+private:
+    struct StackState;          // (LRU stack; defined in all-assoc.cc)
+
+    int min_sets_lg, max_sets_lg;
+    int max_ways;
+
+    StackState *stack;
+    std::vector<i64> dist_hits;         // [n_set_counts][max_ways]
+    i64 accesses;
+
+    // Disallow copying
+    AllAssocSim(const AllAssocSim&);
+    AllAssocSim& operator = (const AllAssocSim&);
+};
+
+
+#endif  // ALL_ASSOC_H
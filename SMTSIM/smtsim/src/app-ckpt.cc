@@ -0,0 +1,470 @@
+//
+// Architectural checkpoints: save the emulation state of fast-forwarded
+// apps to a compressed file, and restore it later in place of
+// fast-forwarding
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// (like app-state.cc, this deliberately avoids simulation-related headers)
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "app-ckpt.h"
+#include "app-state.h"
+#include "prog-mem.h"
+#include "region-alloc.h"
+#include "syscalls.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "gzstream.h"
+#include "ckpt-io.h"
+
+using std::istringstream;
+using std::map;
+using std::ostringstream;
+using std::pair;
+using std::string;
+using std::vector;
+
+
+namespace {
+
+const char *CkptMagic = "SMTSIM-AppCkpt";
+const i32 CkptVersion = 3;
+// Segment contents go in a separate, uncompressed file with this suffix
+const char *MemImageSuffix = ".mem";
+
+struct RecordKey {
+    i64 job_id;
+    string workload_path;
+    RecordKey(i64 job_id_, const string& workload_path_)
+        : job_id(job_id_), workload_path(workload_path_) { }
+    bool operator < (const RecordKey& other) const {
+        return (job_id < other.job_id) ||
+            ((job_id == other.job_id) &&
+             (workload_path < other.workload_path));
+    }
+};
+
+// Serialized AppState bodies, by job
+typedef map<RecordKey, string> RecordMap;
+
+struct {
+    string save_name;
+    gzstream::ogzstream *save_out;      // NULL <=> not saving
+    int n_saved;
+    FILE *save_mem;                     // Memory image file
+    i64 save_mem_len;                   // Length so far, page-aligned
+    i64 save_mem_pos;                   // Current save_mem file position
+    string restore_name;
+    RecordMap *restore_records;         // NULL <=> not restoring
+    int restore_mem_fd;                 // (kept open; see restore_pmem())
+    i64 restore_mem_len;
+} CkptGlobals = { "", NULL, 0, NULL, 0, 0, "", NULL, -1, 0 };
+
+
+// Base VAs of all segments mapped in "pmem", in address order
+void
+list_segment_bases(ProgMem *pmem, vector<mem_addr>& bases_ret)
+{
+    bases_ret.clear();
+    if (pmem_get_seg(pmem, 0))
+        bases_ret.push_back(0);
+    mem_addr base = 0;
+    while ((base = pmem_get_nextbase(pmem, base)) != 0)
+        bases_ret.push_back(base);
+}
+
+
+bool
+all_zero(const unsigned char *data, i64 len)
+{
+    for (i64 i = 0; i < len; i++) {
+        if (data[i])
+            return false;
+    }
+    return true;
+}
+
+
+// Append a segment image to the memory image file, starting at the next
+// page boundary, and return its offset.  All-zero pages aren't written,
+// just skipped over, leaving holes which read back as zeroes (and use no
+// disk space, where sparse files are supported).
+i64
+put_mem_image(const unsigned char *data, i64 size)
+{
+    FILE *out = CkptGlobals.save_mem;
+    const i64 page_size = ralloc_page_size();
+    const i64 offset = CkptGlobals.save_mem_len;
+    sim_assert((offset % page_size) == 0);
+    for (i64 pos = 0; pos < size; pos += page_size) {
+        i64 len = (size - pos < page_size) ? (size - pos) : page_size;
+        if (all_zero(data + pos, len))
+            continue;
+        if ((CkptGlobals.save_mem_pos != offset + pos) &&
+            fseeko(out, off_t(offset + pos), SEEK_SET)) {
+            exit_printf("seek in checkpoint memory image \"%s%s\" failed: "
+                        "%s\n", CkptGlobals.save_name.c_str(),
+                        MemImageSuffix, strerror(errno));
+        }
+        if (fwrite(data + pos, 1, len, out) != size_t(len)) {
+            exit_printf("write to checkpoint memory image \"%s%s\" failed: "
+                        "%s\n", CkptGlobals.save_name.c_str(),
+                        MemImageSuffix, strerror(errno));
+        }
+        CkptGlobals.save_mem_pos = offset + pos + len;
+    }
+    CkptGlobals.save_mem_len = offset +
+        ((size + page_size - 1) / page_size) * page_size;
+    return offset;
+}
+
+
+void
+save_argv(std::ostream& out, const AppParams *params)
+{
+    ckpt_put_str(out, params->bin_filename);
+    ckpt_put(out, params->argc);
+    for (int i = 0; i < params->argc; i++)
+        ckpt_put_str(out, params->argv[i]);
+}
+
+
+// Check the saved binary/argv against the app being restored into
+void
+check_argv(std::istream& in, const AppParams *params, const string& where)
+{
+    string saved_bin;
+    int saved_argc;
+    ckpt_get_str(in, saved_bin, "app binary");
+    ckpt_get(in, saved_argc, "app argc");
+    bool match = (saved_bin == params->bin_filename) &&
+        (saved_argc == params->argc);
+    for (int i = 0; i < saved_argc; i++) {
+        string arg;
+        ckpt_get_str(in, arg, "app argv");
+        if (match && (arg != params->argv[i]))
+            match = false;
+    }
+    if (!match) {
+        exit_printf("checkpoint restore: %s was saved running \"%s\" with "
+                    "%d args, which don't match this run's \"%s\" with %d "
+                    "args\n", where.c_str(), saved_bin.c_str(), saved_argc,
+                    params->bin_filename, params->argc);
+    }
+}
+
+
+void
+save_pmem(std::ostream& out, ProgMem *pmem)
+{
+    vector<mem_addr> bases;
+    list_segment_bases(pmem, bases);
+    ckpt_put_tag(out, "ProgMem");
+    ckpt_put(out, i64(bases.size()));
+    for (int i = 0; i < intsize(bases); i++) {
+        mem_addr base = bases[i];
+        ProgMemSegment *seg = pmem_get_seg(pmem, base);
+        unsigned access_flags, create_flags;
+        sim_assert(seg != NULL);
+        if (pmem_get_flags(pmem, base, &access_flags, &create_flags)) {
+            abort_printf("pmem_get_flags failed for segment at %s\n",
+                         fmt_mem(base));
+        }
+        ProgMemSegmentInfo info;
+        pms_query(seg, &info);
+        if (info.ref_count != 1) {
+            exit_printf("can't checkpoint segment at %s: shared by %d "
+                        "mappings\n", fmt_mem(base), info.ref_count);
+        }
+        ckpt_put(out, base);
+        ckpt_put(out, access_flags);
+        ckpt_put(out, create_flags);
+        ckpt_put(out, info.max_size);
+        ckpt_put(out, info.size);
+        ckpt_put(out, put_mem_image(static_cast<const unsigned char *>
+                                    (pms_contents(seg)), info.size));
+    }
+}
+
+
+void
+restore_pmem(std::istream& in, ProgMem *pmem)
+{
+    vector<mem_addr> bases;
+    list_segment_bases(pmem, bases);
+    for (int i = 0; i < intsize(bases); i++)
+        pmem_unmap(pmem, bases[i]);
+
+    i64 n_segs;
+    ckpt_expect_tag(in, "ProgMem");
+    ckpt_get(in, n_segs, "ProgMem segment count");
+    for (i64 i = 0; i < n_segs; i++) {
+        mem_addr base;
+        unsigned access_flags, create_flags;
+        i64 max_size, size, mem_offset;
+        ckpt_get(in, base, "segment base");
+        ckpt_get(in, access_flags, "segment access_flags");
+        ckpt_get(in, create_flags, "segment create_flags");
+        ckpt_get(in, max_size, "segment max_size");
+        ckpt_get(in, size, "segment size");
+        ckpt_get(in, mem_offset, "segment image offset");
+        if ((size <= 0) || (mem_offset < 0) ||
+            (mem_offset > CkptGlobals.restore_mem_len - size)) {
+            exit_printf("checkpoint restore: %s-byte segment at %s has "
+                        "image offset %s, outside of memory image \"%s%s\"\n",
+                        fmt_i64(size), fmt_mem(base), fmt_i64(mem_offset),
+                        CkptGlobals.restore_name.c_str(), MemImageSuffix);
+        }
+        // The segment is mapped straight from the image, so restoring is
+        // cheap, and only the pages the simulation goes on to touch are
+        // ever read.
+        if (pmem_map_file(pmem, size, base, access_flags, create_flags,
+                          CkptGlobals.restore_mem_fd, mem_offset)) {
+            exit_printf("checkpoint restore: couldn't map %s-byte segment "
+                        "at %s\n", fmt_i64(size), fmt_mem(base));
+        }
+        ProgMemSegment *seg = pmem_get_seg(pmem, base);
+        sim_assert(seg && (pms_size(seg) == size));
+        pms_set_maxsize(seg, max_size);
+    }
+}
+
+
+void
+save_app_body(std::ostream& out, const AppState *as, i64 ff_dist)
+{
+    ckpt_put_tag(out, "AppState");
+    save_argv(out, as->params);
+    ckpt_put(out, ff_dist);
+    ckpt_put(out, as->npc);
+    ckpt_put_bytes(out, as->R, sizeof(as->R));
+    ckpt_put(out, as->seg_info.bss_start);
+    ckpt_put(out, as->seg_info.stack_upper_lim);
+    ckpt_put(out, as->seg_info.stack_init_top);
+    ckpt_put(out, as->seg_info.entry_point);
+    ckpt_put(out, as->seg_info.gp_value);
+    ckpt_put(out, as->stats.total_insts);
+    ckpt_put(out, as->stats.total_syscalls);
+    ckpt_put(out, as->exit.has_exit);
+    ckpt_put(out, as->exit.exit_code);
+    save_pmem(out, as->pmem);
+    syscalls_ckpt_save(as->syscall_state, out);
+}
+
+
+void
+restore_app_body(std::istream& in, AppState *as, const string& where,
+                 i64 *ff_dist_ret)
+{
+    ckpt_expect_tag(in, "AppState");
+    check_argv(in, as->params, where);
+    ckpt_get(in, *ff_dist_ret, "ff_dist");
+    ckpt_get(in, as->npc, "npc");
+    ckpt_get_bytes(in, as->R, sizeof(as->R), "registers");
+    ckpt_get(in, as->seg_info.bss_start, "bss_start");
+    ckpt_get(in, as->seg_info.stack_upper_lim, "stack_upper_lim");
+    ckpt_get(in, as->seg_info.stack_init_top, "stack_init_top");
+    ckpt_get(in, as->seg_info.entry_point, "entry_point");
+    ckpt_get(in, as->seg_info.gp_value, "gp_value");
+    ckpt_get(in, as->stats.total_insts, "total_insts");
+    ckpt_get(in, as->stats.total_syscalls, "total_syscalls");
+    ckpt_get(in, as->exit.has_exit, "has_exit");
+    ckpt_get(in, as->exit.exit_code, "exit_code");
+    restore_pmem(in, as->pmem);
+    syscalls_ckpt_restore(as->syscall_state, in);
+}
+
+}       // Anonymous namespace close
+
+
+void
+appckpt_save_open(const char *filename)
+{
+    sim_assert(!CkptGlobals.save_out);
+    CkptGlobals.save_name = filename;
+    CkptGlobals.save_out = new gzstream::ogzstream(filename);
+    if (!CkptGlobals.save_out->is_open() || !*CkptGlobals.save_out) {
+        exit_printf("couldn't open checkpoint \"%s\" for writing\n",
+                    filename);
+    }
+    ckpt_put_tag(*CkptGlobals.save_out, CkptMagic);
+    ckpt_put(*CkptGlobals.save_out, CkptVersion);
+    CkptGlobals.n_saved = 0;
+    string mem_name = string(filename) + MemImageSuffix;
+    CkptGlobals.save_mem = fopen(mem_name.c_str(), "wb");
+    if (!CkptGlobals.save_mem) {
+        exit_printf("couldn't open checkpoint memory image \"%s\" for "
+                    "writing: %s\n", mem_name.c_str(), strerror(errno));
+    }
+    CkptGlobals.save_mem_len = 0;
+    CkptGlobals.save_mem_pos = 0;
+}
+
+
+int
+appckpt_saving(void)
+{
+    return CkptGlobals.save_out != NULL;
+}
+
+
+void
+appckpt_save_app(const AppState *as, i64 job_id, const char *workload_path,
+                 i64 ff_dist)
+{
+    sim_assert(CkptGlobals.save_out);
+    std::ostream& out = *CkptGlobals.save_out;
+    if (as->exit.has_exit) {
+        printf("--Checkpoint: not saving A%d (job %s): exited during "
+               "fast-forward\n", as->app_id, fmt_i64(job_id));
+        return;
+    }
+    // Bodies are length-prefixed, so that restoring can index the file
+    // without decoding every app.
+    ostringstream body;
+    save_app_body(body, as, ff_dist);
+    ckpt_put_tag(out, "Job");
+    ckpt_put(out, job_id);
+    ckpt_put_str(out, workload_path);
+    ckpt_put_str(out, body.str());
+    if (!out) {
+        exit_printf("write to checkpoint \"%s\" failed\n",
+                    CkptGlobals.save_name.c_str());
+    }
+    CkptGlobals.n_saved++;
+    printf("--Checkpoint: saved A%d (job %s, %s) at %s insts\n", as->app_id,
+           fmt_i64(job_id), workload_path, fmt_i64(as->stats.total_insts));
+}
+
+
+void
+appckpt_save_close(void)
+{
+    sim_assert(CkptGlobals.save_out);
+    ckpt_put_tag(*CkptGlobals.save_out, "End");
+    ckpt_put(*CkptGlobals.save_out, CkptGlobals.save_mem_len);
+    bool ok = !CkptGlobals.save_out->fail();
+    CkptGlobals.save_out->close();
+    delete CkptGlobals.save_out;
+    CkptGlobals.save_out = NULL;
+    if (!ok) {
+        exit_printf("write to checkpoint \"%s\" failed\n",
+                    CkptGlobals.save_name.c_str());
+    }
+    // Extend the image through any trailing holes, so every segment's last
+    // page is backed by the file (see ralloc_map_file()).
+    FILE *mem_out = CkptGlobals.save_mem;
+    CkptGlobals.save_mem = NULL;
+    if (fflush(mem_out) ||
+        ftruncate(fileno(mem_out), off_t(CkptGlobals.save_mem_len)) ||
+        fclose(mem_out)) {
+        exit_printf("write to checkpoint memory image \"%s%s\" failed: "
+                    "%s\n", CkptGlobals.save_name.c_str(), MemImageSuffix,
+                    strerror(errno));
+    }
+    printf("--Checkpoint: wrote %d jobs to \"%s\" (%s-byte memory image)\n",
+           CkptGlobals.n_saved, CkptGlobals.save_name.c_str(),
+           fmt_i64(CkptGlobals.save_mem_len));
+}
+
+
+void
+appckpt_restore_open(const char *filename)
+{
+    sim_assert(!CkptGlobals.restore_records);
+    CkptGlobals.restore_name = filename;
+    gzstream::igzstream in(filename);
+    if (!in.is_open() || !in) {
+        exit_printf("couldn't open checkpoint \"%s\" for reading\n",
+                    filename);
+    }
+    ckpt_expect_tag(in, CkptMagic);
+    i32 version;
+    ckpt_get(in, version, "version");
+    if (version != CkptVersion) {
+        exit_printf("checkpoint \"%s\" is version %d; this simulator reads "
+                    "version %d\n", filename, int(version), int(CkptVersion));
+    }
+
+    RecordMap *records = new RecordMap();
+    string tag;
+    for (;;) {
+        ckpt_get_str(in, tag, "section tag");
+        if (tag != "Job")
+            break;
+        i64 job_id;
+        string workload_path;
+        ckpt_get(in, job_id, "job ID");
+        ckpt_get_str(in, workload_path, "workload path");
+        pair<RecordMap::iterator, bool> ins =
+            records->insert(std::make_pair(RecordKey(job_id, workload_path),
+                                           string()));
+        if (!ins.second) {
+            exit_printf("checkpoint \"%s\": duplicate record for job %s\n",
+                        filename, fmt_i64(job_id));
+        }
+        ckpt_get_str(in, ins.first->second, "job record");
+    }
+    if (tag != "End") {
+        exit_printf("checkpoint format mismatch: expected section \"Job\" "
+                    "or \"End\", found \"%s\"\n", tag.c_str());
+    }
+    ckpt_get(in, CkptGlobals.restore_mem_len, "memory image length");
+
+    string mem_name = string(filename) + MemImageSuffix;
+    int mem_fd = open(mem_name.c_str(), O_RDONLY);
+    struct stat mem_stat;
+    if ((mem_fd < 0) || fstat(mem_fd, &mem_stat)) {
+        exit_printf("couldn't open checkpoint memory image \"%s\" for "
+                    "reading: %s\n", mem_name.c_str(), strerror(errno));
+    }
+    if (i64(mem_stat.st_size) != CkptGlobals.restore_mem_len) {
+        exit_printf("checkpoint memory image \"%s\" is %s bytes; \"%s\" "
+                    "expects %s\n", mem_name.c_str(),
+                    fmt_i64(mem_stat.st_size), filename,
+                    fmt_i64(CkptGlobals.restore_mem_len));
+    }
+    CkptGlobals.restore_mem_fd = mem_fd;
+    CkptGlobals.restore_records = records;
+    printf("--Checkpoint: loaded %d jobs from \"%s\"\n", intsize(*records),
+           filename);
+}
+
+
+int
+appckpt_restore_app(AppState *as, i64 job_id, const char *workload_path,
+                    i64 *ff_dist_ret)
+{
+    if (!CkptGlobals.restore_records)
+        return 0;
+    RecordMap::iterator found =
+        CkptGlobals.restore_records->find(RecordKey(job_id, workload_path));
+    if (found == CkptGlobals.restore_records->end())
+        return 0;
+    string where = string("job ") + fmt_i64(job_id) + " (" + workload_path +
+        ")";
+    {
+        istringstream body(found->second);
+        restore_app_body(body, as, where, ff_dist_ret);
+    }
+    // (each record is used at most once; free its memory now)
+    CkptGlobals.restore_records->erase(found);
+    printf("--Checkpoint: restored A%d from %s at %s insts\n", as->app_id,
+           where.c_str(), fmt_i64(as->stats.total_insts));
+    return 1;
+}
@@ -0,0 +1,57 @@
+//
+// Architectural checkpoints: save the emulation state of fast-forwarded
+// apps to a compressed file, and restore it later in place of
+// fast-forwarding
+//
+
+#ifndef APP_CKPT_H
+#define APP_CKPT_H
+
+
+// Defined elsewhere
+struct AppState;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A checkpoint holds one record per job, keyed by job ID and workload path,
+// with everything AppState emulation depends on: registers and npc, the
+// ProgMem segment map (contents, access/create flags, size limits), loader
+// segment info, instruction/syscall counts, and the SyscallState (see
+// syscalls_ckpt_save()).  The Stash decode cache isn't saved; it refills
+// on demand.
+//
+// Segment contents are kept out of the compressed file, in an uncompressed
+// memory image alongside it ("<filename>.mem"), with each segment starting
+// on a page boundary.  Restoring maps each segment copy-on-write from the
+// image (see pmem_map_file()), so its cost is proportional to the pages
+// actually touched afterward, rather than to the apps' whole footprints.
+// All-zero pages are left as holes in the image.  The two files must be
+// kept together.
+
+// Start saving to "filename" (-ckpt-save): each job's first app is saved as
+// the job finishes fast-forwarding.  appckpt_save_close() finishes the
+// file; jobs not yet started by then are not included.
+void appckpt_save_open(const char *filename);
+int appckpt_saving(void);
+void appckpt_save_app(const struct AppState *as, i64 job_id,
+                      const char *workload_path, i64 ff_dist);
+void appckpt_save_close(void);
+
+// Load the records from "filename" (-ckpt-restore).  Thereafter,
+// appckpt_restore_app() replaces the state of a newly-loaded app with the
+// saved state for its job, if the checkpoint has it, writing the job's
+// fast-forward distance to *ff_dist_ret and returning nonzero.  It returns
+// 0 if there's no checkpoint, or no record for the job.  The job must have
+// the same workload and arguments as when saved.
+void appckpt_restore_open(const char *filename);
+int appckpt_restore_app(struct AppState *as, i64 job_id,
+                        const char *workload_path, i64 *ff_dist_ret);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // APP_CKPT_H
@@ -11,6 +11,7 @@ const char RCSid_1124387573[] =
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <map>
 #include <string>
@@ -43,7 +44,9 @@ enum { AS_cyc, AS_sched_cyc, AS_commits, AS_mem_commits, AS_itlb_hr,
        AS_intalu_acc, AS_fpalu_acc, AS_ldst_acc, AS_iq_acc, 
        AS_fq_acc, AS_ireg_acc, AS_freg_acc, AS_iren_acc, AS_fren_acc, 
        AS_lsq_acc, AS_rob_acc, AS_iq_occ, AS_fq_occ, AS_ireg_occ, 
-       AS_freg_occ, AS_lsq_occ, AS_rob_occ };
+       AS_freg_occ, AS_lsq_occ, AS_rob_occ, AS_icache_energy,
+       AS_dcache_energy, AS_l2cache_energy, AS_l3cache_energy,
+       AS_shadow_caches };
 
 
 struct AppStatsLog {
@@ -58,6 +61,10 @@ protected:
     AppStateExtras *prev_extra; // Copy of last time's as->extra for compare
     AppStateExtras *extra_deltas;
     int out_field;              // Current out field number (for emit_* funcs)
+    // Energy-model totals (nJ) at the last log point, for each cache
+    map<const CacheArray *, double> prev_energy;
+    // Lockstep shadow cache stats at the last log point
+    map<const CacheArray *, CacheStats> prev_shadow_stats;
 
     void read_stat_mask();
     string fmt_stat_mask() const;
@@ -102,6 +109,75 @@ protected:
             fputs(fmt_i64(val), file);
         }
     }
+    // Emits the energy used by a cache since the last log point; the model
+    // reports totals since the last stats reset, so a total which went
+    // backwards is taken to have restarted from zero.
+    void emit_cache_energy_delta(const CacheArray *cache, i64 now_cyc) {
+        CacheEnergyStats es;
+        double total = 0;
+        if (cache && cache_get_energy(cache, now_cyc, &es))
+            total = es.dyn_nj + es.leak_nj;
+        double& prev = prev_energy[cache];
+        if (total < prev)
+            prev = 0;
+        fprintf(file, "%.1f", total - prev);
+        prev = total;
+    }
+    void emit_corecache_energy(int cache_select, i64 now_cyc) {
+        if (out_field > 0) putc(' ', file);
+        out_field++;
+        for (int i = 0; i < CoreCount; i++) {
+            const CacheArray *cache;
+            switch (cache_select) {
+            case 0: cache = Cores[i]->icache; break;
+            case 1: cache = Cores[i]->dcache; break;
+            case 2: cache = Cores[i]->l2cache; break;
+            default:
+                cache = NULL;
+                abort_printf("invalid cache_select %d\n", cache_select);
+            }
+            if (i > 0) putc(',', file);
+            emit_cache_energy_delta(cache, now_cyc);
+        }
+    }
+    // Emits "misses/lookups/nJ" since the last log point for each lockstep
+    // shadow of "cache"; returns the number of shadows emitted, starting
+    // with a ',' separator unless "first_emitted" is 0.
+    int emit_shadow_deltas(const CacheArray *cache, i64 now_cyc,
+                           int first_emitted) {
+        int n_shadows = (cache) ? cache_lockstep_count(cache) : 0;
+        for (int i = 0; i < n_shadows; i++) {
+            const CacheArray *shadow = cache_lockstep_shadow(cache, i);
+            CacheStats cs;
+            cache_get_stats(shadow, &cs);
+            CacheStats& prev = prev_shadow_stats[shadow];
+            if (cs.lookups < prev.lookups)
+                memset(&prev, 0, sizeof(prev));
+            if ((first_emitted + i) > 0) putc(',', file);
+            fputs(fmt_i64(cs.misses - prev.misses), file);
+            putc('/', file);
+            fputs(fmt_i64(cs.lookups - prev.lookups), file);
+            putc('/', file);
+            emit_cache_energy_delta(shadow, now_cyc);
+            prev = cs;
+        }
+        return n_shadows;
+    }
+    void emit_shadow_caches(i64 now_cyc) {
+        if (out_field > 0) putc(' ', file);
+        out_field++;
+        int emitted = 0;
+        for (int i = 0; i < CoreCount; i++) {
+            emitted += emit_shadow_deltas(Cores[i]->icache, now_cyc, emitted);
+            emitted += emit_shadow_deltas(Cores[i]->dcache, now_cyc, emitted);
+            emitted += emit_shadow_deltas(Cores[i]->l2cache, now_cyc,
+                                          emitted);
+        }
+        emitted += emit_shadow_deltas(SharedL2Cache, now_cyc, emitted);
+        emitted += emit_shadow_deltas(SharedL3Cache, now_cyc, emitted);
+        if (!emitted)
+            putc('-', file);
+    }
     void emit_stats(i64 now_cyc);
 
 public:
@@ -287,6 +363,26 @@ AppStatsLog::emit_stats(i64 now_cyc)
         emit_float(1. * extra_deltas->lsq_occ / interval );
     if (GET_BITS_64(stat_mask, AS_rob_occ, 1)) //VK
         emit_float(1. * extra_deltas->rob_occ / interval );
+    if (GET_BITS_64(stat_mask, AS_icache_energy, 1))
+        emit_corecache_energy(0, now_cyc);
+    if (GET_BITS_64(stat_mask, AS_dcache_energy, 1))
+        emit_corecache_energy(1, now_cyc);
+    if (GET_BITS_64(stat_mask, AS_l2cache_energy, 1)) {
+        if (SharedL2Cache) {
+            if (out_field > 0) putc(' ', file);
+            out_field++;
+            emit_cache_energy_delta(SharedL2Cache, now_cyc);
+        } else {
+            emit_corecache_energy(2, now_cyc);
+        }
+    }
+    if (GET_BITS_64(stat_mask, AS_l3cache_energy, 1)) {
+        if (out_field > 0) putc(' ', file);
+        out_field++;
+        emit_cache_energy_delta(SharedL3Cache, now_cyc);
+    }
+    if (GET_BITS_64(stat_mask, AS_shadow_caches, 1))
+        emit_shadow_caches(now_cyc);
     putc('\n', file);
 }
 
@@ -415,6 +511,16 @@ AppStatsLog::read_stat_mask()
     if (simcfg_get_bool((path + "rob_occ").c_str()))
         result |= SET_BIT_64(AS_rob_occ);
     //ENDVK
+    if (simcfg_get_bool((path + "icache_energy").c_str()))
+        result |= SET_BIT_64(AS_icache_energy);
+    if (simcfg_get_bool((path + "dcache_energy").c_str()))
+        result |= SET_BIT_64(AS_dcache_energy);
+    if (simcfg_get_bool((path + "l2cache_energy").c_str()))
+        result |= SET_BIT_64(AS_l2cache_energy);
+    if (simcfg_get_bool((path + "l3cache_energy").c_str()))
+        result |= SET_BIT_64(AS_l3cache_energy);
+    if (simcfg_get_bool((path + "shadow_caches").c_str()))
+        result |= SET_BIT_64(AS_shadow_caches);
     stat_mask = result;
 }
 
@@ -516,6 +622,16 @@ AppStatsLog::fmt_stat_mask() const
         result += "lsq_occ ";
     if (GET_BITS_64(stat_mask, AS_rob_occ, 1)) //VK
         result += "rob_occ ";
+    if (GET_BITS_64(stat_mask, AS_icache_energy, 1))
+        result += "icache_energy ";
+    if (GET_BITS_64(stat_mask, AS_dcache_energy, 1))
+        result += "dcache_energy ";
+    if (GET_BITS_64(stat_mask, AS_l2cache_energy, 1))
+        result += "l2cache_energy ";
+    if (GET_BITS_64(stat_mask, AS_l3cache_energy, 1))
+        result += "l3cache_energy ";
+    if (GET_BITS_64(stat_mask, AS_shadow_caches, 1))
+        result += "shadow_caches ";
     result.erase(result.size() - 1);
     return result;
 }
@@ -12,9 +12,11 @@ const char RCSid_1034960153[] =
 #include <stdlib.h>
 
 #include <algorithm>
+#include <functional>
 #include <limits>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "sim-assert.h"
@@ -26,6 +28,33 @@ const char RCSid_1034960153[] =
 #include "sim-cfg.h"
 #include "prng.h"
 
+// Vector tag matching for ALM_LinearScan: AVX2 or SSE2, when the compiler
+// is targeting them (AVX2 needs e.g. "-mavx2" in OPT_FLAGS), otherwise
+// plain scalar code.  This can be switched off with
+// -DAARRAY_USE_SIMD_TAG_MATCH=0.
+#ifndef AARRAY_USE_SIMD_TAG_MATCH
+    #define AARRAY_USE_SIMD_TAG_MATCH 1
+#endif
+#if AARRAY_USE_SIMD_TAG_MATCH && defined(__AVX2__)
+    #define AARRAY_TAG_MATCH_AVX2 1
+#elif AARRAY_USE_SIMD_TAG_MATCH && defined(__SSE2__)
+    #define AARRAY_TAG_MATCH_SSE2 1
+#endif
+
+#if AARRAY_TAG_MATCH_AVX2
+    #include <immintrin.h>
+#elif AARRAY_TAG_MATCH_SSE2
+    #include <emmintrin.h>
+#endif
+
+// Arrays using plain LRU replacement, with an associativity of 1, 2, 4, 8 or
+// 16, get a FixedLRUArray<> specialized for that associativity, instead of
+// the general lookup/replacement managers.  This can be switched off with
+// -DAARRAY_USE_FIXED_LRU=0.
+#ifndef AARRAY_USE_FIXED_LRU
+    #define AARRAY_USE_FIXED_LRU 1
+#endif
+
 using std::string;
 using std::map;
 using std::vector;
@@ -34,8 +63,13 @@ using std::vector;
 // For arrays with associativity < this threshold, we just do a linear search
 // of ways looking for matches.  For those with associativity >= this
 // threshold, we use some more expensive indexing techniques instead of
-// the linear search.
-#define HIGHLY_ASSOCIATIVE_LOOKUP_THRESHOLD     8
+// the linear search.  (Vector tag matching makes the search cheap enough
+// to use for more ways.)
+#if AARRAY_TAG_MATCH_AVX2 || AARRAY_TAG_MATCH_SSE2
+    #define HIGHLY_ASSOCIATIVE_LOOKUP_THRESHOLD 32
+#else
+    #define HIGHLY_ASSOCIATIVE_LOOKUP_THRESHOLD 8
+#endif
 #define HIGHLY_ASSOCIATIVE_REPLACE_THRESHOLD    32
 
 // If this is true, we'll use the almost-standard "hash_map" container for
@@ -95,6 +129,67 @@ typedef int way_t;
 
 
 
+// Ways are compared in groups of this many; line tag arrays are padded at
+// the end so that a group starting within a line can always be loaded.
+const int WayGroup = 4;
+
+
+// Returns a bitmask of which of the first "n_ways" ways (at most 64) of a
+// line hold "key", given pointers to the line's "lookup" and "match" arrays.
+// Bits for ways past n_ways, up to the next multiple of WayGroup, may be
+// set spuriously; the caller masks them off (with the valid bits).
+inline u64
+match_ways(const u64 *tags, const u32 *ids, int n_ways,
+           const AssocArrayKey& key)
+{
+    u64 hits = 0;
+#if AARRAY_TAG_MATCH_AVX2
+    const __m256i key_lookup =
+        _mm256_set1_epi64x(static_cast<long long>(key.lookup));
+    const __m128i key_match = _mm_set1_epi32(static_cast<int>(key.match));
+    for (int way = 0; way < n_ways; way += WayGroup) {
+        __m256i lookups = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(tags + way));
+        __m128i matches = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(ids + way));
+        int lookup_eq = _mm256_movemask_pd(_mm256_castsi256_pd(
+            _mm256_cmpeq_epi64(lookups, key_lookup)));
+        int match_eq = _mm_movemask_ps(_mm_castsi128_ps(
+            _mm_cmpeq_epi32(matches, key_match)));
+        hits |= static_cast<u64>(lookup_eq & match_eq) << way;
+    }
+#elif AARRAY_TAG_MATCH_SSE2
+    // (SSE2 has no 64-bit compare: a 64-bit lane matches iff both of its
+    // 32-bit halves do)
+    const __m128i key_lookup =
+        _mm_set1_epi64x(static_cast<long long>(key.lookup));
+    const __m128i key_match = _mm_set1_epi32(static_cast<int>(key.match));
+    for (int way = 0; way < n_ways; way += WayGroup) {
+        __m128i eq01 = _mm_cmpeq_epi32(key_lookup, _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(tags + way)));
+        __m128i eq23 = _mm_cmpeq_epi32(key_lookup, _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(tags + way + 2)));
+        eq01 = _mm_and_si128(eq01, _mm_shuffle_epi32(eq01,
+                                                     _MM_SHUFFLE(2, 3, 0, 1)));
+        eq23 = _mm_and_si128(eq23, _mm_shuffle_epi32(eq23,
+                                                     _MM_SHUFFLE(2, 3, 0, 1)));
+        int lookup_eq = _mm_movemask_pd(_mm_castsi128_pd(eq01)) |
+            (_mm_movemask_pd(_mm_castsi128_pd(eq23)) << 2);
+        int match_eq = _mm_movemask_ps(_mm_castsi128_ps(
+            _mm_cmpeq_epi32(key_match, _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(ids + way)))));
+        hits |= static_cast<u64>(lookup_eq & match_eq) << way;
+    }
+#else
+    for (int way = 0; way < n_ways; way++) {
+        if ((tags[way] == key.lookup) && (ids[way] == key.match))
+            hits |= SET_BIT_64(way);
+    }
+#endif
+    return hits;
+}
+
+
 //
 // Array lookup manager: this is an abstract class that takes care of
 // searching an array line for a given key.
@@ -103,39 +198,70 @@ typedef int way_t;
 //  lookup() -- determine which way a given key is stored at, if any
 //  replace() -- overwrite the given way with a new key
 //
+// Entries are stored structure-of-arrays style: the "lookup" and "match"
+// key fields each have an [n_lines][assoc] array, and each line has a
+// bitmask of valid ways.
+//
 
 class ArrayLookupMgr {
 protected:
-    struct ArrayEntry {
-        AssocArrayKey key;
-        bool valid;
-    };
-
     long n_lines;
     int assoc;
-    ArrayEntry *all_entries;
+    int valid_words;            // u64s of valid bits per line
+    u64 *lookup_tags;           // [n_lines * assoc + (WayGroup - 1)]
+    u32 *match_ids;             // [n_lines * assoc + (WayGroup - 1)]
+    u64 *valid_bits;            // [n_lines][valid_words]
+
+    bool ent_valid(long line, int way) const {
+        return (valid_bits[line * valid_words + (way / 64)] >>
+                (way % 64)) & 1;
+    }
+    AssocArrayKey ent_key(long line, int way) const {
+        AssocArrayKey key;
+        key.lookup = lookup_tags[line * assoc + way];
+        key.match = match_ids[line * assoc + way];
+        return key;
+    }
+    void set_ent(long line, int way, const AssocArrayKey& key) {
+        lookup_tags[line * assoc + way] = key.lookup;
+        match_ids[line * assoc + way] = key.match;
+        valid_bits[line * valid_words + (way / 64)] |= SET_BIT_64(way % 64);
+    }
+    void clear_ent(long line, int way) {
+        valid_bits[line * valid_words + (way / 64)] &= ~SET_BIT_64(way % 64);
+    }
 
     void base_reset() {
-        for (long i = 0; i < (n_lines * assoc); i++)
-            all_entries[i].valid = false;
+        // (The tags are cleared too, so that the padding is never garbage)
+        for (long i = 0; i < ((n_lines * assoc) + (WayGroup - 1)); i++) {
+            lookup_tags[i] = 0;
+            match_ids[i] = 0;
+        }
+        for (long i = 0; i < (n_lines * valid_words); i++)
+            valid_bits[i] = 0;
     }
 
 public:
     ArrayLookupMgr(long num_lines, int associativity) 
-        : n_lines(num_lines), assoc(associativity), all_entries(0) { 
-        all_entries = new ArrayEntry[n_lines * assoc];
+        : n_lines(num_lines), assoc(associativity),
+          valid_words((associativity + 63) / 64),
+          lookup_tags(0), match_ids(0), valid_bits(0) { 
+        lookup_tags = new u64[(n_lines * assoc) + (WayGroup - 1)];
+        match_ids = new u32[(n_lines * assoc) + (WayGroup - 1)];
+        valid_bits = new u64[n_lines * valid_words];
     }
 
     virtual ~ArrayLookupMgr() {
-        if (all_entries)
-            delete[] all_entries;       
+        delete[] lookup_tags;
+        delete[] match_ids;
+        delete[] valid_bits;
     }
 
     bool read_key(long line, int way, AssocArrayKey *key_ret) const {
-        const ArrayEntry& ent = all_entries[line * assoc + way];
-        if (ent.valid && key_ret)
-            *key_ret = ent.key;
-        return ent.valid;
+        bool valid = ent_valid(line, way);
+        if (valid && key_ret)
+            *key_ret = ent_key(line, way);
+        return valid;
     }
 
     virtual void reset() = 0;
@@ -151,7 +277,7 @@ public:
 
 //
 // Linear-scan lookup: this is very simple, it just searches all ways
-// of a line for a match.
+// of a line for a match, WayGroup at a time (see match_ways()).
 //
 // lookup() cost is O(assoc), replace() cost is O(1).
 //
@@ -167,28 +293,25 @@ public:
     }
 
     int lookup(long line, const AssocArrayKey& key) const {
-        int found = -1;
-        const ArrayEntry *ent = all_entries + line * assoc;
-        for (int way = 0; way < assoc; way++, ent++) {
-            if (ent->valid && 
-                (ent->key.lookup == key.lookup) &&
-                (ent->key.match == key.match)) {
-                found = way;
-                break;
-            }
+        const u64 *tags = lookup_tags + line * assoc;
+        const u32 *ids = match_ids + line * assoc;
+        const u64 *valid = valid_bits + line * valid_words;
+        for (int first_way = 0; first_way < assoc; first_way += 64) {
+            u64 hits = valid[first_way / 64] &
+                match_ways(tags + first_way, ids + first_way,
+                           MIN_SCALAR(assoc - first_way, 64), key);
+            if (hits)
+                return first_way + LOWEST_BIT_64(hits);
         }
-        return found;
+        return -1;
     }
 
     void replace(long line, int way, const AssocArrayKey& key) {
-        ArrayEntry& ent = all_entries[line * assoc + way];
-        ent.key = key;
-        ent.valid = true;
+        set_ent(line, way, key);
     }
 
     void inval(long line, int way) {
-        ArrayEntry& ent = all_entries[line * assoc + way];
-        ent.valid = false;
+        clear_ent(line, way);
     }
 };
 
@@ -231,19 +354,16 @@ public:
     }
 
     void replace(long line, int way, const AssocArrayKey& key) {
-        ArrayEntry& ent = all_entries[line * assoc + way];
-        if (ent.valid)
-            way_lookups[line].erase(ent.key);
+        if (ent_valid(line, way))
+            way_lookups[line].erase(ent_key(line, way));
         way_lookups[line][key] = static_cast<way_t>(way);
-        ent.key = key;
-        ent.valid = true;
+        set_ent(line, way, key);
     }
 
     void inval(long line, int way) {
-        ArrayEntry& ent = all_entries[line * assoc + way];
-        if (ent.valid) {
-            way_lookups[line].erase(ent.key);
-            ent.valid = false;
+        if (ent_valid(line, way)) {
+            way_lookups[line].erase(ent_key(line, way));
+            clear_ent(line, way);
         }
     }
 };
@@ -284,19 +404,16 @@ public:
     }
 
     void replace(long line, int way, const AssocArrayKey& key) {
-        ArrayEntry& ent = all_entries[line * assoc + way];
-        if (ent.valid)
-            way_lookup.erase(ent.key);
+        if (ent_valid(line, way))
+            way_lookup.erase(ent_key(line, way));
         way_lookup[key] = static_cast<way_t>(way);
-        ent.key = key;
-        ent.valid = true;
+        set_ent(line, way, key);
     }
 
     void inval(long line, int way) {
-        ArrayEntry& ent = all_entries[line * assoc + way];
-        if (ent.valid) {
-            way_lookup.erase(ent.key);
-            ent.valid = false;
+        if (ent_valid(line, way)) {
+            way_lookup.erase(ent_key(line, way));
+            clear_ent(line, way);
         }
     }
 };
@@ -318,14 +435,23 @@ class ArrayReplacementMgr {
 protected:
     long n_lines;
     int assoc;
+    // Ways which evict_select() may choose: [assoc] flags, or NULL when
+    // every way is enabled (the common case, which skips the checks).
+    const bool *way_enabled;
 
 public:
     ArrayReplacementMgr(long num_lines, int associativity)
-        : n_lines(num_lines), assoc(associativity) { }
+        : n_lines(num_lines), assoc(associativity), way_enabled(0) { }
     ArrayReplacementMgr(const ArrayReplacementMgr& copy) 
-        : n_lines(copy.n_lines), assoc(copy.assoc) { }
+        : n_lines(copy.n_lines), assoc(copy.assoc),
+          way_enabled(copy.way_enabled) { }
     virtual ~ArrayReplacementMgr() { }
 
+    // The flags array is owned by the caller, and must outlive its use here
+    virtual void set_way_mask(const bool *way_enabled_) {
+        way_enabled = way_enabled_;
+    }
+
     virtual void reset() = 0;
 
     virtual void touch(long line, int way) = 0;
@@ -337,6 +463,10 @@ public:
     virtual int evict_select(long line) const = 0;
 
     virtual void inval(long line, int way) = 0;
+
+    // Writes all "assoc" way numbers of a line to ways_ret[], ordered from
+    // most- to least-recently used; invalidated ways come last.
+    virtual void recency_order(long line, int *ways_ret) const = 0;
 };
 
 
@@ -374,9 +504,64 @@ public:
     { return underlying->evict_select(line); }
     virtual void inval(long line, int way)
     { underlying->inval(line, way); }
+    virtual void recency_order(long line, int *ways_ret) const
+    { underlying->recency_order(line, ways_ret); }
+    virtual void set_way_mask(const bool *way_enabled_) {
+        ArrayReplacementMgr::set_way_mask(way_enabled_);
+        underlying->set_way_mask(way_enabled_);
+    }
 };
 
 
+// Helper for the clock-based LRU managers: sort way numbers by descending
+// timestamp.  Invalid ways have negative timestamps, so they sort last.
+template <typename ClockType>
+void
+ways_by_clock(const ClockType *way_clocks, int assoc, int *ways_ret)
+{
+    vector<std::pair<ClockType, int> > times;
+    times.reserve(assoc);
+    for (int way = 0; way < assoc; way++)
+        times.push_back(std::make_pair(way_clocks[way], way));
+    std::stable_sort(times.begin(), times.end(), 
+                     std::greater<std::pair<ClockType, int> >());
+    for (int i = 0; i < assoc; i++)
+        ways_ret[i] = times[i].second;
+}
+
+
+// Helper for the clock-based LRU managers: select the way with the minimum
+// timestamp.  Invalid ways have negative timestamps, so they "win" LRU.
+// Disabled ways (per way_enabled[], if non-NULL) are never selected.
+template <typename ClockType>
+int
+lru_by_clock(const ClockType *way_clocks, int assoc, const bool *way_enabled)
+{
+    int lru_way = 0;
+    if (!way_enabled) {
+        ClockType lru_time = way_clocks[0];
+        for (int way = 1; way < assoc; way++) {
+            if (way_clocks[way] < lru_time) {
+                lru_way = way;
+                lru_time = way_clocks[way];
+            }
+        }
+    } else {
+        ClockType lru_time = 0;
+        lru_way = -1;
+        for (int way = 0; way < assoc; way++) {
+            if (way_enabled[way] &&
+                ((lru_way < 0) || (way_clocks[way] < lru_time))) {
+                lru_way = way;
+                lru_time = way_clocks[way];
+            }
+        }
+        sim_assert(lru_way >= 0);
+    }
+    return lru_way;
+}
+
+
 //
 // LRU replacement with an array-wide transaction clock: this maintains a
 // single array-wide transaction clock, and tags each way with values from
@@ -418,23 +603,16 @@ public:
 
     int evict_select(long line) const
     {
-        trans_clock *way_clocks = ent_clocks + line * assoc;
-        int lru_way = 0;
-        trans_clock lru_time = way_clocks[0];
-        for (int way = 1; way < assoc; way++) {
-            if (way_clocks[way] < lru_time) {
-                /* Note: time is -1 for invalid blocks, so they "win" LRU */
-                lru_way = way;
-                lru_time = way_clocks[way];
-            }
-        }
-
-        return lru_way;
+        return lru_by_clock(ent_clocks + line * assoc, assoc, way_enabled);
     }
 
     void inval(long line, int way) {
         ent_clocks[line * assoc + way] = -1;
     }
+
+    void recency_order(long line, int *ways_ret) const {
+        ways_by_clock(ent_clocks + line * assoc, assoc, ways_ret);
+    }
 };
 
 
@@ -497,24 +675,18 @@ public:
 
     int evict_select(long line) const
     {
-        line_trans_clock *way_clocks = all_clocks + line * (1 + assoc) + 1;
-        int lru_way = 0;
-        line_trans_clock lru_time = way_clocks[0];
-        for (int way = 1; way < assoc; way++) {
-            if (way_clocks[way] < lru_time) {
-                /* Note: time is -1 for invalid blocks, so they "win" LRU */
-                lru_way = way;
-                lru_time = way_clocks[way];
-            }
-        }
-
-        return lru_way;
+        return lru_by_clock(all_clocks + line * (1 + assoc) + 1, assoc,
+                            way_enabled);
     }
 
     void inval(long line, int way) {
         line_trans_clock *way_clocks = all_clocks + line * (1 + assoc) + 1;
         way_clocks[way] = -1;
     }
+
+    void recency_order(long line, int *ways_ret) const {
+        ways_by_clock(all_clocks + line * (1 + assoc) + 1, assoc, ways_ret);
+    }
 };
 
 
@@ -645,8 +817,16 @@ public:
 
     int evict_select(long line) const
     {
-        const WayOrder& header = line_order[line * (assoc + 1)];
-        int lru_way = header.prev - 1;
+        const WayOrder *way_order = line_order + line * (assoc + 1);
+        int way_idx = way_order[0].prev;
+        if (way_enabled) {
+            // Disabled ways are invalid, so they collect at the rear
+            while (!way_enabled[way_idx - 1]) {
+                way_idx = way_order[way_idx].prev;
+                sim_assert(way_idx != 0);
+            }
+        }
+        int lru_way = way_idx - 1;
         return lru_way;
     }
 
@@ -668,6 +848,17 @@ public:
             way_order[0].prev = way_idx;
         }
     }
+
+    void recency_order(long line, int *ways_ret) const {
+        // Invalidated ways are already moved to the rear of the list
+        const WayOrder *way_order = line_order + line * (assoc + 1);
+        int way_idx = way_order[0].next;
+        for (int i = 0; i < assoc; i++) {
+            sim_assert(way_idx != 0);
+            ways_ret[i] = way_idx - 1;
+            way_idx = way_order[way_idx].next;
+        }
+    }
 };
 
 
@@ -826,6 +1017,9 @@ protected:
     int assoc;
     AAReplacePolicy replace_policy;
     string cfg_base;            // Either empty, or has a trailing slash
+    // Associativity of the FixedLRUArray<> this actually is, or 0 if this
+    // uses the lookup/replacement managers
+    int fixed_lru_assoc;
 
     int n_lines_lg;
     long total_entries;
@@ -833,13 +1027,36 @@ protected:
     ArrayLookupMgr *lookup_mgr;
     ArrayReplacementMgr *replace_mgr;
 
+    // Way-gating: disabled ways hold no entries, and are never selected
+    // for replacement.
+    bool *way_enabled;                  // [assoc]
+    int n_ways_enabled;
+
+    // Set-resizing: only the first "active_lines" of the n_lines physical
+    // lines are indexed.  While a resize is in progress, "line pairs" --
+    // the physical lines with equal index bits under the smaller of the old
+    // and new line counts -- are switched to the new indexing one at a time,
+    // in order; pairs below resize_cursor use the new mask.
+    long active_lines;
+    long index_mask;                    // active_lines - 1
+    bool resizing;
+    long resize_target_lines;
+    long resize_pair_mask;              // min(active, target) - 1
+    long resize_cursor;                 // #pairs switched so far
+
     inline bool lineway_invar(long line_num, int way_num) const {
         return ((line_num >= 0) && (line_num < n_lines)) &&
             ((way_num >= 0) && (way_num < assoc));
     }
 
     inline long select_line(const AssocArrayKey& key) const {
-        return static_cast<long>(key.lookup & (n_lines - 1));
+        if (SP_F(resizing)) {
+            long pair_idx = static_cast<long>(key.lookup & resize_pair_mask);
+            long mask = (pair_idx < resize_cursor) ?
+                (resize_target_lines - 1) : index_mask;
+            return static_cast<long>(key.lookup & mask);
+        }
+        return static_cast<long>(key.lookup & index_mask);
     }
 
 private:
@@ -849,15 +1066,18 @@ private:
 
 public:
     AssocArray(long n_lines_, int assoc_, AAReplacePolicy replace_policy_,
-               const string& cfg_base_);
-    ~AssocArray();
+               const string& cfg_base_, int fixed_lru_assoc_);
+    virtual ~AssocArray();
     void reset();
 
+    int fixed_lru_ways() const { return fixed_lru_assoc; }
+
     inline int lookup(const AssocArrayKey& key, long *line_num_ret, 
                       int *way_num_ret) {
         long line_num = select_line(key);
         int found_way = lookup_mgr->lookup(line_num, key);
         if (found_way >= 0) {
+            sim_assert(way_enabled[found_way]);
             replace_mgr->touch(line_num, found_way);
             *line_num_ret = line_num;
             *way_num_ret = found_way;
@@ -882,6 +1102,7 @@ public:
         sim_assert(lookup_mgr->lookup(line_num, key) == -1);
         int way_num = replace_mgr->evict_select(line_num);
         sim_assert(lineway_invar(line_num, way_num));
+        sim_assert(way_enabled[way_num]);
         bool old_key_valid = lookup_mgr->read_key(line_num, way_num, 
                                                   old_key_ret);
         lookup_mgr->replace(line_num, way_num, key);
@@ -907,15 +1128,35 @@ public:
         sim_assert(lineway_invar(line_num, way_num));
         return lookup_mgr->read_key(line_num, way_num, key_ret);
     }
+
+    void recency_order(long line_num, int *ways_ret) const {
+        sim_assert(lineway_invar(line_num, 0));
+        replace_mgr->recency_order(line_num, ways_ret);
+    }
+
+    void set_way_enabled(int way_num, bool enable);
+    bool is_way_enabled(int way_num) const {
+        sim_assert(lineway_invar(0, way_num));
+        return way_enabled[way_num];
+    }
+    int ways_enabled() const { return n_ways_enabled; }
+
+    long get_active_lines() const { return active_lines; }
+    bool is_resizing() const { return resizing; }
+    void resize_begin(long new_active_lines);
+    bool resize_next_pair(long *line_a_ret, long *line_b_ret) const;
+    void resize_pair_done();
 };
 
 
 AssocArray::AssocArray(long n_lines_, int assoc_,
                        AAReplacePolicy replace_policy_,
-                       const string& cfg_base_)
+                       const string& cfg_base_, int fixed_lru_assoc_)
     : n_lines(n_lines_), assoc(assoc_), replace_policy(replace_policy_),
-      cfg_base(cfg_base_),
-      lookup_mgr(0), replace_mgr(0)
+      cfg_base(cfg_base_), fixed_lru_assoc(fixed_lru_assoc_),
+      lookup_mgr(0), replace_mgr(0), way_enabled(0), n_ways_enabled(0),
+      active_lines(n_lines_), index_mask(n_lines_ - 1), resizing(false),
+      resize_target_lines(0), resize_pair_mask(0), resize_cursor(0)
 {
     const char *fname = "AssocArray::AssocArray";
 
@@ -934,6 +1175,18 @@ AssocArray::AssocArray(long n_lines_, int assoc_,
 
     total_entries = n_lines * assoc;
 
+    way_enabled = new bool[assoc];
+    for (int way = 0; way < assoc; way++)
+        way_enabled[way] = true;
+    n_ways_enabled = assoc;
+
+    if (fixed_lru_assoc) {
+        // (The FixedLRUArray<> constructor does the rest, including reset)
+        sim_assert(fixed_lru_assoc == assoc);
+        sim_assert(replace_policy == AARP_LRU);
+        return;
+    }
+
     if (assoc < HIGHLY_ASSOCIATIVE_LOOKUP_THRESHOLD) {
         lookup_mgr = new ALM_LinearScan(n_lines, assoc);
     } else {
@@ -1003,17 +1256,421 @@ AssocArray::~AssocArray()
         delete lookup_mgr;
     if (replace_mgr)
         delete replace_mgr;
+    if (way_enabled)
+        delete[] way_enabled;
+}
+
+
+void
+AssocArray::set_way_enabled(int way_num, bool enable)
+{
+    sim_assert(lineway_invar(0, way_num));
+    if (enable == way_enabled[way_num])
+        return;
+    if (!enable) {
+        if (n_ways_enabled <= 1) {
+            abort_printf("AssocArray: can't disable way %d, it's the only "
+                         "one left\n", way_num);
+        }
+        // (via aarray_invalidate(), in case this is a FixedLRUArray<>)
+        for (long line_num = 0; line_num < n_lines; line_num++)
+            aarray_invalidate(this, line_num, way_num);
+        n_ways_enabled--;
+    } else {
+        n_ways_enabled++;
+    }
+    way_enabled[way_num] = enable;
+    // Keep the replacement manager on the unchecked fast path when possible.
+    // (FixedLRUArray<> has no manager; it checks way_enabled[] itself.)
+    if (replace_mgr)
+        replace_mgr->set_way_mask((n_ways_enabled < assoc) ? way_enabled : 0);
+}
+
+
+void
+AssocArray::resize_begin(long new_active_lines)
+{
+    if (resizing) {
+        abort_printf("AssocArray: resize to %li lines requested while "
+                     "already resizing to %li\n", new_active_lines,
+                     resize_target_lines);
+    }
+    if ((new_active_lines != (active_lines / 2)) &&
+        (new_active_lines != (active_lines * 2))) {
+        abort_printf("AssocArray: resize from %li to %li lines; only "
+                     "halving or doubling is supported\n", active_lines,
+                     new_active_lines);
+    }
+    if ((new_active_lines < 1) || (new_active_lines > n_lines)) {
+        abort_printf("AssocArray: resize to %li lines out of range; "
+                     "%li lines physically present\n", new_active_lines,
+                     n_lines);
+    }
+    resizing = true;
+    resize_target_lines = new_active_lines;
+    resize_pair_mask = MIN_SCALAR(active_lines, new_active_lines) - 1;
+    resize_cursor = 0;
+}
+
+
+// Writes the physical line numbers of the next pair to be switched over;
+// returns false if no resize is in progress.  Both lines are part of the
+// pair; the "b" line is outside the smaller of the old/new index ranges.
+bool
+AssocArray::resize_next_pair(long *line_a_ret, long *line_b_ret) const
+{
+    if (!resizing)
+        return false;
+    *line_a_ret = resize_cursor;
+    *line_b_ret = resize_cursor + resize_pair_mask + 1;
+    return true;
+}
+
+
+// Switch the next pair to the new indexing.  The caller must have already
+// invalidated every entry on both of its lines.
+void
+AssocArray::resize_pair_done()
+{
+    sim_assert(resizing);
+#ifdef DEBUG
+    {
+        long line_a = 0, line_b = 0;
+        resize_next_pair(&line_a, &line_b);
+        for (int way = 0; way < assoc; way++) {
+            sim_assert(!aarray_readkey(this, line_a, way, NULL));
+            sim_assert(!aarray_readkey(this, line_b, way, NULL));
+        }
+    }
+#endif
+    resize_cursor++;
+    if (resize_cursor > resize_pair_mask) {
+        active_lines = resize_target_lines;
+        index_mask = active_lines - 1;
+        resizing = false;
+        resize_target_lines = 0;
+        resize_pair_mask = 0;
+        resize_cursor = 0;
+    }
 }
 
 
 void
 AssocArray::reset()
 {
+    // (The active line count, and any resize in progress, are preserved;
+    // with the array empty, the remaining pairs are trivially switched.)
     lookup_mgr->reset();
     replace_mgr->reset();
 }
 
 
+namespace {
+
+//
+// LRU arrays specialized at compile time for a given (small, power-of-two)
+// associativity: this does the work of ALM_LinearScan and
+// ARM_LRU_PerLineClock, with the same results, but with no virtual calls,
+// and with the per-way loops unrolled.
+//
+// Each line's entries are stored together, along with a bitmask of valid
+// ways and a "recency stack": the line's way numbers, packed WayBits apiece
+// into one integer, from MRU (low bits) to LRU.  Touching a way moves it
+// to slot 0.  Invalid ways keep their places in the stack, but are
+// skipped over: replacement picks the lowest-numbered invalid way, if any,
+// and only then the LRU way, just like the clock-based managers do.  (One
+// difference: touching an invalid entry doesn't make it any less preferred
+// for replacement, here; callers only touch entries they've just found.)
+//
+
+template <int Assoc> struct FixedLRUTraits { };
+// (SlotOnes and SlotHighs have the bottom and top bits of each WayBits-wide
+// slot set)
+template <> struct FixedLRUTraits<1> {
+    typedef u8 Stack;
+    static const int WayBits = 0;
+    static const u64 SlotOnes = 0;
+    static const u64 SlotHighs = 0;
+};
+template <> struct FixedLRUTraits<2> {
+    typedef u8 Stack;
+    static const int WayBits = 1;
+    static const u64 SlotOnes = 0x3;
+    static const u64 SlotHighs = 0x3;
+};
+template <> struct FixedLRUTraits<4> {
+    typedef u8 Stack;
+    static const int WayBits = 2;
+    static const u64 SlotOnes = 0x55;
+    static const u64 SlotHighs = 0xaa;
+};
+template <> struct FixedLRUTraits<8> {
+    typedef u32 Stack;
+    static const int WayBits = 3;
+    static const u64 SlotOnes = 0x249249;
+    static const u64 SlotHighs = 0x924924;
+};
+template <> struct FixedLRUTraits<16> {
+    typedef u64 Stack;
+    static const int WayBits = 4;
+    static const u64 SlotOnes = U64_LIT(0x1111111111111111);
+    static const u64 SlotHighs = U64_LIT(0x8888888888888888);
+};
+
+
+template <int Assoc>
+class FixedLRUArray : public AssocArray {
+    typedef FixedLRUTraits<Assoc> Traits;
+    typedef typename Traits::Stack Stack;
+    static const int WayBits = Traits::WayBits;
+    static const u64 WayMask = (U64_LIT(1) << WayBits) - 1;
+    static const u64 AllWays = (U64_LIT(1) << Assoc) - 1;
+
+    struct Line {
+        u64 tags[Assoc];
+        u32 ids[Assoc];
+        Stack stack;
+        u32 valid;
+    };
+
+    Line *lines;                        // [n_lines]
+
+    // Mask of the bits for stack slots [0, n_slots)
+    static u64 slots_below(int n_slots) {
+        return ((n_slots * WayBits) >= 64) ? ~U64_LIT(0) :
+            (U64_LIT(1) << (n_slots * WayBits)) - 1;
+    }
+
+    static int stack_way(u64 stack, int slot) {
+        return static_cast<int>((stack >> (slot * WayBits)) & WayMask);
+    }
+
+    // Returns the stack slot holding "way": the lowest slot which is zero
+    // after XORing with "way" in every slot.  (A borrow can only falsely
+    // flag slots above the lowest zero one.)
+    static int stack_slot(u64 stack, int way) {
+        if (WayBits == 1)
+            return static_cast<int>((stack & 1) != static_cast<u64>(way));
+        const u64 x = stack ^ (static_cast<u64>(way) * Traits::SlotOnes);
+        const u64 zero_slots = (x - Traits::SlotOnes) & ~x &
+            Traits::SlotHighs;
+        sim_assert(zero_slots != 0);
+        return LOWEST_BIT_64(zero_slots) / WayBits;
+    }
+
+    static void promote(Line& ln, int way) {
+        if (Assoc == 1)
+            return;
+        const u64 stack = ln.stack;
+        const int slot = stack_slot(stack, way);
+        if (slot == 0)
+            return;
+        const u64 below = slots_below(slot);
+        ln.stack = static_cast<Stack>((stack & ~slots_below(slot + 1)) |
+                                      ((stack & below) << WayBits) |
+                                      static_cast<u64>(way));
+    }
+
+    static int find(const Line& ln, const AssocArrayKey& key) {
+        u64 hits = 0;
+        if (Assoc >= WayGroup) {
+            hits = match_ways(ln.tags, ln.ids, Assoc, key);
+        } else {
+            for (int way = 0; way < Assoc; way++) {
+                hits |= static_cast<u64>((ln.tags[way] == key.lookup) &
+                                         (ln.ids[way] == key.match)) << way;
+            }
+        }
+        hits &= ln.valid;
+        return (hits) ? LOWEST_BIT_64(hits) : -1;
+    }
+
+    int evict_select(const Line& ln) const {
+        u64 enabled = AllWays;
+        if (SP_F(n_ways_enabled < Assoc)) {
+            enabled = 0;
+            for (int way = 0; way < Assoc; way++) {
+                if (way_enabled[way])
+                    enabled |= SET_BIT_64(way);
+            }
+        }
+        const u64 empty = enabled & ~static_cast<u64>(ln.valid);
+        if (empty)
+            return LOWEST_BIT_64(empty);
+        if (SP_T(enabled == AllWays))
+            return stack_way(ln.stack, Assoc - 1);
+        for (int slot = Assoc - 1; slot >= 0; slot--) {
+            int way = stack_way(ln.stack, slot);
+            if ((enabled >> way) & 1)
+                return way;
+        }
+        abort_printf("FixedLRUArray: no enabled way to replace\n");
+        return -1;
+    }
+
+public:
+    FixedLRUArray(long n_lines_, const string& cfg_base_)
+        : AssocArray(n_lines_, Assoc, AARP_LRU, cfg_base_, Assoc),
+          lines(0) {
+        lines = new Line[n_lines];
+        this->reset();
+    }
+
+    ~FixedLRUArray() {
+        delete[] lines;
+    }
+
+    void reset() {
+        u64 identity = 0;
+        for (int slot = 0; slot < Assoc; slot++)
+            identity |= static_cast<u64>(slot) << (slot * WayBits);
+        for (long line_num = 0; line_num < n_lines; line_num++) {
+            Line& ln = lines[line_num];
+            for (int way = 0; way < Assoc; way++) {
+                ln.tags[way] = 0;
+                ln.ids[way] = 0;
+            }
+            ln.stack = static_cast<Stack>(identity);
+            ln.valid = 0;
+        }
+    }
+
+    int lookup(const AssocArrayKey& key, long *line_num_ret,
+               int *way_num_ret) {
+        long line_num = select_line(key);
+        Line& ln = lines[line_num];
+        int found_way = find(ln, key);
+        if (found_way >= 0) {
+            sim_assert(way_enabled[found_way]);
+            promote(ln, found_way);
+            *line_num_ret = line_num;
+            *way_num_ret = found_way;
+        }
+        return (found_way >= 0);
+    }
+
+    bool probe(const AssocArrayKey& key, long *line_num_ret,
+               int *way_num_ret) const {
+        long line_num = select_line(key);
+        int found_way = find(lines[line_num], key);
+        if (found_way >= 0) {
+            *line_num_ret = line_num;
+            *way_num_ret = found_way;
+        }
+        return (found_way >= 0);
+    }
+
+    bool replace(const AssocArrayKey& key, long *line_num_ret,
+                 int *way_num_ret, AssocArrayKey *old_key_ret) {
+        long line_num = select_line(key);
+        Line& ln = lines[line_num];
+        sim_assert(find(ln, key) == -1);
+        int way_num = evict_select(ln);
+        sim_assert(lineway_invar(line_num, way_num));
+        sim_assert(way_enabled[way_num]);
+        bool old_key_valid = (ln.valid >> way_num) & 1;
+        if (old_key_valid && old_key_ret) {
+            old_key_ret->lookup = ln.tags[way_num];
+            old_key_ret->match = ln.ids[way_num];
+        }
+        ln.tags[way_num] = key.lookup;
+        ln.ids[way_num] = key.match;
+        ln.valid |= static_cast<u32>(SET_BIT_64(way_num));
+        promote(ln, way_num);
+        *line_num_ret = line_num;
+        *way_num_ret = way_num;
+        return old_key_valid;
+    }
+
+    void invalidate(long line_num, int way_num) {
+        sim_assert(lineway_invar(line_num, way_num));
+        lines[line_num].valid &= static_cast<u32>(~SET_BIT_64(way_num));
+    }
+
+    void touch(long line_num, int way_num) {
+        sim_assert(lineway_invar(line_num, way_num));
+        promote(lines[line_num], way_num);
+    }
+
+    bool readkey(long line_num, int way_num, AssocArrayKey *key_ret) const {
+        sim_assert(lineway_invar(line_num, way_num));
+        const Line& ln = lines[line_num];
+        bool valid = (ln.valid >> way_num) & 1;
+        if (valid && key_ret) {
+            key_ret->lookup = ln.tags[way_num];
+            key_ret->match = ln.ids[way_num];
+        }
+        return valid;
+    }
+
+    void recency_order(long line_num, int *ways_ret) const {
+        sim_assert(lineway_invar(line_num, 0));
+        const Line& ln = lines[line_num];
+        int n_out = 0;
+        for (int slot = 0; slot < Assoc; slot++) {
+            int way = stack_way(ln.stack, slot);
+            if ((ln.valid >> way) & 1)
+                ways_ret[n_out++] = way;
+        }
+        // (Invalid ways go in descending order, as ways_by_clock() has them)
+        for (int way = Assoc - 1; way >= 0; way--) {
+            if (!((ln.valid >> way) & 1))
+                ways_ret[n_out++] = way;
+        }
+        sim_assert(n_out == Assoc);
+    }
+};
+
+
+template <int Assoc>
+inline FixedLRUArray<Assoc> *
+as_fixed_lru(AssocArray *array)
+{
+    return static_cast<FixedLRUArray<Assoc> *>(array);
+}
+
+template <int Assoc>
+inline const FixedLRUArray<Assoc> *
+as_fixed_lru(const AssocArray *array)
+{
+    return static_cast<const FixedLRUArray<Assoc> *>(array);
+}
+
+
+// Makes the given method call on "array" as whichever class it actually
+// is, returning the result.  (This is a switch rather than a virtual call,
+// so that the FixedLRUArray<> methods can be inlined.)
+#define AARRAY_DISPATCH(array, call)                                    \
+    switch ((array)->fixed_lru_ways()) {                                \
+    case 1: return as_fixed_lru<1>(array)->call;                        \
+    case 2: return as_fixed_lru<2>(array)->call;                        \
+    case 4: return as_fixed_lru<4>(array)->call;                        \
+    case 8: return as_fixed_lru<8>(array)->call;                        \
+    case 16: return as_fixed_lru<16>(array)->call;                      \
+    default: return (array)->call;                                      \
+    }
+
+
+AssocArray *
+new_assoc_array(long n_lines, int assoc, AAReplacePolicy replace_policy,
+                const string& cfg_base)
+{
+    if (AARRAY_USE_FIXED_LRU && (replace_policy == AARP_LRU)) {
+        switch (assoc) {
+        case 1: return new FixedLRUArray<1>(n_lines, cfg_base);
+        case 2: return new FixedLRUArray<2>(n_lines, cfg_base);
+        case 4: return new FixedLRUArray<4>(n_lines, cfg_base);
+        case 8: return new FixedLRUArray<8>(n_lines, cfg_base);
+        case 16: return new FixedLRUArray<16>(n_lines, cfg_base);
+        default: break;
+        }
+    }
+    return new AssocArray(n_lines, assoc, replace_policy, cfg_base, 0);
+}
+
+} // Anonymous namespace close
+
+
 AssocArray *
 aarray_create(long n_lines, int assoc, const char *replace_policy_name)
 {
@@ -1025,9 +1682,9 @@ aarray_create(long n_lines, int assoc, const char *replace_policy_name)
         exit_printf("replacement policy name \"%s\" not recognized\n",
                     replace_policy_name);
     }
-    return new AssocArray(n_lines, assoc, 
-                          static_cast<AAReplacePolicy>(replace_policy),
-                          string());
+    return new_assoc_array(n_lines, assoc,
+                           static_cast<AAReplacePolicy>(replace_policy),
+                           string());
 }
 
 
@@ -1038,9 +1695,9 @@ AssocArray *aarray_create_simcfg(long n_lines, int assoc,
     string path(config_path);
     int replace_policy =
         simcfg_get_enum(AARP_names, (path + "/" + "replace_policy").c_str());
-    return new AssocArray(n_lines, assoc,
-                          static_cast<AAReplacePolicy>(replace_policy),
-                          path);
+    return new_assoc_array(n_lines, assoc,
+                           static_cast<AAReplacePolicy>(replace_policy),
+                           path);
 }
 
 
@@ -1056,7 +1713,7 @@ aarray_destroy(AssocArray *array)
 void 
 aarray_reset(AssocArray *array)
 {
-    array->reset();
+    AARRAY_DISPATCH(array, reset());
 }
 
 
@@ -1064,7 +1721,7 @@ int
 aarray_lookup(AssocArray *array, const AssocArrayKey *key,
               long *line_num_ret, int *way_num_ret)
 {
-    return array->lookup(*key, line_num_ret, way_num_ret);
+    AARRAY_DISPATCH(array, lookup(*key, line_num_ret, way_num_ret));
 }
 
 
@@ -1072,7 +1729,7 @@ int
 aarray_probe(const AssocArray *array, const AssocArrayKey *key,
              long *line_num_ret, int *way_num_ret)
 {
-    return array->probe(*key, line_num_ret, way_num_ret);
+    AARRAY_DISPATCH(array, probe(*key, line_num_ret, way_num_ret));
 }
 
 
@@ -1081,21 +1738,22 @@ aarray_replace(AssocArray *array, const AssocArrayKey *key,
                long *line_num_ret, int *way_num_ret,
                AssocArrayKey *old_key_ret)
 {
-    return array->replace(*key, line_num_ret, way_num_ret, old_key_ret);
+    AARRAY_DISPATCH(array, replace(*key, line_num_ret, way_num_ret,
+                                   old_key_ret));
 }
 
 
 void 
 aarray_invalidate(AssocArray *array, long line_num, int way_num)
 {
-    array->invalidate(line_num, way_num);
+    AARRAY_DISPATCH(array, invalidate(line_num, way_num));
 }
 
 
 void 
 aarray_touch(AssocArray *array, long line_num, int way_num)
 {
-    array->touch(line_num, way_num);
+    AARRAY_DISPATCH(array, touch(line_num, way_num));
 }
 
 
@@ -1103,5 +1761,69 @@ int
 aarray_readkey(const AssocArray *array, long line_num, int way_num,
                AssocArrayKey *key_ret)
 {
-    return array->readkey(line_num, way_num, key_ret);
+    AARRAY_DISPATCH(array, readkey(line_num, way_num, key_ret));
+}
+
+
+void
+aarray_recency_order(const AssocArray *array, long line_num, int *ways_ret)
+{
+    AARRAY_DISPATCH(array, recency_order(line_num, ways_ret));
+}
+
+
+void
+aarray_set_way_enabled(AssocArray *array, int way_num, int enable)
+{
+    array->set_way_enabled(way_num, enable);
+}
+
+
+int
+aarray_way_enabled(const AssocArray *array, int way_num)
+{
+    return array->is_way_enabled(way_num);
+}
+
+
+int
+aarray_ways_enabled(const AssocArray *array)
+{
+    return array->ways_enabled();
+}
+
+
+long
+aarray_active_lines(const AssocArray *array)
+{
+    return array->get_active_lines();
+}
+
+
+int
+aarray_resizing(const AssocArray *array)
+{
+    return array->is_resizing();
+}
+
+
+void
+aarray_resize_begin(AssocArray *array, long new_active_lines)
+{
+    array->resize_begin(new_active_lines);
+}
+
+
+int
+aarray_resize_next_pair(const AssocArray *array, long *line_a_ret,
+                        long *line_b_ret)
+{
+    return array->resize_next_pair(line_a_ret, line_b_ret);
+}
+
+
+void
+aarray_resize_pair_done(AssocArray *array)
+{
+    array->resize_pair_done();
 }
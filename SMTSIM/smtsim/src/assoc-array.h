@@ -96,6 +96,53 @@ int aarray_readkey(const AssocArray *array, long line_num, int way_num,
                    AssocArrayKey *key_ret);
 
 
+/*
+ * Read out the replacement ordering of a line.  All of the line's way numbers
+ * are written to "ways_ret" (which must have room for "assoc" elements), 
+ * ordered from most- to least-recently used; invalid ways come last.  No
+ * state is changed.
+ */
+void aarray_recency_order(const AssocArray *array, long line_num,
+                          int *ways_ret);
+
+
+/*
+ * Way-gating: enable or disable a way across all lines of the array.
+ * Disabling a way invalidates every entry in it (so the caller should first
+ * deal with their contents); disabled ways are never matched by lookups,
+ * and never selected for replacement.  At least one way must stay enabled.
+ * All ways start out enabled.
+ */
+void aarray_set_way_enabled(AssocArray *array, int way_num, int enable);
+int aarray_way_enabled(const AssocArray *array, int way_num);
+int aarray_ways_enabled(const AssocArray *array);
+
+
+/*
+ * Selective-sets resizing: change the number of lines in use, without
+ * reallocating.  The array is created with all n_lines in use; the active
+ * count may be halved, or doubled back up to n_lines.
+ *
+ * The switch is incremental.  aarray_resize_begin() starts it; then, for
+ * each "line pair" in turn, aarray_resize_next_pair() names the two physical
+ * lines involved, the caller reads out and invalidates every entry on both
+ * lines, calls aarray_resize_pair_done() to switch that pair to the new
+ * indexing, and re-inserts whatever entries it wants to keep (with
+ * aarray_replace(), which may evict some if a line overflows when halving).
+ * Lookups and replacements may continue between pairs; each key is indexed
+ * by whichever mapping its pair is currently under.  The resize finishes
+ * when the last pair is done.
+ *
+ * aarray_resize_next_pair() returns zero iff no resize is in progress.
+ */
+long aarray_active_lines(const AssocArray *array);
+int aarray_resizing(const AssocArray *array);
+void aarray_resize_begin(AssocArray *array, long new_active_lines);
+int aarray_resize_next_pair(const AssocArray *array, long *line_a_ret,
+                            long *line_b_ret);
+void aarray_resize_pair_done(AssocArray *array);
+
+
 #ifdef __cplusplus
 }
 #endif
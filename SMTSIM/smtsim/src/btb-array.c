@@ -242,3 +242,60 @@ btb_calc_baseaddr(const BTBArray *btb, u64 addr)
     return base_addr;
 }
 
+
+
+BTBWarmEntry *
+btb_get_entries(const BTBArray *btb, int *n_entries_ret)
+{
+    const long n_lines = btb->n_entries / btb->assoc;
+    int *orders = emalloc(btb->n_entries * sizeof(orders[0]));
+    BTBWarmEntry *result = NULL;
+    int n_found = 0;
+    long line_num;
+    int rank;
+
+    for (line_num = 0; line_num < n_lines; line_num++)
+        aarray_recency_order(btb->cam, line_num,
+                             orders + line_num * btb->assoc);
+
+    for (rank = btb->assoc - 1; rank >= 0; rank--) {
+        for (line_num = 0; line_num < n_lines; line_num++) {
+            int way_num = orders[line_num * btb->assoc + rank];
+            AssocArrayKey ent_key;
+            if (aarray_readkey(btb->cam, line_num, way_num, &ent_key)) {
+                BTBWarmEntry *dst;
+                if (!result)
+                    result = emalloc(btb->n_entries * sizeof(result[0]));
+                dst = result + n_found;
+                dst->addr = ent_key.lookup << btb->inst_bytes_lg;
+                dst->thread_id = (int) ent_key.match;
+                dst->dest =
+                    btb->entries[line_num * btb->assoc + way_num].dest;
+                n_found++;
+            }
+        }
+    }
+
+    free(orders);
+    *n_entries_ret = n_found;
+    return result;
+}
+
+
+void
+btb_inject(BTBArray *btb, u64 addr, int thread_id, u64 dest)
+{
+    AssocArrayKey key;
+    long line_num;
+    int way_num;
+
+    key.lookup = addr >> btb->inst_bytes_lg;
+    key.match = thread_id;
+
+    if (!aarray_lookup(btb->cam, &key, &line_num, &way_num))
+        aarray_replace(btb->cam, &key, &line_num, &way_num, NULL);
+    btb->entries[line_num * btb->assoc + way_num].dest = dest;
+
+    /* any pending lookup's line selection may have been disturbed */
+    btb->last_lookup.valid = 0;
+}
@@ -16,6 +16,7 @@ extern "C" {
 typedef struct BTBArray BTBArray;
 typedef struct BTBStats BTBStats;
 typedef struct BTBLookupInfo BTBLookupInfo; 
+typedef struct BTBWarmEntry BTBWarmEntry;
 
 
 /* Extra info passed to btb_lookup() to help accounting */
@@ -78,6 +79,26 @@ void btb_get_stats(const BTBArray *btb, BTBStats *dest);
 u64 btb_calc_baseaddr(const BTBArray *btb, u64 addr);
 
 
+/* One valid entry, as saved in a warm-state checkpoint */
+struct BTBWarmEntry {
+    u64 addr;
+    int thread_id;
+    u64 dest;
+};
+
+/*
+ * Warm-state checkpoint support: btb_get_entries() returns a malloc'd array
+ * of the valid entries (NULL if none; the count is written to
+ * n_entries_ret), ordered for re-insertion: every line's least-recently
+ * used entry first, up to the MRU entries last.  btb_inject() installs one
+ * such entry as most-recently used, replacing as needed, without changing
+ * stats; injecting the list in order into a BTB of any geometry keeps
+ * what's most recent.
+ */
+BTBWarmEntry *btb_get_entries(const BTBArray *btb, int *n_entries_ret);
+void btb_inject(BTBArray *btb, u64 addr, int thread_id, u64 dest);
+
+
 #ifdef __cplusplus
 }
 #endif
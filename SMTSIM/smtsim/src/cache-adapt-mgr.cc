@@ -0,0 +1,854 @@
+//
+// Cache adaptation manager: interval-driven controller which resizes the
+// L1/L2 caches at run-time, based on per-interval miss rates and IPC
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "cache-adapt-mgr.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "sim-params.h"
+#include "callback-queue.h"
+#include "cache-params.h"
+#include "cache-array.h"
+#include "cache.h"
+#include "core-resources.h"
+#include "context.h"
+#include "phase-tracker.h"
+#include "main.h"
+
+using std::map;
+using std::string;
+using std::vector;
+using namespace SimCfg;
+
+
+CacheAdaptMgr *GlobalCacheAdaptMgr = NULL;
+
+
+namespace {
+
+// How a "step" away from the initial configuration is realized.  Step 0 is
+// always the cache as created; each further step halves its capacity.
+enum AdaptMethod { AM_Ways, AM_Sets, AM_Resize, AdaptMethod_last };
+const char *AdaptMethod_names[] = { "ways", "sets", "resize", NULL };
+
+enum IntervalUnit { IU_Cycles, IU_Commits, IntervalUnit_last };
+const char *IntervalUnit_names[] = { "cyc", "commits", NULL };
+
+enum AdaptPolicyKind { AP_None, AP_Threshold, AP_HillClimb, AP_PhaseTable,
+                       AP_ShadowTags, AdaptPolicyKind_last };
+const char *AdaptPolicyKind_names[] = {
+    "none", "threshold", "hill_climb", "phase_table", "shadow_tags", NULL
+};
+
+// Where the phase IDs fed to policies come from: "intensity" is the log2 of
+// each cache's accesses per 1k instructions, "bbv" is the PhaseTracker
+// classification of the target's core.
+enum PhaseSource { PS_Intensity, PS_BBV, PhaseSource_last };
+const char *PhaseSource_names[] = { "intensity", "bbv", NULL };
+
+// Upper bound on the wait between progress checks, in commit-interval mode
+const i64 MaxCommitPollCyc = 100000;
+
+
+struct IntervalSample {
+    i64 cycles;
+    i64 commits;
+    i64 lookups;
+    i64 misses;
+    i64 phase_id;
+    bool mixed;                 // step was changed mid-interval
+    // Shadow-tag estimates for the interval, if the cache has them:
+    // est_misses[a - 1] is the estimated misses at associativity a
+    vector<i64> est_misses;
+    i64 est_lookups;
+
+    double ipc() const {
+        return (cycles > 0) ? (double) commits / cycles : 0;
+    }
+    double miss_rate() const {
+        return (lookups > 0) ? (double) misses / lookups : 0;
+    }
+};
+
+
+// Base class for decision policies; each adapted cache gets its own
+// instance, so policies may keep per-cache history.
+class AdaptPolicy {
+public:
+    virtual ~AdaptPolicy() { }
+    // Given the sample for the interval just completed, which ran with
+    // "cur_step" in effect, return the step to use next (in [0, max_step]).
+    // "why_ret" is set to a short static explanation, for the log.
+    virtual int decide(const IntervalSample& samp, int cur_step,
+                       int max_step, const char **why_ret) = 0;
+    // Notification of a phase change signalled mid-interval; return the step
+    // to switch to right away, or -1 to leave the choice to the caller.
+    virtual int phase_changed(i64 new_phase, int cur_step, int max_step) {
+        return -1;
+    }
+};
+
+
+class AP_NoneImpl : public AdaptPolicy {
+public:
+    int decide(const IntervalSample& samp, int cur_step, int max_step,
+               const char **why_ret) {
+        *why_ret = "fixed";
+        return cur_step;
+    }
+};
+
+
+// Grow when the miss rate is above "miss_rate_hi", shrink when below
+// "miss_rate_lo", otherwise stay put.
+class AP_ThresholdImpl : public AdaptPolicy {
+    double miss_rate_hi, miss_rate_lo;
+public:
+    AP_ThresholdImpl(const string& cfg_path)
+        : miss_rate_hi(conf_double(cfg_path + "/miss_rate_hi")),
+          miss_rate_lo(conf_double(cfg_path + "/miss_rate_lo")) {
+        if (!(miss_rate_lo <= miss_rate_hi)) {
+            exit_printf("%s: miss_rate_lo (%g) > miss_rate_hi (%g)\n",
+                        cfg_path.c_str(), miss_rate_lo, miss_rate_hi);
+        }
+    }
+    int decide(const IntervalSample& samp, int cur_step, int max_step,
+               const char **why_ret) {
+        double mr = samp.miss_rate();
+        if ((mr > miss_rate_hi) && (cur_step > 0)) {
+            *why_ret = "miss_rate>hi";
+            return cur_step - 1;
+        }
+        if ((mr < miss_rate_lo) && (cur_step < max_step)) {
+            *why_ret = "miss_rate<lo";
+            return cur_step + 1;
+        }
+        *why_ret = "in_band";
+        return cur_step;
+    }
+};
+
+
+// Keep moving in one direction while IPC holds up (to within "tolerance",
+// as a fraction of the previous interval's IPC); turn around when it drops,
+// or at either end of the range.  The first move is toward smaller caches.
+class AP_HillClimbImpl : public AdaptPolicy {
+    double tolerance;
+    double last_ipc;            // <0: no history yet
+    int dir;                    // +1: shrink, -1: grow
+public:
+    AP_HillClimbImpl(const string& cfg_path)
+        : tolerance(conf_double(cfg_path + "/tolerance")),
+          last_ipc(-1), dir(1) {
+        if (tolerance < 0) {
+            exit_printf("%s: bad tolerance (%g)\n", cfg_path.c_str(),
+                        tolerance);
+        }
+    }
+    int decide(const IntervalSample& samp, int cur_step, int max_step,
+               const char **why_ret) {
+        double ipc = samp.ipc();
+        *why_ret = "climb";
+        if ((last_ipc >= 0) && (ipc < last_ipc * (1 - tolerance))) {
+            dir = -dir;
+            *why_ret = "ipc_drop_reverse";
+        }
+        last_ipc = ipc;
+        int next = cur_step + dir;
+        if ((next < 0) || (next > max_step)) {
+            dir = -dir;
+            next = cur_step + dir;
+            *why_ret = "bound_reverse";
+        }
+        return (next < 0) ? 0 : ((next > max_step) ? max_step : next);
+    }
+};
+
+
+// Per-phase table of the IPC seen at each step.  The first intervals of a
+// phase try each untried step in turn; after that, the best-performing step
+// for the phase is used, preferring smaller caches when IPC is within
+// "tolerance" of the best.  The phase of the next interval is predicted to
+// be that of the one just completed, unless a phase change is signalled.
+class AP_PhaseTableImpl : public AdaptPolicy {
+    double tolerance;
+    typedef map<i64, vector<double> > PhaseMap;     // phase -> IPC by step
+    PhaseMap phases;
+
+    // Step to use next for a phase, from its table entry
+    int pick_step(const vector<double>& ipc_by_step, int max_step,
+                  const char **why_ret) const {
+        for (int step = 0; step <= max_step; ++step) {
+            if (ipc_by_step[step] < 0) {
+                *why_ret = "phase_explore";
+                return step;
+            }
+        }
+        double best_ipc = 0;
+        for (int step = 0; step <= max_step; ++step)
+            best_ipc = MAX_SCALAR(best_ipc, ipc_by_step[step]);
+        int best_step = 0;
+        for (int step = max_step; step >= 0; --step) {
+            if (ipc_by_step[step] >= best_ipc * (1 - tolerance)) {
+                best_step = step;
+                break;
+            }
+        }
+        *why_ret = "phase_best";
+        return best_step;
+    }
+
+public:
+    AP_PhaseTableImpl(const string& cfg_path)
+        : tolerance(conf_double(cfg_path + "/tolerance")) {
+        if (tolerance < 0) {
+            exit_printf("%s: bad tolerance (%g)\n", cfg_path.c_str(),
+                        tolerance);
+        }
+    }
+    int decide(const IntervalSample& samp, int cur_step, int max_step,
+               const char **why_ret) {
+        vector<double>& ipc_by_step = phases[samp.phase_id];
+        if (ipc_by_step.empty())
+            ipc_by_step.resize(max_step + 1, -1.0);
+        if (!samp.mixed)
+            ipc_by_step[cur_step] = samp.ipc();
+        return pick_step(ipc_by_step, max_step, why_ret);
+    }
+    int phase_changed(i64 new_phase, int cur_step, int max_step) {
+        PhaseMap::const_iterator found = phases.find(new_phase);
+        const char *why;
+        return (found == phases.end()) ? -1 :
+            pick_step(found->second, max_step, &why);
+    }
+};
+
+
+// Way-gating only: use the cache's shadow tags to pick the fewest ways whose
+// estimated misses are within "tolerance" (fraction of lookups) of those
+// with all ways enabled.
+class AP_ShadowTagsImpl : public AdaptPolicy {
+    double tolerance;
+    int full_assoc;
+public:
+    AP_ShadowTagsImpl(const string& cfg_path, int full_assoc_)
+        : tolerance(conf_double(cfg_path + "/tolerance")),
+          full_assoc(full_assoc_) {
+        if (tolerance < 0) {
+            exit_printf("%s: bad tolerance (%g)\n", cfg_path.c_str(),
+                        tolerance);
+        }
+    }
+    int decide(const IntervalSample& samp, int cur_step, int max_step,
+               const char **why_ret) {
+        sim_assert((int) samp.est_misses.size() >= full_assoc);
+        if (samp.est_lookups <= 0) {
+            *why_ret = "idle";
+            return cur_step;
+        }
+        i64 full_misses = samp.est_misses[full_assoc - 1];
+        for (int step = max_step; step > 0; --step) {
+            int ways = full_assoc >> step;
+            double extra = (double) (samp.est_misses[ways - 1] -
+                                     full_misses) / samp.est_lookups;
+            if (extra <= tolerance) {
+                *why_ret = "shadow_fit";
+                return step;
+            }
+        }
+        *why_ret = "shadow_full";
+        return 0;
+    }
+};
+
+
+AdaptPolicy *
+adapt_policy_create(AdaptPolicyKind kind, const string& cfg_path,
+                    int full_assoc)
+{
+    AdaptPolicy *result = NULL;
+    switch (kind) {
+    case AP_None:
+        result = new AP_NoneImpl();
+        break;
+    case AP_Threshold:
+        result = new AP_ThresholdImpl(cfg_path + "/Threshold");
+        break;
+    case AP_HillClimb:
+        result = new AP_HillClimbImpl(cfg_path + "/HillClimb");
+        break;
+    case AP_PhaseTable:
+        result = new AP_PhaseTableImpl(cfg_path + "/PhaseTable");
+        break;
+    case AP_ShadowTags:
+        result = new AP_ShadowTagsImpl(cfg_path + "/ShadowTags", full_assoc);
+        break;
+    default:
+        abort_printf("unhandled AdaptPolicyKind %d\n", (int) kind);
+    }
+    return result;
+}
+
+
+// Sum of committed instructions, for one core (or all, if core is NULL)
+i64
+commits_for_core(const CoreResources *core)
+{
+    i64 result = 0;
+    for (int ctx_id = 0; ctx_id < CtxCount; ++ctx_id) {
+        const context *ctx = Contexts[ctx_id];
+        if (!core || (ctx->core == core))
+            result += ctx->stats.total_commits;
+    }
+    return result;
+}
+
+
+// Delta of a counter since a snapshot, tolerating counters which have been
+// zeroed since (e.g. at the end of warmup)
+i64
+counter_delta(i64 now_val, i64 then_val)
+{
+    return (now_val >= then_val) ? (now_val - then_val) : now_val;
+}
+
+
+struct AdaptTarget {
+    string name;
+    CoreResources *core;        // NULL for shared caches
+    CacheArray *cache;
+    PhaseTracker *phase_trk;    // NULL: use access-intensity phases
+    CacheGeometry *orig_geom;
+    int orig_lines;
+    int step;                   // current (or in-progress) step
+    int max_step;
+    AdaptPolicy *policy;
+    bool mixed;                 // step changed since the interval began
+    map<i64, int> step_for_phase;       // last step chosen, by phase
+
+    struct {
+        i64 lookups, misses, commits;
+        vector<i64> est_misses;         // (empty: no shadow tags)
+        i64 est_lookups;
+    } last;
+
+    struct {
+        i64 intervals;
+        i64 changes;
+        i64 busy_skips;         // decisions deferred: resize in progress
+        i64 phase_reuses;       // mid-interval switches on phase change
+        vector<i64> intervals_at_step;
+    } st;
+
+    AdaptTarget(const string& name_, CoreResources *core_,
+                CacheArray *cache_)
+        : name(name_), core(core_), cache(cache_), phase_trk(NULL),
+          orig_geom(NULL), orig_lines(0), step(0), max_step(0),
+          policy(NULL), mixed(false) {
+        last.lookups = last.misses = last.commits = last.est_lookups = 0;
+        st.intervals = st.changes = st.busy_skips = st.phase_reuses = 0;
+    }
+};
+
+
+}       // Anonymous namespace close
+
+
+class CacheAdaptMgr {
+    class WakeCB;
+    class PhaseChangeCB;
+
+    string cfg_path;
+    CallbackQueue *time_queue;
+    IntervalUnit interval_unit;
+    i64 interval;
+    AdaptMethod method;
+    AdaptPolicyKind policy_kind;
+    PhaseSource phase_source;
+    int sets_pairs_per_cyc;
+    bool log_intervals;
+    FILE *log_out;
+    string log_name;            // empty: log_out is stdout
+
+    vector<AdaptTarget *> targets;
+    scoped_ptr<WakeCB> wake_cb;
+    vector<PhaseChangeCB *> phase_cbs;  // one per PhaseTracker used
+
+    struct {
+        i64 cyc, commits;
+    } interval_start;
+
+    struct {
+        i64 intervals;
+    } st;
+
+    int calc_max_step(const AdaptTarget& targ, int limit) const;
+    void add_target(const string& name, CoreResources *core,
+                    CacheArray *cache);
+    bool apply_step(AdaptTarget& targ, int new_step);
+    IntervalSample sample_target(AdaptTarget& targ, i64 cycles);
+    void adapt_target(AdaptTarget& targ, i64 cycles);
+    void interval_done();
+    i64 wake();
+    void phase_changed(const PhaseChangeArgs *args);
+
+public:
+    CacheAdaptMgr(const string& cfg_path_, CallbackQueue *time_queue_);
+    ~CacheAdaptMgr();
+
+    void printstats(FILE *out, const char *pref) const;
+};
+
+
+class CacheAdaptMgr::WakeCB : public CBQ_Callback {
+    CacheAdaptMgr& mgr;
+public:
+    WakeCB(CacheAdaptMgr& mgr_) : mgr(mgr_) { }
+    i64 invoke(CBQ_Args *args) {
+        return mgr.wake();
+    }
+};
+
+
+class CacheAdaptMgr::PhaseChangeCB : public CBQ_Callback {
+    CacheAdaptMgr& mgr;
+public:
+    PhaseTracker *tracker;
+    PhaseChangeCB(CacheAdaptMgr& mgr_, PhaseTracker *tracker_)
+        : mgr(mgr_), tracker(tracker_) { }
+    i64 invoke(CBQ_Args *args) {
+        mgr.phase_changed(dynamic_cast<const PhaseChangeArgs *>(args));
+        return -1;
+    }
+};
+
+
+CacheAdaptMgr::CacheAdaptMgr(const string& cfg_path_,
+                             CallbackQueue *time_queue_)
+    : cfg_path(cfg_path_), time_queue(time_queue_), log_out(stdout)
+{
+    const string& cp = cfg_path;
+    interval_unit = IntervalUnit(conf_enum(IntervalUnit_names,
+                                           cp + "/interval_unit"));
+    interval = conf_i64(cp + "/interval");
+    if (interval < 1) {
+        exit_printf("%s/interval (%s) must be positive\n", cp.c_str(),
+                    fmt_i64(interval));
+    }
+    method = AdaptMethod(conf_enum(AdaptMethod_names, cp + "/method"));
+    policy_kind = AdaptPolicyKind(conf_enum(AdaptPolicyKind_names,
+                                            cp + "/policy"));
+    phase_source = PhaseSource(conf_enum(PhaseSource_names,
+                                         cp + "/phase_source"));
+    sets_pairs_per_cyc = conf_int(cp + "/sets_pairs_per_cyc");
+    if (sets_pairs_per_cyc < 1) {
+        exit_printf("%s/sets_pairs_per_cyc (%d) must be positive\n",
+                    cp.c_str(), sets_pairs_per_cyc);
+    }
+    log_intervals = conf_bool(cp + "/log_intervals");
+    if (have_conf(cp + "/log_name")) {
+        log_name = conf_str(cp + "/log_name");
+        log_out = static_cast<FILE *>(efopen(log_name.c_str(), 1));
+    }
+
+    for (int core_id = 0; core_id < CoreCount; ++core_id) {
+        CoreResources *core = Cores[core_id];
+        string core_pref = string("core") + fmt_i64(core_id) + ".";
+        if (conf_bool(cp + "/ICache/enable"))
+            add_target(core_pref + "ICache", core, core->icache);
+        if (conf_bool(cp + "/DCache/enable"))
+            add_target(core_pref + "DCache", core, core->dcache);
+        if (GlobalParams.mem.private_l2caches &&
+            conf_bool(cp + "/L2Cache/enable"))
+            add_target(core_pref + "L2Cache", core, core->l2cache);
+    }
+    if (SharedL2Cache && conf_bool(cp + "/L2Cache/enable"))
+        add_target("L2Cache", NULL, SharedL2Cache);
+
+    interval_start.cyc = cyc;
+    interval_start.commits = commits_for_core(NULL);
+    st.intervals = 0;
+
+    for (int i = 0; i < (int) targets.size(); ++i) {
+        PhaseTracker *trk = targets[i]->phase_trk;
+        bool have_cb = false;
+        for (int j = 0; j < (int) phase_cbs.size(); ++j)
+            have_cb = have_cb || (phase_cbs[j]->tracker == trk);
+        if (trk && !have_cb) {
+            phase_cbs.push_back(new PhaseChangeCB(*this, trk));
+            phasetrk_add_change_cb(trk, phase_cbs.back());
+        }
+    }
+
+    wake_cb.reset(new WakeCB(*this));
+    callbackq_enqueue(time_queue, (interval_unit == IU_Cycles) ?
+                      (cyc + interval) : (cyc + 1), wake_cb.get());
+}
+
+
+CacheAdaptMgr::~CacheAdaptMgr()
+{
+    callbackq_cancel_ret(time_queue, wake_cb.get());
+    for (int i = 0; i < (int) phase_cbs.size(); ++i) {
+        phasetrk_remove_change_cb(phase_cbs[i]->tracker, phase_cbs[i]);
+        delete phase_cbs[i];
+    }
+    for (int i = 0; i < (int) targets.size(); ++i) {
+        AdaptTarget *targ = targets[i];
+        delete targ->policy;
+        cachegeom_destroy(targ->orig_geom);
+        delete targ;
+    }
+    if (!log_name.empty())
+        efclose(log_out, log_name.c_str());
+}
+
+
+// Largest number of halvings the given target supports with the selected
+// method, capped at "limit"
+int
+CacheAdaptMgr::calc_max_step(const AdaptTarget& targ, int limit) const
+{
+    const CacheGeometry *geom = targ.orig_geom;
+    int result = 0;
+    while (result < limit) {
+        int next = result + 1;
+        bool ok = false;
+        switch (method) {
+        case AM_Ways:
+            ok = (geom->assoc >> next) >= 1;
+            break;
+        case AM_Sets:
+            ok = (targ.orig_lines >> next) >= 1;
+            break;
+        case AM_Resize: {
+            int size_kb = geom->size_kb >> next;
+            ok = (size_kb >= 1) &&
+                ((size_kb * 1024) / (geom->block_bytes * geom->assoc) >= 1);
+            break;
+        }
+        default:
+            abort_printf("unhandled AdaptMethod %d\n", (int) method);
+        }
+        if (!ok)
+            break;
+        result = next;
+    }
+    return result;
+}
+
+
+void
+CacheAdaptMgr::add_target(const string& name, CoreResources *core,
+                          CacheArray *cache)
+{
+    sim_assert(cache != NULL);
+    const string targ_path = cfg_path + "/" +
+        name.substr(name.find('.') + 1);
+    AdaptTarget *targ = new AdaptTarget(name, core, cache);
+    targ->orig_geom = cachegeom_copy(cache_get_geom(cache, &targ->orig_lines,
+                                                    NULL));
+    int limit = conf_int(have_conf(targ_path + "/max_shrink_steps") ?
+                         (targ_path + "/max_shrink_steps") :
+                         (cfg_path + "/max_shrink_steps"));
+    if (limit < 0) {
+        exit_printf("%s: bad max_shrink_steps (%d)\n", targ_path.c_str(),
+                    limit);
+    }
+    targ->max_step = calc_max_step(*targ, limit);
+    targ->policy = adapt_policy_create(policy_kind, cfg_path,
+                                       targ->orig_geom->assoc);
+    if (policy_kind == AP_ShadowTags) {
+        if (method != AM_Ways) {
+            exit_printf("%s: policy \"shadow_tags\" requires method "
+                        "\"ways\"\n", cfg_path.c_str());
+        }
+        if (cache_shadow_max_assoc(cache) < targ->orig_geom->assoc) {
+            exit_printf("%s: policy \"shadow_tags\" needs ShadowTags "
+                        "enabled for %s, with max_assoc >= %d\n",
+                        cfg_path.c_str(), name.c_str(),
+                        targ->orig_geom->assoc);
+        }
+    }
+    if (phase_source == PS_BBV) {
+        // Shared caches follow the lone core's phases, if there is just one
+        CoreResources *phase_core = (core) ? core :
+            ((CoreCount == 1) ? Cores[0] : NULL);
+        if (phase_core && !(targ->phase_trk = phase_core->phase_trk)) {
+            exit_printf("%s: phase_source \"bbv\" needs core %d's "
+                        "PhaseTracker enabled\n", cfg_path.c_str(),
+                        phase_core->core_id);
+        }
+    }
+    targ->st.intervals_at_step.resize(targ->max_step + 1, 0);
+    CacheStats cstats;
+    cache_get_stats(cache, &cstats);
+    targ->last.lookups = cstats.lookups;
+    targ->last.misses = cstats.misses + cstats.upgrade_misses;
+    targ->last.commits = commits_for_core(core);
+    if (cache_shadow_max_assoc(cache) > 0) {
+        targ->last.est_misses.resize(cache_shadow_max_assoc(cache));
+        targ->last.est_lookups =
+            cache_shadow_miss_curve(cache, &targ->last.est_misses[0]);
+    }
+    targets.push_back(targ);
+}
+
+
+// Move the given cache toward "new_step"; returns false if the change must
+// wait (a set resize is still in progress).  Set resizing only moves one
+// step at a time, so targ.step may end up short of new_step.
+bool
+CacheAdaptMgr::apply_step(AdaptTarget& targ, int new_step)
+{
+    sim_assert((new_step >= 0) && (new_step <= targ.max_step));
+    const CacheGeometry *geom = targ.orig_geom;
+    switch (method) {
+    case AM_Ways:
+        cachesim_set_active_ways(targ.core, targ.cache,
+                                 geom->assoc >> new_step);
+        break;
+    case AM_Sets:
+        if (cache_sets_resizing(targ.cache))
+            return false;
+        new_step = (new_step > targ.step) ? (targ.step + 1) :
+            (targ.step - 1);
+        cachesim_resize_sets(targ.core, targ.cache,
+                             targ.orig_lines >> new_step,
+                             sets_pairs_per_cyc);
+        break;
+    case AM_Resize: {
+        CacheGeometry *new_geom = cachegeom_copy(geom);
+        new_geom->size_kb = geom->size_kb >> new_step;
+        cachesim_reconfigure(targ.core, targ.cache, new_geom);
+        cachegeom_destroy(new_geom);
+        break;
+    }
+    default:
+        abort_printf("unhandled AdaptMethod %d\n", (int) method);
+    }
+    targ.step = new_step;
+    return true;
+}
+
+
+IntervalSample
+CacheAdaptMgr::sample_target(AdaptTarget& targ, i64 cycles)
+{
+    CacheStats cstats;
+    cache_get_stats(targ.cache, &cstats);
+    i64 misses_now = cstats.misses + cstats.upgrade_misses;
+    i64 commits_now = commits_for_core(targ.core);
+
+    IntervalSample samp;
+    samp.cycles = cycles;
+    samp.lookups = counter_delta(cstats.lookups, targ.last.lookups);
+    samp.misses = counter_delta(misses_now, targ.last.misses);
+    samp.commits = counter_delta(commits_now, targ.last.commits);
+    if (targ.phase_trk) {
+        samp.phase_id = phasetrk_cur_phase(targ.phase_trk);
+    } else {
+        // Access intensity: unlike the miss rate or IPC, this doesn't depend
+        // on the cache configuration
+        samp.phase_id = (samp.commits > 0) ?
+            floor_log2(1 + (u64) (samp.lookups * 1000 / samp.commits),
+                       NULL) : -1;
+    }
+    samp.mixed = targ.mixed;
+    targ.mixed = false;
+
+    samp.est_lookups = 0;
+    if (!targ.last.est_misses.empty()) {
+        vector<i64> est_misses_now(targ.last.est_misses.size());
+        i64 est_lookups_now = cache_shadow_miss_curve(targ.cache,
+                                                      &est_misses_now[0]);
+        samp.est_lookups = counter_delta(est_lookups_now,
+                                         targ.last.est_lookups);
+        samp.est_misses.resize(est_misses_now.size());
+        for (int i = 0; i < (int) est_misses_now.size(); ++i) {
+            samp.est_misses[i] = counter_delta(est_misses_now[i],
+                                               targ.last.est_misses[i]);
+        }
+        targ.last.est_misses.swap(est_misses_now);
+        targ.last.est_lookups = est_lookups_now;
+    }
+
+    targ.last.lookups = cstats.lookups;
+    targ.last.misses = misses_now;
+    targ.last.commits = commits_now;
+    return samp;
+}
+
+
+void
+CacheAdaptMgr::adapt_target(AdaptTarget& targ, i64 cycles)
+{
+    IntervalSample samp = sample_target(targ, cycles);
+    targ.st.intervals++;
+    targ.st.intervals_at_step[targ.step]++;
+
+    const char *why = "";
+    int old_step = targ.step;
+    int want_step = targ.policy->decide(samp, old_step, targ.max_step, &why);
+    sim_assert((want_step >= 0) && (want_step <= targ.max_step));
+    targ.step_for_phase[samp.phase_id] = want_step;
+    if (want_step != old_step) {
+        if (apply_step(targ, want_step)) {
+            targ.st.changes++;
+        } else {
+            targ.st.busy_skips++;
+            why = "busy";
+        }
+    }
+
+    fprintf(log_out, "cacheadapt cyc %s %s ipc %.4f miss_rate %.4f "
+            "phase %s step %d -> %d (%s)\n", fmt_now(), targ.name.c_str(),
+            samp.ipc(), samp.miss_rate(), fmt_i64(samp.phase_id),
+            old_step, targ.step, why);
+}
+
+
+// A PhaseTracker saw a phase change: switch its caches straight to the step
+// last chosen for a phase seen before (or to the policy's own choice),
+// rather than waiting for the end of the current interval.
+void
+CacheAdaptMgr::phase_changed(const PhaseChangeArgs *args)
+{
+    sim_assert(args != NULL);
+    if (args->new_phase_is_new)
+        return;
+    for (int i = 0; i < (int) targets.size(); ++i) {
+        AdaptTarget& targ = *targets[i];
+        if (targ.phase_trk != args->tracker)
+            continue;
+        int want_step = targ.policy->phase_changed(args->new_phase,
+                                                   targ.step, targ.max_step);
+        if (want_step < 0) {
+            map<i64, int>::const_iterator found =
+                targ.step_for_phase.find(args->new_phase);
+            if (found == targ.step_for_phase.end())
+                continue;
+            want_step = found->second;
+        }
+        if (want_step == targ.step)
+            continue;
+        int old_step = targ.step;
+        if (!apply_step(targ, want_step)) {
+            targ.st.busy_skips++;
+            continue;
+        }
+        targ.st.phase_reuses++;
+        targ.st.changes++;
+        targ.mixed = true;
+        fprintf(log_out, "cacheadapt cyc %s %s phase %d -> %d "
+                "step %d -> %d (phase_reuse)\n", fmt_now(),
+                targ.name.c_str(), args->old_phase, args->new_phase,
+                old_step, targ.step);
+    }
+}
+
+
+void
+CacheAdaptMgr::interval_done()
+{
+    i64 cycles = cyc - interval_start.cyc;
+    i64 commits_now = commits_for_core(NULL);
+    i64 commits = counter_delta(commits_now, interval_start.commits);
+    st.intervals++;
+    if (log_intervals) {
+        fprintf(log_out, "cacheadapt cyc %s interval %s commits %s "
+                "cycles %s ipc %f\n", fmt_now(), fmt_i64(st.intervals),
+                fmt_i64(commits), fmt_i64(cycles),
+                (cycles > 0) ? ((double) commits / cycles) : 0.0);
+    }
+    for (int i = 0; i < (int) targets.size(); ++i)
+        adapt_target(*targets[i], cycles);
+    interval_start.cyc = cyc;
+    interval_start.commits = commits_now;
+}
+
+
+i64
+CacheAdaptMgr::wake()
+{
+    if (interval_unit == IU_Cycles) {
+        interval_done();
+        return cyc + interval;
+    }
+
+    // Commit-count intervals: check progress, and if the interval isn't
+    // over, sleep for about as long as the remainder should take at the
+    // rate seen so far.
+    i64 commits = counter_delta(commits_for_core(NULL),
+                                interval_start.commits);
+    if (commits >= interval) {
+        interval_done();
+        commits = 0;
+    }
+    i64 elapsed = cyc - interval_start.cyc;
+    double rate = ((commits > 0) && (elapsed > 0)) ?
+        ((double) commits / elapsed) : 1.0;
+    i64 delay = (i64) ((interval - commits) / rate);
+    delay = MIN_SCALAR(delay, MaxCommitPollCyc);
+    return cyc + MAX_SCALAR(delay, 1);
+}
+
+
+void
+CacheAdaptMgr::printstats(FILE *out, const char *pref) const
+{
+    fprintf(out, "%sintervals: %s\n", pref, fmt_i64(st.intervals));
+    for (int i = 0; i < (int) targets.size(); ++i) {
+        const AdaptTarget *targ = targets[i];
+        fprintf(out, "%s%s: step %d/%d intervals %s changes %s "
+                "busy_skips %s phase_reuses %s\n", pref, targ->name.c_str(),
+                targ->step, targ->max_step, fmt_i64(targ->st.intervals),
+                fmt_i64(targ->st.changes), fmt_i64(targ->st.busy_skips),
+                fmt_i64(targ->st.phase_reuses));
+        fprintf(out, "%s  intervals_at_step:", pref);
+        for (int step = 0; step <= targ->max_step; ++step)
+            fprintf(out, " %s", fmt_i64(targ->st.intervals_at_step[step]));
+        fprintf(out, "\n");
+        CacheReconfigStats rs;
+        cache_get_reconfig_stats(targ->cache, &rs);
+        fprintf(out, "%s  transitions: %s blocks moved %s flushed %s, "
+                "cycles lost %s\n", pref, fmt_i64(rs.transitions),
+                fmt_i64(rs.blocks_moved), fmt_i64(rs.blocks_flushed),
+                fmt_i64(rs.lookup_stall_cyc));
+    }
+}
+
+
+CacheAdaptMgr *
+cacheadapt_create(CallbackQueue *time_queue)
+{
+    const char *cfg_path = "CacheAdapt";
+    if (!simcfg_get_bool((string(cfg_path) + "/enable").c_str()))
+        return NULL;
+    return new CacheAdaptMgr(cfg_path, time_queue);
+}
+
+void
+cacheadapt_destroy(CacheAdaptMgr *cam)
+{
+    delete cam;
+}
+
+void
+cacheadapt_printstats(const CacheAdaptMgr *cam, FILE *out, const char *pref)
+{
+    cam->printstats(out, pref);
+}
@@ -0,0 +1,39 @@
+//
+// Cache adaptation manager: interval-driven controller which resizes the
+// L1/L2 caches at run-time, based on per-interval miss rates and IPC
+//
+
+#ifndef CACHE_ADAPT_MGR_H
+#define CACHE_ADAPT_MGR_H
+
+#include <stdio.h>
+
+
+// Defined elsewhere
+struct CallbackQueue;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct CacheAdaptMgr CacheAdaptMgr;
+
+extern CacheAdaptMgr *GlobalCacheAdaptMgr;     // NULL iff disabled
+
+
+// Create a CacheAdaptMgr from the "CacheAdapt" config subtree, and schedule
+// its first wake-up on the given queue (whose time is "cyc").  Returns NULL
+// if adaptation is disabled.  This must be called after the caches and cores
+// have been created.
+CacheAdaptMgr *cacheadapt_create(struct CallbackQueue *time_queue);
+void cacheadapt_destroy(CacheAdaptMgr *cam);
+
+void cacheadapt_printstats(const CacheAdaptMgr *cam, FILE *out,
+                           const char *pref);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CACHE_ADAPT_MGR_H
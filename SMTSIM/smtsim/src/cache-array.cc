@@ -12,6 +12,7 @@ const char RCSid_1034634457[] =
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
 #include <list>
 #include <map>
 #include <set>
@@ -25,7 +26,12 @@ const char RCSid_1034634457[] =
 #include "coherence-mgr.h"
 #include "sim-cfg.h"
 #include "utils.h"
+#include "utils-cc.h"
 #include "sim-params.h"
+#include "shadow-tags.h"
+#include "stack-dist.h"
+#include "all-assoc.h"
+#include "cache-energy.h"
 
 
 using std::string;
@@ -284,6 +290,150 @@ struct WritebackRec {
 typedef std::list<WritebackRec> WritebackQueue;
 
 
+// #lines = bytes / (block size * assoc)
+// lg(#lines) = lg(bytes / assoc) - lg(block size)
+//
+// Returns lg(#lines), or -1 (after printing a complaint) if the size and
+// associativity don't make for a power-of-two number of lines.
+int
+calc_lines_lg(const CacheGeometry *geom, int block_bytes_lg)
+{
+    long cache_bytes = geom->size_kb * 1024;
+    long way_bytes = cache_bytes / geom->assoc;
+    int way_bytes_lg, log_inexact;
+
+    if (cache_bytes % geom->assoc != 0) {
+        fprintf(stderr, "(%s:%i): assoc (%i) doesn't divide "
+                "cache size (%li)\n", __FILE__, __LINE__, geom->assoc,
+                cache_bytes);
+        return -1;
+    }
+    way_bytes_lg = floor_log2(way_bytes, &log_inexact);
+    if (log_inexact) {
+        fprintf(stderr, "(%s:%i): cache bytes / assoc (%li) not a "
+                "power of 2\n", __FILE__, __LINE__, way_bytes);
+        return -1;
+    }
+    if (way_bytes_lg < block_bytes_lg) {
+        fprintf(stderr, "(%s:%i): total cache way size (%li) < "
+                "a single cache block (%i)\n", __FILE__,
+                __LINE__, way_bytes, geom->block_bytes);
+        return -1;
+    }
+    return way_bytes_lg - block_bytes_lg;
+}
+
+
+// A block which is carried across a geometry change
+struct ReconfigResident {
+    AssocArrayKey key;
+    CacheEntry entry;
+    int rank;           // recency rank in its old line: 0 is MRU
+    ReconfigResident(const AssocArrayKey& key_, const CacheEntry& entry_,
+                     int rank_) : key(key_), entry(entry_), rank(rank_) { }
+    LongAddr entry_addr(int block_bytes_lg) const {
+        return LongAddr(key.lookup << block_bytes_lg, key.match);
+    }
+    // Order for re-insertion: least-recent first, so that the most-recent
+    // blocks of each old line are the last to be placed (and so survive).
+    bool operator < (const ReconfigResident& r2) const {
+        return rank > r2.rank;
+    }
+};
+
+
+// Cache decay: blocks idle for more than "interval" cycles are switched off
+// (or put into a low-leakage drowsy state).  Idle times are evaluated
+// lazily, when a block is next accessed or leaves the cache.
+struct CacheDecayState {
+    i64 interval;               // idle cycles before a block decays
+    bool drowsy;                // keep contents (drowsy), vs. switch off
+    int wake_latency;           // extra latency for a hit on a drowsy block
+    double drowsy_leak;         // drowsy block leakage, relative to live
+    vector<i64> touch_cyc;      // [phys_lines][assoc]; -1: no block
+    // Block-cycles live/drowsy, for blocks' idle time up to their last
+    // accounting (see CacheArray::decay_account()), relative to stats reset
+    i64 live_bcyc, drowsy_bcyc;
+    i64 decay_misses, drowsy_wakes;
+    bool wake_pending;          // last lookup woke a drowsy block
+    LongAddr wake_addr;
+    CacheDecayState(const string& cfg_path, int n_blocks) {
+        interval = SimCfg::conf_i64(cfg_path + "/interval");
+        drowsy = SimCfg::conf_bool(cfg_path + "/drowsy");
+        wake_latency = SimCfg::conf_int(cfg_path + "/wake_latency");
+        drowsy_leak = SimCfg::conf_double(cfg_path + "/drowsy_leak");
+        if (interval < 1) {
+            exit_printf("%s/interval must be positive\n", cfg_path.c_str());
+        }
+        if (wake_latency < 0) {
+            exit_printf("%s/wake_latency must be non-negative\n",
+                        cfg_path.c_str());
+        }
+        if ((drowsy_leak < 0) || (drowsy_leak > 1)) {
+            exit_printf("%s/drowsy_leak (%g) out of range [0,1]\n",
+                        cfg_path.c_str(), drowsy_leak);
+        }
+        touch_cyc.resize(n_blocks, -1);
+        wake_pending = false;
+    }
+};
+
+
+// One "LatencyTable" entry: timing for a given (powered) size and
+// associativity.  Op times missing from the entry keep their configured
+// values.
+struct LatencyTableEnt {
+    int size_kb, assoc;
+    bool have_access_wb, have_fill;
+    OpTime access_time, access_time_wb, fill_time;
+};
+
+
+void
+read_lat_op_time(OpTime& dest, const string& path)
+{
+    dest.latency = SimCfg::conf_int(path + "/latency");
+    dest.interval = SimCfg::conf_int(path + "/interval");
+    if ((dest.latency < 0) || (dest.interval < 0)) {
+        exit_printf("%s: latency and interval must be non-negative\n",
+                    path.c_str());
+    }
+}
+
+
+void
+read_latency_table(const string& cfg_path, vector<LatencyTableEnt>& dest)
+{
+    std::set<string> keys;
+    SimCfg::conf_read_keys(cfg_path, &keys);
+    FOR_CONST_ITER(std::set<string>, keys, key_iter) {
+        string ent_path(cfg_path + "/" + *key_iter);
+        LatencyTableEnt ent;
+        ent.size_kb = SimCfg::conf_int(ent_path + "/size_kb");
+        ent.assoc = SimCfg::conf_int(ent_path + "/assoc");
+        if ((ent.size_kb <= 0) || (ent.assoc <= 0)) {
+            exit_printf("%s: bad size_kb/assoc (%d/%d)\n", ent_path.c_str(),
+                        ent.size_kb, ent.assoc);
+        }
+        for (int i = 0; i < int(dest.size()); i++) {
+            if ((dest[i].size_kb == ent.size_kb) &&
+                (dest[i].assoc == ent.assoc)) {
+                exit_printf("%s: duplicate entry for %d KB, %d-way\n",
+                            cfg_path.c_str(), ent.size_kb, ent.assoc);
+            }
+        }
+        read_lat_op_time(ent.access_time, ent_path + "/access_time");
+        ent.have_access_wb = SimCfg::have_conf(ent_path + "/access_time_wb");
+        if (ent.have_access_wb)
+            read_lat_op_time(ent.access_time_wb, ent_path + "/access_time_wb");
+        ent.have_fill = SimCfg::have_conf(ent_path + "/fill_time");
+        if (ent.have_fill)
+            read_lat_op_time(ent.fill_time, ent_path + "/fill_time");
+        dest.push_back(ent);
+    }
+}
+
+
 } // Anonymous namespace close
 
 
@@ -291,7 +441,10 @@ struct CacheArray {
 private:
     int cache_id;
     CacheGeometry geom;
-    CacheTiming timing;
+    CacheTiming timing;                 // in effect for the powered geometry
+    CacheTiming config_timing;          // as given at creation
+    vector<LatencyTableEnt> lat_table;  // empty unless LatencyTable given
+    int lat_table_ent;                  // entry in effect; -1: none
     CoherenceMgr *coher;
     // (parent_core arguably doesn't belong here, but it will likely prove
     // useful in the future)
@@ -301,11 +454,12 @@ private:
 
     string config_base;
     int block_bytes_lg, n_banks_lg;
-    int n_lines_lg, n_lines;
+    int n_lines_lg, n_lines;            // (lines in use; see phys_lines)
     int n_blocks;
+    int phys_lines;                     // lines allocated in "cam"
 
     AssocArray *cam;
-    vector<CacheEntry> entries;         // 2D array [n_lines][assoc]
+    vector<CacheEntry> entries;         // 2D array [phys_lines][assoc]
     vector<CacheBank> banks;            // 1D array [n_banks]
     WritebackQueue wb_fifo;             // pending writebacks
     int wb_fifo_used;
@@ -313,6 +467,18 @@ private:
     PopCountMap pop_count;              // Population count (masterid -> count)
     int pop_total;                      // sum{i}(pop_count[i])
     i64 stats_reset_cyc;
+    ShadowTagMon *shadow;               // NULL unless ShadowTags enabled
+    StackDistProfiler *stack_dist;      // NULL unless StackDist enabled
+    AllAssocSim *all_assoc;             // NULL unless AllAssoc enabled
+    CacheEnergyModel *energy;           // NULL unless CacheEnergy enabled
+    CacheDecayState *decay;             // NULL unless Decay enabled
+    // Lockstep shadow caches, from "Shadows"; each owns its geometry
+    vector<CacheArray *> lockstep;
+    vector<CacheGeometry *> lockstep_geoms;
+    vector<string> lockstep_names;
+    int reconfig_block_cyc;             // bank time to move/flush a block
+    vector<i64> reconfig_until;         // [n_banks]: end of transition work
+    CacheReconfigStats rc_stats;
 
     inline void gen_aa_key(AssocArrayKey& key, const LongAddr& addr) const {
         mem_addr tagidx = addr.a >> block_bytes_lg;
@@ -405,14 +571,120 @@ private:
         --pop_total;
     }
 
-    void wb_enqueue(const LongAddr& base_addr, bool for_coher) {
-        if (wb_fifo_used >= geom.wb_buffer_size) {
+    void wb_enqueue(const LongAddr& base_addr, bool for_coher,
+                    bool allow_overflow = false) {
+        // (allow_overflow is for bulk evictions such as reconfiguration;
+        // the buffer then stays "full" until it drains below capacity)
+        if (!allow_overflow && (wb_fifo_used >= geom.wb_buffer_size)) {
             abort_printf("cache %d WB buffer overflow, enqueue %s\n",
                          cache_id, fmt_laddr(base_addr));
         }
         wb_fifo.push_back(WritebackRec(base_addr, for_coher));
         wb_fifo_used++;
     }
+    void gather_residents(long line_num, i64 now,
+                          vector<ReconfigResident>& dest);
+    void reinsert_residents(const vector<ReconfigResident>& residents,
+                            i64 now, vector<CacheEvicted>& evicted_ret);
+    void evict_for_reconfig(const AssocArrayKey& key, long line_num,
+                            int way_num, i64 now,
+                            vector<CacheEvicted>& evicted_ret);
+
+    // Bill a bank for moving or flushing one block during a geometry
+    // change; dirty blocks are also read out for writeback.  Returns the
+    // time the block's data is available.
+    i64 bill_reconfig_block(const LongAddr& base_addr, bool dirty, i64 now) {
+        if (reconfig_block_cyc <= 0)
+            return now;
+        int bank_num = block_bank_num(base_addr);
+        OpTime op_time;
+        op_time.latency = op_time.interval = reconfig_block_cyc;
+        if (dirty) {
+            op_time.latency += timing.access_time_wb.latency;
+            op_time.interval += timing.access_time_wb.interval;
+        }
+        i64 ready_time = banks[bank_num].bill_time(now, op_time, true);
+        rc_stats.bank_busy_cyc += op_time.interval;
+        if (ready_time > reconfig_until[bank_num])
+            reconfig_until[bank_num] = ready_time;
+        return ready_time;
+    }
+    // Finish off a transition step: lookups on the banks it used must wait
+    // until its work there is done.
+    void reconfig_sync_banks(i64 now) {
+        for (int bank_num = 0; bank_num < geom.n_banks; bank_num++) {
+            if (reconfig_until[bank_num] > now)
+                banks[bank_num].sync_all_ports(now);
+        }
+    }
+
+    i64& decay_touch_ref(long line_num, int way_num) {
+        return decay->touch_cyc[geom.assoc * line_num + way_num];
+    }
+    // Account for a block's idle time since its last touch, up to "now",
+    // and restart its idle count.  Returns true iff it had decayed in the
+    // meantime.  Blocks which can't be switched off (dirty, or locked out
+    // for coherence) stay live, unless in drowsy mode.
+    bool decay_account(long line_num, int way_num, i64 now) {
+        i64& touch = decay_touch_ref(line_num, way_num);
+        sim_assert(touch >= 0);
+        const CacheEntry& entry = ent_ref(line_num, way_num);
+        i64 idle = now - touch;
+        bool decayed = (idle > decay->interval) &&
+            (decay->drowsy ||
+             !(entry.is_dirty() || entry.is_coher_locked_out()));
+        i64 live = (decayed) ? decay->interval : idle;
+        double leak_bcyc = double(live);
+        decay->live_bcyc += live;
+        if (decayed && decay->drowsy) {
+            decay->drowsy_bcyc += idle - live;
+            leak_bcyc += decay->drowsy_leak * (idle - live);
+        }
+        if (energy)
+            energy->charge_block_leakage(leak_bcyc);
+        touch = now;
+        return decayed;
+    }
+    void decay_begin(long line_num, int way_num, i64 now) {
+        if (decay)
+            decay_touch_ref(line_num, way_num) = now;
+    }
+    void decay_end(long line_num, int way_num, i64 now) {
+        if (decay && (decay_touch_ref(line_num, way_num) >= 0)) {
+            decay_account(line_num, way_num, now);
+            decay_touch_ref(line_num, way_num) = -1;
+        }
+    }
+    // Access-time decay handling for a present block; returns true iff the
+    // block had been switched off, in which case it's now gone.  A drowsy
+    // block is woken; if "timed", the wake latency is left pending for the
+    // following update_bank() to charge.
+    bool decay_on_access(const LongAddr& addr, long line_num, int way_num,
+                         bool timed) {
+        i64 now = read_global_cyc_hack();
+        if (!decay_account(line_num, way_num, now))
+            return false;
+        if (decay->drowsy) {
+            decay->drowsy_wakes++;
+            if (timed) {
+                decay->wake_pending = true;
+                decay->wake_addr = addr;
+                align_addr(decay->wake_addr);
+            }
+            return false;
+        }
+        LongAddr base_addr(addr);
+        align_addr(base_addr);
+        decay->decay_misses++;
+        decay_touch_ref(line_num, way_num) = -1;
+        aarray_invalidate(cam, line_num, way_num);
+        ent_ref(line_num, way_num).reset();
+        pop_decrement(base_addr);
+        return true;
+    }
+    void decay_pending(i64 now, i64 *live_ret, i64 *drowsy_ret,
+                       int *live_now_ret, int *drowsy_now_ret) const;
+
     void wb_dump() const {      // for debugging
         printf("cache_id %d WB buffer (n=%d):\n", cache_id,
                (int) wb_fifo.size());
@@ -448,7 +720,11 @@ public:
         bool first_access = false;
         if (aarray_lookup(cam, &lookup_key, &line_num, &way_num)) {
             CacheEntry& entry = ent_ref(line_num, way_num);
-            if (!entry.data_present()) {
+            if (decay && entry.data_present() &&
+                decay_on_access(addr, line_num, way_num, true)) {
+                // block had decayed and been switched off
+                stats.misses++;
+            } else if (!entry.data_present()) {
                 // tag match, data missing => coher. miss for stats purposes
                 stats.misses++;
                 stats.coher_misses++;
@@ -478,6 +754,16 @@ public:
         } else {
             stats.misses++;
         }
+        if (shadow && (result != Cache_CoherBusy))
+            shadow->access(lookup_key.lookup, lookup_key.match);
+        if (stack_dist && (result != Cache_CoherBusy))
+            stack_dist->access(lookup_key.lookup, lookup_key.match);
+        if (all_assoc && (result != Cache_CoherBusy))
+            all_assoc->access(lookup_key.lookup, lookup_key.match);
+        if (!lockstep.empty() && (result != Cache_CoherBusy)) {
+            for (int i = 0; i < int(lockstep.size()); i++)
+                lockstep[i]->lockstep_access(addr, access_type);
+        }
         if (first_access_ret)
             *first_access_ret = first_access;
         return result;
@@ -507,14 +793,17 @@ public:
 
     bool touch(const LongAddr& addr) {
         bool data_present = false;
+        for (int i = 0; i < int(lockstep.size()); i++)
+            lockstep[i]->touch(addr);
         AssocArrayKey lookup_key;
         gen_aa_key(lookup_key, addr);
         long line_num; int way_num;
         if (aarray_lookup(cam, &lookup_key, &line_num, &way_num)) {
             CacheEntry& entry = ent_ref(line_num, way_num);
-            if (entry.data_present()) {
+            // (no timing here, so a drowsy block's wake isn't charged)
+            if (entry.data_present() &&
+                !(decay && decay_on_access(addr, line_num, way_num, false)))
                 data_present = true;
-            }
         }
         return data_present;
     }
@@ -536,6 +825,11 @@ public:
         bool evicted_valid = false;
         bool evicted_dirty = false;
         sim_assert(!wb_buffer_full());
+        for (int i = 0; i < int(lockstep.size()); i++) {
+            // (usually already filled, at lookup time)
+            if (!lockstep[i]->access_ok(addr, access_type))
+                lockstep[i]->lockstep_fill(addr, access_type);
+        }
         gen_aa_key(fill_key, addr);
         if (aarray_lookup(cam, &fill_key, &line_num, &way_num)) {
             // line_num / way_num set for later; data may be missing, though
@@ -591,6 +885,11 @@ public:
             evicted_ret->base_addr = e_base_addr;
             pop_decrement(e_base_addr);
         }
+        if (decay) {
+            i64 now = read_global_cyc_hack();
+            decay_end(line_num, way_num, now);
+            decay_begin(line_num, way_num, now);
+        }
 
         entry.reset();
         switch (access_type) {
@@ -625,6 +924,8 @@ public:
     bool writeback(const LongAddr& addr) {
         // (write-back from a cache above, into this cache)
         sim_assert(!wb_buffer_full());
+        for (int i = 0; i < int(lockstep.size()); i++)
+            lockstep[i]->lockstep_writeback(addr);
         AssocArrayKey wb_key;
         gen_aa_key(wb_key, addr);
         long line_num = 0; int way_num = 0;
@@ -633,6 +934,11 @@ public:
         stats.writes++;
         if (block_in_cache && !entry.data_present())
             block_in_cache = false;
+        // (a switched-off block is gone, so this becomes a write-around;
+        // writebacks aren't latency-critical, so a drowsy wake is free)
+        if (block_in_cache && decay &&
+            decay_on_access(addr, line_num, way_num, false))
+            block_in_cache = false;
         if (block_in_cache) {
             entry.set_dirty();
             sim_assert(coher_ok(addr, entry));
@@ -746,6 +1052,7 @@ public:
                 // cost of holding/matching a cache entry.
                 if (!track_coher_misses)
                     aarray_invalidate(cam, line_num, way_num);
+                decay_end(line_num, way_num, read_global_cyc_hack());
                 entry.reset();
                 pop_decrement(base_addr);
             } else {
@@ -762,6 +1069,11 @@ public:
         return outcome;
     }
 
+    void cancel_wake() {
+        if (decay)
+            decay->wake_pending = false;
+    }
+
     i64 update_bank(const LongAddr& addr, i64 now, CacheBankOp bank_op) {
         int bank_num = block_bank_num(addr);
         CacheBank& bank = banks[bank_num];
@@ -771,8 +1083,29 @@ public:
             (bank_op != CacheBank_LookupUpgrade) &&
             (bank_op != CacheBank_FillCont);
         bank.inc_stats(bank_op);
+        if (energy)
+            note_energy(bank_op);
+        if (SP_F(reconfig_until[bank_num] > now) &&
+            ((bank_op == CacheBank_LookupR) ||
+             (bank_op == CacheBank_LookupREx) ||
+             (bank_op == CacheBank_LookupUpgrade) ||
+             (bank_op == CacheBank_LookupW))) {
+            rc_stats.lookup_stall_cyc += reconfig_until[bank_num] - now;
+        }
         OpTime op_time;
         get_op_time(op_time, bank_op);
+        if (decay && decay->wake_pending &&
+            ((bank_op == CacheBank_LookupR) ||
+             (bank_op == CacheBank_LookupREx) ||
+             (bank_op == CacheBank_LookupUpgrade) ||
+             (bank_op == CacheBank_LookupW))) {
+            // The preceding lookup woke a drowsy block
+            LongAddr base_addr(addr);
+            align_addr(base_addr);
+            if (base_addr == decay->wake_addr)
+                op_time.latency += decay->wake_latency;
+            decay->wake_pending = false;
+        }
         if ((bank_op == CacheBank_CoherPull) ||
             (bank_op == CacheBank_CoherSync)) {
             bank.sync_all_ports(now);
@@ -781,6 +1114,94 @@ public:
         return ready_time;
     }
 
+    // Lockstep-shadow operations: this cache mirrors another's accesses
+    // functionally, with no bank timing.  Misses fill at once, and
+    // writebacks out of this cache are accepted at once.
+    void lockstep_fill(const LongAddr& addr, CacheAccessType access_type) {
+        CacheEvicted evicted;
+        if (fill(addr, access_type, &evicted) == CacheFill_EvictDirty)
+            wb_accepted(evicted.base_addr);
+        if (energy)
+            energy->note_fill();
+    }
+    void lockstep_access(const LongAddr& addr, CacheAccessType access_type) {
+        CacheLOutcome outcome = lookup(addr, access_type, NULL);
+        if (energy) {
+            if (access_type == Cache_Write)
+                energy->note_write();
+            else
+                energy->note_read();
+        }
+        if ((outcome == Cache_Miss) || (outcome == Cache_UpgradeMiss))
+            lockstep_fill(addr, access_type);
+    }
+    void lockstep_writeback(const LongAddr& addr) {
+        // A shadow can hold a block read-only which its parent holds
+        // writeable, if their fills differed; grant permission to match.
+        if (access_ok(addr, Cache_Read) && !access_ok(addr, Cache_Write))
+            mark_writeable(addr);
+        if (!writeback(addr)) {
+            LongAddr base_addr(addr);
+            align_addr(base_addr);
+            wb_accepted(base_addr);
+        }
+        if (energy)
+            energy->note_wb();
+    }
+
+    void note_energy(CacheBankOp bank_op) {
+        switch (bank_op) {
+        case CacheBank_LookupR:
+        case CacheBank_LookupREx:
+        case CacheBank_LookupUpgrade:
+            energy->note_read();
+            break;
+        case CacheBank_LookupW:
+            energy->note_write();
+            break;
+        case CacheBank_Fill:
+        case CacheBank_FillCont:
+            energy->note_fill();
+            break;
+        case CacheBank_WB:
+        case CacheBank_CoherPull:
+            energy->note_wb();
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Select the timing for a powered geometry: the matching LatencyTable
+    // entry if there is one, otherwise the configured timing
+    void select_timing(int size_kb, int assoc) {
+        lat_table_ent = -1;
+        timing = config_timing;
+        for (int i = 0; i < int(lat_table.size()); i++) {
+            const LatencyTableEnt& ent = lat_table[i];
+            if ((ent.size_kb == size_kb) && (ent.assoc == assoc)) {
+                lat_table_ent = i;
+                timing.access_time = ent.access_time;
+                if (ent.have_access_wb)
+                    timing.access_time_wb = ent.access_time_wb;
+                if (ent.have_fill)
+                    timing.fill_time = ent.fill_time;
+                break;
+            }
+        }
+    }
+
+    // Re-derive the timing and energy model for the powered lines and ways
+    void powered_geom_changed(i64 now) {
+        int ways = aarray_ways_enabled(cam);
+        long powered_bytes = static_cast<long>(n_lines) * ways *
+            geom.block_bytes;
+        if (!lat_table.empty())
+            select_timing(static_cast<int>(powered_bytes / 1024), ways);
+        if (energy)
+            energy->set_powered(double(powered_bytes) / 1024, ways, now);
+    }
+
     void get_stats(CacheStats *dest) const {
         *dest = stats;
         dest->lookups = stats.hits + stats.misses +
@@ -830,6 +1251,38 @@ public:
 
     LongAddr *get_tags(int master_id, int *n_tags_ret) const;
 
+    void reconfigure(const CacheGeometry *new_geom, i64 now,
+                     vector<CacheEvicted>& evicted_ret);
+    void set_way_enabled(int way_num, bool enable, i64 now,
+                         vector<CacheEvicted>& evicted_ret);
+    int get_ways_enabled() const { return aarray_ways_enabled(cam); }
+    void resize_sets_begin(int new_n_lines, i64 now);
+    bool resize_sets_step(int max_pairs, i64 now,
+                          vector<CacheEvicted>& evicted_ret);
+    bool sets_resizing() const { return aarray_resizing(cam); }
+    void warm_export(vector<CacheWarmBlock>& dest) const;
+    void warm_import(const CacheWarmBlock *blocks, int n_warm, i64 now,
+                     vector<CacheEvicted>& evicted_ret);
+    const ShadowTagMon *get_shadow() const { return shadow; }
+    const StackDistProfiler *get_stack_dist() const { return stack_dist; }
+    const AllAssocSim *get_all_assoc() const { return all_assoc; }
+    int lockstep_count() const { return int(lockstep.size()); }
+    const CacheArray *get_lockstep(int idx) const {
+        return lockstep.at(idx);
+    }
+    const string& get_lockstep_name(int idx) const {
+        return lockstep_names.at(idx);
+    }
+    bool get_energy(i64 now, CacheEnergyStats *dest) const;
+    bool get_decay_stats(i64 now, CacheDecayStats *dest) const;
+    void get_reconfig_stats(CacheReconfigStats *dest) const {
+        *dest = rc_stats;
+    }
+    bool get_timing(CacheTiming *dest) const {
+        *dest = timing;
+        return lat_table_ent >= 0;
+    }
+
     int get_id() const { return cache_id; }
     const CacheGeometry *get_geom(int *n_lines_ret, int *n_blocks_ret) const {
         if (n_lines_ret)
@@ -845,9 +1298,12 @@ CacheArray::CacheArray(int cache_id_, const CacheGeometry *geom_,
                        const CacheTiming *timing_,
                        CoherenceMgr *coher_, CoreResources *parent_core_,
                        i64 now)
-    : cache_id(cache_id_), geom(*geom_), timing(*timing_), coher(coher_),
+    : cache_id(cache_id_), geom(*geom_), timing(*timing_),
+      config_timing(*timing_), lat_table_ent(-1), coher(coher_),
       parent_core(parent_core_),
-      track_coher_misses(false), cam(0), wb_fifo_used(0), pop_total(0)
+      track_coher_misses(false), cam(0), wb_fifo_used(0), pop_total(0),
+      shadow(0), stack_dist(0), all_assoc(0), energy(0), decay(0),
+      reconfig_block_cyc(0)
 {
     int log_inexact;
 
@@ -885,35 +1341,11 @@ CacheArray::CacheArray(int cache_id_, const CacheGeometry *geom_,
         goto fail;
     }
 
-    // #lines = bytes / (block size * assoc)
-    // lg(#lines) = lg(bytes / assoc) - lg(block size)
-    {
-        long cache_bytes = geom.size_kb * 1024;
-        long way_bytes = cache_bytes / geom.assoc;
-        int way_bytes_lg;
-
-        if (cache_bytes % geom.assoc != 0) {
-            fprintf(stderr, "(%s:%i): assoc (%i) doesn't divide "
-                    "cache size (%li)\n", __FILE__, __LINE__, geom.assoc,
-                    cache_bytes);
-            goto fail;
-        }
-        way_bytes_lg = floor_log2(way_bytes, &log_inexact);
-        if (log_inexact) {
-            fprintf(stderr, "(%s:%i): cache bytes / assoc (%li) not a "
-                    "power of 2\n", __FILE__, __LINE__, way_bytes);
-            goto fail;
-        }
-        if (way_bytes_lg < block_bytes_lg) {
-            fprintf(stderr, "(%s:%i): total cache way size (%li) < "
-                    "a single cache block (%i)\n", __FILE__,
-                    __LINE__, way_bytes, geom.block_bytes);
-            goto fail;
-        }
-        n_lines_lg = way_bytes_lg - block_bytes_lg;
-        n_lines = 1 << n_lines_lg;
-        n_blocks = n_lines * geom.assoc;
-    }
+    if ((n_lines_lg = calc_lines_lg(&geom, block_bytes_lg)) < 0)
+        goto fail;
+    n_lines = 1 << n_lines_lg;
+    n_blocks = n_lines * geom.assoc;
+    phys_lines = n_lines;
 
     if (!(cam = aarray_create_simcfg(n_lines, geom.assoc, geom.config_path))) {
         fprintf(stderr, "(%s:%i): couldn't create AssocArray\n",
@@ -932,6 +1364,89 @@ CacheArray::CacheArray(int cache_id_, const CacheGeometry *geom_,
             track_coher_misses = simcfg_get_bool(key.c_str());
     }
 
+    {
+        string key = config_base + "/" + "reconfig_block_cyc";
+        if (simcfg_have_val(key.c_str()))
+            reconfig_block_cyc = simcfg_get_int(key.c_str());
+        if (reconfig_block_cyc < 0) {
+            exit_printf("%s (%d) must be non-negative\n", key.c_str(),
+                        reconfig_block_cyc);
+        }
+    }
+    reconfig_until.resize(geom.n_banks, 0);
+
+    {
+        string key = config_base + "/" + "LatencyTable";
+        if (simcfg_have_val(key.c_str())) {
+            read_latency_table(key, lat_table);
+            select_timing(geom.size_kb, geom.assoc);
+        }
+    }
+
+    {
+        string key = config_base + "/" + "ShadowTags";
+        if (simcfg_have_val((key + "/enable").c_str()) &&
+            simcfg_get_bool((key + "/enable").c_str()))
+            shadow = new ShadowTagMon(key, n_lines);
+    }
+
+    {
+        string key = config_base + "/" + "StackDist";
+        if (simcfg_have_val((key + "/enable").c_str()) &&
+            simcfg_get_bool((key + "/enable").c_str()))
+            stack_dist = new StackDistProfiler(key, geom.block_bytes);
+    }
+
+    {
+        string key = config_base + "/" + "AllAssoc";
+        if (simcfg_have_val((key + "/enable").c_str()) &&
+            simcfg_get_bool((key + "/enable").c_str()))
+            all_assoc = new AllAssocSim(key);
+    }
+
+    {
+        string key = config_base + "/" + "Shadows";
+        if (simcfg_have_val(key.c_str())) {
+            std::set<string> names;
+            SimCfg::conf_read_keys(key, &names);
+            FOR_CONST_ITER(std::set<string>, names, name_iter) {
+                string sh_path(key + "/" + *name_iter);
+                CacheGeometry *sh_geom = cachegeom_copy(&geom);
+                sh_geom->size_kb = SimCfg::conf_int(sh_path + "/size_kb");
+                sh_geom->assoc = SimCfg::conf_int(sh_path + "/assoc");
+                free(sh_geom->config_path);
+                sh_geom->config_path = e_strdup(sh_path.c_str());
+                lockstep.push_back(new CacheArray(cache_id, sh_geom,
+                                                  &config_timing, NULL,
+                                                  parent_core_, now));
+                lockstep_geoms.push_back(sh_geom);
+                lockstep_names.push_back(*name_iter);
+            }
+        }
+    }
+
+    if (simcfg_have_val("CacheEnergy/enable") &&
+        simcfg_get_bool("CacheEnergy/enable")) {
+        energy = new CacheEnergyModel("CacheEnergy", geom.size_kb, geom.assoc,
+                                      geom.block_bytes, geom.ports.r +
+                                      geom.ports.w + geom.ports.rw, now);
+    }
+
+    {
+        string key = config_base + "/" + "Decay";
+        if (simcfg_have_val((key + "/enable").c_str()) &&
+            simcfg_get_bool((key + "/enable").c_str())) {
+            decay = new CacheDecayState(key, n_blocks);
+            if (coher && !decay->drowsy) {
+                // (dropped blocks would need evict-notifies)
+                exit_printf("%s: switch-off decay isn't supported with "
+                            "coherence; use drowsy mode\n", key.c_str());
+            }
+            if (energy)
+                energy->set_block_leakage(true, now);
+        }
+    }
+
     if (coher)
         cm_add_cache(coher, this, cache_id, parent_core_);
 
@@ -952,6 +1467,15 @@ CacheArray::~CacheArray()
 {
     if (cam)
         aarray_destroy(cam);
+    delete shadow;
+    delete stack_dist;
+    delete all_assoc;
+    for (int i = 0; i < int(lockstep.size()); i++) {
+        delete lockstep[i];
+        cachegeom_destroy(lockstep_geoms[i]);
+    }
+    delete energy;
+    delete decay;
 }
 
 
@@ -972,7 +1496,20 @@ CacheArray::reset(i64 now)
         for (; iter != end; ++iter)
             iter->reset();
     }
+    std::fill(reconfig_until.begin(), reconfig_until.end(), 0);
     pop_reset();
+    if (shadow)
+        shadow->reset();
+    if (stack_dist)
+        stack_dist->reset();
+    if (all_assoc)
+        all_assoc->reset();
+    for (int i = 0; i < int(lockstep.size()); i++)
+        lockstep[i]->reset(now);
+    if (decay) {
+        std::fill(decay->touch_cyc.begin(), decay->touch_cyc.end(), -1);
+        decay->wake_pending = false;
+    }
     reset_stats(now);
 }
 
@@ -993,6 +1530,30 @@ CacheArray::reset_stats(i64 now)
     stats.dirty_evicts = 0;
     stats.coher_writebacks = stats.coher_invalidates = 0;
     stats.wbfull_confs = 0;
+    memset(&rc_stats, 0, sizeof(rc_stats));
+    if (shadow)
+        shadow->reset_stats();
+    if (stack_dist)
+        stack_dist->reset_stats();
+    if (all_assoc)
+        all_assoc->reset_stats();
+    for (int i = 0; i < int(lockstep.size()); i++)
+        lockstep[i]->reset_stats(now);
+    if (energy)
+        energy->reset_stats(now);
+    if (decay) {
+        // Blocks' idle time before "now" is accounted later, so start the
+        // counts off negative to cancel it out
+        i64 pend_live, pend_drowsy;
+        decay_pending(now, &pend_live, &pend_drowsy, NULL, NULL);
+        decay->live_bcyc = -pend_live;
+        decay->drowsy_bcyc = -pend_drowsy;
+        decay->decay_misses = decay->drowsy_wakes = 0;
+        if (energy) {
+            energy->charge_block_leakage(-(pend_live + decay->drowsy_leak *
+                                           pend_drowsy));
+        }
+    }
 }
 
 
@@ -1000,7 +1561,7 @@ LongAddr *
 CacheArray::get_tags(int master_id, int *n_tags_ret) const
 {
     vector<LongAddr> matches;
-    for (long line_num = 0; line_num < n_lines; line_num++) {
+    for (long line_num = 0; line_num < phys_lines; line_num++) {
         for (int way_num = 0; way_num < geom.assoc; way_num++) {
             AssocArrayKey ent_key;
             if (aarray_readkey(cam, line_num, way_num, &ent_key)) {
@@ -1030,6 +1591,400 @@ CacheArray::get_tags(int master_id, int *n_tags_ret) const
 
 
 
+void
+CacheArray::reconfigure(const CacheGeometry *new_geom, i64 now,
+                        vector<CacheEvicted>& evicted_ret)
+{
+    if ((new_geom->block_bytes != geom.block_bytes) ||
+        (new_geom->n_banks != geom.n_banks) ||
+        (new_geom->ports.r != geom.ports.r) ||
+        (new_geom->ports.w != geom.ports.w) ||
+        (new_geom->ports.rw != geom.ports.rw)) {
+        abort_printf("cache %d reconfigure: only size_kb and assoc may "
+                     "change at runtime\n", cache_id);
+    }
+    if ((new_geom->size_kb <= 0) || (new_geom->assoc <= 0)) {
+        abort_printf("cache %d reconfigure: bad geometry (%d KB, %d-way)\n",
+                     cache_id, new_geom->size_kb, new_geom->assoc);
+    }
+    int new_lines_lg = calc_lines_lg(new_geom, block_bytes_lg);
+    if (new_lines_lg < 0) {
+        abort_printf("cache %d reconfigure: can't use %d KB, %d-way\n",
+                     cache_id, new_geom->size_kb, new_geom->assoc);
+    }
+
+    // Gather resident blocks, with their recency within their old line, and
+    // re-insert everything into a fresh array.
+    vector<ReconfigResident> residents;
+    residents.reserve(pop_total);
+    for (long line_num = 0; line_num < phys_lines; line_num++)
+        gather_residents(line_num, now, residents);
+    sim_assert(pop_total == 0);
+    rc_stats.transitions++;
+
+    aarray_destroy(cam);
+    geom.size_kb = new_geom->size_kb;
+    geom.assoc = new_geom->assoc;
+    n_lines_lg = new_lines_lg;
+    n_lines = 1 << n_lines_lg;
+    n_blocks = n_lines * geom.assoc;
+    phys_lines = n_lines;
+    if (!(cam = aarray_create_simcfg(n_lines, geom.assoc, geom.config_path))) {
+        abort_printf("cache %d reconfigure: couldn't create AssocArray\n",
+                     cache_id);
+    }
+    entries.assign(n_blocks, CacheEntry());
+    if (decay)
+        decay->touch_cyc.assign(n_blocks, -1);
+    pop_reset();
+    reinsert_residents(residents, now, evicted_ret);
+    reconfig_sync_banks(now);
+    powered_geom_changed(now);
+}
+
+
+// Append the data-holding blocks on a line to "dest", with their recency
+// ranks, and clear them out of both "cam" and "entries".  Tags without data
+// (kept only for coherence-miss tracking) are dropped.  Blocks locked out
+// for pending coherence actions get the best rank, so that they'll stay put
+// unless their new line is overrun by them.
+void
+CacheArray::gather_residents(long line_num, i64 now,
+                             vector<ReconfigResident>& dest)
+{
+    vector<int> order(geom.assoc);
+    aarray_recency_order(cam, line_num, &order[0]);
+    for (int rank = 0; rank < geom.assoc; rank++) {
+        int way_num = order[rank];
+        AssocArrayKey ent_key;
+        if (!aarray_readkey(cam, line_num, way_num, &ent_key))
+            continue;
+        CacheEntry& entry = ent_ref(line_num, way_num);
+        if (entry.data_present()) {
+            int sort_rank = (entry.is_coher_locked_out()) ? -1 : rank;
+            dest.push_back(ReconfigResident(ent_key, entry, sort_rank));
+            pop_decrement(dest.back().entry_addr(block_bytes_lg));
+        }
+        decay_end(line_num, way_num, now);
+        aarray_invalidate(cam, line_num, way_num);
+        entry.reset();
+    }
+}
+
+
+// Re-insert gathered blocks, least-recent first; placing a block in a full
+// line evicts that line's LRU block, which has already been moved over.
+// Each block moved costs its bank "reconfig_block_cyc".
+void
+CacheArray::reinsert_residents(const vector<ReconfigResident>& residents,
+                               i64 now, vector<CacheEvicted>& evicted_ret)
+{
+    vector<ReconfigResident> sorted(residents);
+    std::stable_sort(sorted.begin(), sorted.end());
+    for (vector<ReconfigResident>::const_iterator iter = sorted.begin();
+         iter != sorted.end(); ++iter) {
+        long line_num; int way_num;
+        AssocArrayKey evicted_key;
+        if (aarray_replace(cam, &iter->key, &line_num, &way_num,
+                           &evicted_key)) {
+            evict_for_reconfig(evicted_key, line_num, way_num, now,
+                               evicted_ret);
+        }
+        ent_ref(line_num, way_num) = iter->entry;
+        decay_begin(line_num, way_num, now);
+        pop_increment(iter->entry_addr(block_bytes_lg));
+        bill_reconfig_block(iter->entry_addr(block_bytes_lg), false, now);
+        rc_stats.blocks_moved++;
+    }
+}
+
+
+// Account for a block being pushed out by a reconfiguration: bill its bank
+// for the flush, allocate a writeback if it's dirty, and reset the (no
+// longer valid) entry.  The caller takes care of the corresponding "cam"
+// entry.
+void
+CacheArray::evict_for_reconfig(const AssocArrayKey& key, long line_num,
+                               int way_num, i64 now,
+                               vector<CacheEvicted>& evicted_ret)
+{
+    CacheEntry& entry = ent_ref(line_num, way_num);
+    sim_assert(entry.data_present());
+    CacheEvicted evicted;
+    reverse_aa_key(evicted.base_addr, key);
+    evicted.dirty = entry.is_dirty();
+    evicted.wb_ready_time = bill_reconfig_block(evicted.base_addr,
+                                                evicted.dirty, now);
+    rc_stats.blocks_flushed++;
+    if (evicted.dirty) {
+        stats.dirty_evicts++;
+        rc_stats.dirty_flushes++;
+        wb_enqueue(evicted.base_addr, false, true);
+    }
+    pop_decrement(evicted.base_addr);
+    evicted_ret.push_back(evicted);
+    decay_end(line_num, way_num, now);
+    entry.reset();
+}
+
+
+// List the data-holding blocks for a warm-state checkpoint, in the order
+// reinsert_residents() would place them: all lines' LRU-most ranks first,
+// down to their MRU blocks last.
+void
+CacheArray::warm_export(vector<CacheWarmBlock>& dest) const
+{
+    vector<int> orders(phys_lines * geom.assoc);
+    for (long line_num = 0; line_num < phys_lines; line_num++)
+        aarray_recency_order(cam, line_num, &orders[line_num * geom.assoc]);
+    for (int rank = geom.assoc - 1; rank >= 0; rank--) {
+        for (long line_num = 0; line_num < phys_lines; line_num++) {
+            int way_num = orders[line_num * geom.assoc + rank];
+            AssocArrayKey ent_key;
+            if (!aarray_readkey(cam, line_num, way_num, &ent_key))
+                continue;
+            const CacheEntry& entry = ent_ref(line_num, way_num);
+            if (entry.data_present()) {
+                CacheWarmBlock blk;
+                reverse_aa_key(blk.base_addr, ent_key);
+                blk.writeable = entry.write_perm();
+                blk.dirty = entry.is_dirty();
+                dest.push_back(blk);
+            }
+        }
+    }
+}
+
+
+// Replace the contents with blocks from a warm-state checkpoint, placed in
+// the given order.  Everything displaced, whether resident beforehand or
+// pushed out by a later block, is dropped without writeback, and reported
+// in "evicted_ret" (with "dirty" clear) for the caller's coherence
+// bookkeeping.  Lockstep shadows are seeded from the same list.
+void
+CacheArray::warm_import(const CacheWarmBlock *blocks, int n_warm, i64 now,
+                        vector<CacheEvicted>& evicted_ret)
+{
+    if (aarray_resizing(cam)) {
+        abort_printf("cache %d: can't import warm state during a set "
+                     "resize\n", cache_id);
+    }
+    vector<ReconfigResident> old_residents;
+    for (long line_num = 0; line_num < phys_lines; line_num++)
+        gather_residents(line_num, now, old_residents);
+    sim_assert(pop_total == 0);
+    for (int i = 0; i < intsize(old_residents); i++) {
+        CacheEvicted evicted;
+        evicted.base_addr = old_residents[i].entry_addr(block_bytes_lg);
+        evicted.dirty = 0;
+        evicted.wb_ready_time = now;
+        evicted_ret.push_back(evicted);
+    }
+
+    for (int i = 0; i < n_warm; i++) {
+        const CacheWarmBlock& blk = blocks[i];
+        const CacheEntryState new_state =
+            (blk.dirty) ? CE_Dirty :
+            (blk.writeable) ? CE_ExclClean : CE_SharedClean;
+        AssocArrayKey key, evicted_key;
+        long line_num; int way_num;
+        gen_aa_key(key, blk.base_addr);
+        if (aarray_probe(cam, &key, &line_num, &way_num)) {
+            // (listed twice: the later entry wins)
+            aarray_touch(cam, line_num, way_num);
+            ent_ref(line_num, way_num).set_state(new_state);
+            continue;
+        }
+        if (aarray_replace(cam, &key, &line_num, &way_num, &evicted_key)) {
+            // (everything in the array now came from "blocks")
+            CacheEvicted evicted;
+            reverse_aa_key(evicted.base_addr, evicted_key);
+            evicted.dirty = 0;
+            evicted.wb_ready_time = now;
+            evicted_ret.push_back(evicted);
+            pop_decrement(evicted.base_addr);
+            decay_end(line_num, way_num, now);
+        }
+        CacheEntry& entry = ent_ref(line_num, way_num);
+        entry.reset();
+        entry.set_state(new_state);
+        decay_begin(line_num, way_num, now);
+        pop_increment(blk.base_addr);
+    }
+
+    for (int i = 0; i < intsize(lockstep); i++) {
+        vector<CacheEvicted> shadow_evicted;
+        lockstep[i]->warm_import(blocks, n_warm, now, shadow_evicted);
+    }
+}
+
+
+void
+CacheArray::set_way_enabled(int way_num, bool enable, i64 now,
+                            vector<CacheEvicted>& evicted_ret)
+{
+    if ((way_num < 0) || (way_num >= geom.assoc)) {
+        abort_printf("cache %d: way %d out of range for %d-way cache\n",
+                     cache_id, way_num, geom.assoc);
+    }
+    if (enable != aarray_way_enabled(cam, way_num))
+        rc_stats.transitions++;
+    if (!enable && aarray_way_enabled(cam, way_num)) {
+        // Flush the way's contents before gating it off
+        for (long line_num = 0; line_num < phys_lines; line_num++) {
+            AssocArrayKey ent_key;
+            if (!aarray_readkey(cam, line_num, way_num, &ent_key))
+                continue;
+            CacheEntry& entry = ent_ref(line_num, way_num);
+            if (entry.data_present()) {
+                evict_for_reconfig(ent_key, line_num, way_num, now,
+                                   evicted_ret);
+            } else {
+                entry.reset();
+            }
+        }
+        reconfig_sync_banks(now);
+    }
+    aarray_set_way_enabled(cam, way_num, enable);
+    powered_geom_changed(now);
+}
+
+
+void
+CacheArray::resize_sets_begin(int new_n_lines, i64 now)
+{
+    if (aarray_resizing(cam)) {
+        abort_printf("cache %d: set resize to %d lines requested while "
+                     "another is in progress\n", cache_id, new_n_lines);
+    }
+    aarray_resize_begin(cam, new_n_lines);
+    rc_stats.transitions++;
+    // Allow for either line count while blocks are in transit
+    n_blocks = MAX_SCALAR(n_lines, new_n_lines) * geom.assoc;
+}
+
+
+// Switch up to max_pairs line-pairs over to the new set count.  Blocks on
+// each pair are re-inserted under the new indexing, keeping the most
+// recently used ones when two lines are folded together.  Returns true once
+// the resize is complete.
+bool
+CacheArray::resize_sets_step(int max_pairs, i64 now,
+                             vector<CacheEvicted>& evicted_ret)
+{
+    vector<ReconfigResident> residents;
+    long line_a, line_b;
+    sim_assert(max_pairs > 0);
+    for (int pair = 0; (pair < max_pairs) &&
+             aarray_resize_next_pair(cam, &line_a, &line_b); pair++) {
+        residents.clear();
+        gather_residents(line_a, now, residents);
+        gather_residents(line_b, now, residents);
+        aarray_resize_pair_done(cam);
+        reinsert_residents(residents, now, evicted_ret);
+    }
+    reconfig_sync_banks(now);
+    bool done = !aarray_resizing(cam);
+    if (done) {
+        n_lines = aarray_active_lines(cam);
+        n_lines_lg = log2_exact(n_lines);
+        n_blocks = n_lines * geom.assoc;
+        geom.size_kb = static_cast<int>((static_cast<long>(n_blocks) *
+                                         geom.block_bytes) / 1024);
+        powered_geom_changed(now);
+    }
+    return done;
+}
+
+
+bool
+CacheArray::get_energy(i64 now, CacheEnergyStats *dest) const
+{
+    if (!energy)
+        return false;
+    dest->dyn_nj = energy->g_dyn_nj();
+    dest->leak_nj = energy->g_leak_nj(now);
+    dest->reads = energy->g_reads();
+    dest->writes = energy->g_writes();
+    dest->fills = energy->g_fills();
+    dest->wbs = energy->g_wbs();
+    dest->cyc = now - stats_reset_cyc;
+    dest->clock_mhz = energy->g_clock_mhz();
+    dest->leak_mw = energy->g_coeffs().leak_mw;
+    if (decay) {
+        i64 pend_live, pend_drowsy;
+        int live_now, drowsy_now;
+        decay_pending(now, &pend_live, &pend_drowsy, &live_now, &drowsy_now);
+        dest->leak_nj += energy->block_leak_nj(pend_live + decay->drowsy_leak *
+                                               pend_drowsy);
+        int powered = n_lines * aarray_ways_enabled(cam);
+        dest->leak_mw *= (live_now + decay->drowsy_leak * drowsy_now) /
+            powered;
+    }
+    return true;
+}
+
+
+// Sum up the idle-time accounting not yet done for blocks in the cache, as
+// of "now": block-cycles live and drowsy since their last touch, and the
+// number of blocks currently live and drowsy.  (Output pointers other than
+// live_ret and drowsy_ret may be NULL.)
+void
+CacheArray::decay_pending(i64 now, i64 *live_ret, i64 *drowsy_ret,
+                          int *live_now_ret, int *drowsy_now_ret) const
+{
+    i64 live = 0, drowsy = 0;
+    int live_now = 0, drowsy_now = 0;
+    for (long line_num = 0; line_num < phys_lines; line_num++) {
+        for (int way_num = 0; way_num < geom.assoc; way_num++) {
+            i64 touch = decay->touch_cyc[geom.assoc * line_num + way_num];
+            if (touch < 0)
+                continue;
+            const CacheEntry& entry = ent_ref(line_num, way_num);
+            i64 idle = now - touch;
+            bool decayed = (idle > decay->interval) &&
+                (decay->drowsy ||
+                 !(entry.is_dirty() || entry.is_coher_locked_out()));
+            if (decayed) {
+                live += decay->interval;
+                if (decay->drowsy) {
+                    drowsy += idle - decay->interval;
+                    drowsy_now++;
+                }
+            } else {
+                live += idle;
+                live_now++;
+            }
+        }
+    }
+    *live_ret = live;
+    *drowsy_ret = drowsy;
+    if (live_now_ret)
+        *live_now_ret = live_now;
+    if (drowsy_now_ret)
+        *drowsy_now_ret = drowsy_now;
+}
+
+
+bool
+CacheArray::get_decay_stats(i64 now, CacheDecayStats *dest) const
+{
+    if (!decay)
+        return false;
+    i64 pend_live, pend_drowsy;
+    decay_pending(now, &pend_live, &pend_drowsy, NULL, NULL);
+    i64 interval = now - stats_reset_cyc;
+    dest->decay_misses = decay->decay_misses;
+    dest->drowsy_wakes = decay->drowsy_wakes;
+    dest->avg_live_blocks = (interval > 0) ?
+        (double(decay->live_bcyc + pend_live) / interval) : 0.0;
+    dest->avg_drowsy_blocks = (interval > 0) ?
+        (double(decay->drowsy_bcyc + pend_drowsy) / interval) : 0.0;
+    return true;
+}
+
+
+
 //
 // C interface
 //
@@ -1082,6 +2037,12 @@ cache_touch(CacheArray *cache, LongAddr addr)
     return cache->touch(addr);
 }
 
+void
+cache_cancel_wake(CacheArray *cache)
+{
+    cache->cancel_wake();
+}
+
 int
 cache_wb_buffer_full(const CacheArray *cache)
 {
@@ -1197,6 +2158,172 @@ cache_get_geom(const CacheArray *cache,
     return cache->get_geom(n_lines_ret, n_blocks_ret);
 }
 
+static CacheEvicted *
+evicted_to_c_array(const vector<CacheEvicted>& evicted, int *n_evicted_ret)
+{
+    CacheEvicted *result = NULL;
+    int n_evicted = int(evicted.size());
+    if (!evicted.empty()) {
+        result = static_cast<CacheEvicted *>
+            (emalloc(n_evicted * sizeof(result[0])));
+        for (int i = 0; i < n_evicted; i++)
+            result[i] = evicted[i];
+    }
+    *n_evicted_ret = n_evicted;
+    return result;
+}
+
+CacheEvicted *
+cache_reconfigure(CacheArray *cache, const CacheGeometry *new_geom, i64 now,
+                  int *n_evicted_ret)
+{
+    vector<CacheEvicted> evicted;
+    cache->reconfigure(new_geom, now, evicted);
+    return evicted_to_c_array(evicted, n_evicted_ret);
+}
+
+void
+cache_resize_sets_begin(CacheArray *cache, int new_n_lines, i64 now)
+{
+    cache->resize_sets_begin(new_n_lines, now);
+}
+
+CacheEvicted *
+cache_resize_sets_step(CacheArray *cache, int max_pairs, i64 now,
+                       int *n_evicted_ret, int *done_ret)
+{
+    vector<CacheEvicted> evicted;
+    *done_ret = cache->resize_sets_step(max_pairs, now, evicted);
+    return evicted_to_c_array(evicted, n_evicted_ret);
+}
+
+CacheWarmBlock *
+cache_warm_export(const CacheArray *cache, int *n_blocks_ret)
+{
+    vector<CacheWarmBlock> blocks;
+    cache->warm_export(blocks);
+    CacheWarmBlock *result = NULL;
+    int n_blocks = intsize(blocks);
+    if (!blocks.empty()) {
+        result = static_cast<CacheWarmBlock *>
+            (emalloc(n_blocks * sizeof(result[0])));
+        for (int i = 0; i < n_blocks; i++)
+            result[i] = blocks[i];
+    }
+    *n_blocks_ret = n_blocks;
+    return result;
+}
+
+CacheEvicted *
+cache_warm_import(CacheArray *cache, const CacheWarmBlock *blocks,
+                  int n_blocks, i64 now, int *n_evicted_ret)
+{
+    vector<CacheEvicted> evicted;
+    cache->warm_import(blocks, n_blocks, now, evicted);
+    return evicted_to_c_array(evicted, n_evicted_ret);
+}
+
+int
+cache_sets_resizing(const CacheArray *cache)
+{
+    return cache->sets_resizing();
+}
+
+CacheEvicted *
+cache_set_way_enabled(CacheArray *cache, int way_num, int enable, i64 now,
+                      int *n_evicted_ret)
+{
+    vector<CacheEvicted> evicted;
+    cache->set_way_enabled(way_num, enable, now, evicted);
+    return evicted_to_c_array(evicted, n_evicted_ret);
+}
+
+int
+cache_get_ways_enabled(const CacheArray *cache)
+{
+    return cache->get_ways_enabled();
+}
+
+int
+cache_shadow_max_assoc(const CacheArray *cache)
+{
+    const ShadowTagMon *shadow = cache->get_shadow();
+    return (shadow) ? shadow->g_max_assoc() : 0;
+}
+
+i64
+cache_shadow_miss_curve(const CacheArray *cache, i64 *est_misses_ret)
+{
+    const ShadowTagMon *shadow = cache->get_shadow();
+    sim_assert(shadow != NULL);
+    vector<i64> est_misses;
+    i64 est_accesses = shadow->get_miss_curve(est_misses);
+    std::copy(est_misses.begin(), est_misses.end(), est_misses_ret);
+    return est_accesses;
+}
+
+void
+cache_print_stack_dist(const CacheArray *cache, const char *pref,
+                       const char *name)
+{
+    const StackDistProfiler *stack_dist = cache->get_stack_dist();
+    if (stack_dist)
+        stack_dist->print(pref, name);
+}
+
+int
+cache_lockstep_count(const CacheArray *cache)
+{
+    return cache->lockstep_count();
+}
+
+const CacheArray *
+cache_lockstep_shadow(const CacheArray *cache, int idx)
+{
+    return cache->get_lockstep(idx);
+}
+
+const char *
+cache_lockstep_name(const CacheArray *cache, int idx)
+{
+    return cache->get_lockstep_name(idx).c_str();
+}
+
+void
+cache_print_all_assoc(const CacheArray *cache, const char *pref,
+                      const char *name)
+{
+    const AllAssocSim *all_assoc = cache->get_all_assoc();
+    if (all_assoc)
+        all_assoc->print(pref, name);
+}
+
+int
+cache_get_energy(const CacheArray *cache, i64 now, CacheEnergyStats *dest)
+{
+    return cache->get_energy(now, dest);
+}
+
+int
+cache_get_decay_stats(const CacheArray *cache, i64 now,
+                      CacheDecayStats *dest)
+{
+    return cache->get_decay_stats(now, dest);
+}
+
+void
+cache_get_reconfig_stats(const CacheArray *cache, CacheReconfigStats *dest)
+{
+    cache->get_reconfig_stats(dest);
+}
+
+
+int
+cache_get_timing(const CacheArray *cache, CacheTiming *dest)
+{
+    return cache->get_timing(dest);
+}
+
 
 
 //
@@ -22,7 +22,11 @@ struct CoreResources;
 typedef struct CacheEvicted CacheEvicted;
 typedef struct CacheStats CacheStats;
 typedef struct CacheBankStats CacheBankStats;
+typedef struct CacheEnergyStats CacheEnergyStats;
+typedef struct CacheDecayStats CacheDecayStats;
+typedef struct CacheReconfigStats CacheReconfigStats;
 typedef struct CacheArray CacheArray;
+typedef struct CacheWarmBlock CacheWarmBlock;
 
 typedef enum { Cache_Read, Cache_ReadExcl,
                Cache_Upgrade,   // Like Cache_ReadExcl, but already has data
@@ -76,9 +80,47 @@ struct CacheBankStats {
 };
 
 
+// Energy model totals (see cache-energy.h)
+struct CacheEnergyStats {
+    double dyn_nj, leak_nj;             // dynamic and leakage energy
+    i64 reads, writes, fills, wbs;      // bank ops charged for
+    i64 cyc;                            // cycles covered
+    double clock_mhz;
+    double leak_mw;                     // current leakage power
+};
+
+// Cache decay stats
+struct CacheDecayStats {
+    i64 decay_misses;                   // lookups finding a block switched off
+    i64 drowsy_wakes;                   // hits on drowsy blocks
+    double avg_live_blocks;             // (time-averaged)
+    double avg_drowsy_blocks;
+};
+
+
+// Geometry-change (reconfiguration, way-gating, set resizing) costs
+struct CacheReconfigStats {
+    i64 transitions;                    // (each set resize counts once)
+    i64 blocks_moved, blocks_flushed, dirty_flushes;
+    i64 bank_busy_cyc;                  // bank time spent moving/flushing
+    i64 lookup_stall_cyc;               // lookup cycles lost waiting on it
+};
+
+
 // Evicted cache block info
 struct CacheEvicted {
     LongAddr base_addr;
+    // (these are only set by reconfiguration/way-gating calls)
+    int dirty;
+    i64 wb_ready_time;  // time the block has been read out for writeback
+};
+
+
+// One resident block, as saved in a warm-state checkpoint
+struct CacheWarmBlock {
+    LongAddr base_addr;
+    int writeable;      // held with write permission
+    int dirty;          // (implies writeable)
 };
 
 
@@ -115,6 +157,11 @@ int cache_access_ok(const CacheArray *cache, LongAddr addr,
 // replacement.  Returns true iff the block is present.
 int cache_touch(CacheArray *cache, LongAddr addr);
 
+// For lookups with no cache_update_bank() to follow (e.g. functional
+// warming): forget any drowsy-block wake noted by the last cache_lookup(),
+// so that it isn't charged to some later access.  (See "Decay", below.)
+void cache_cancel_wake(CacheArray *cache);
+
 
 // Test: is outbound WB buffer full?
 int cache_wb_buffer_full(const CacheArray *cache);
@@ -222,6 +269,153 @@ int cache_get_id(const CacheArray *cache);
 const CacheGeometry *cache_get_geom(const CacheArray *cache,
                                     int *n_lines_ret, int *n_blocks_ret);
 
+// Change the size and/or associativity of a live cache.  Only the "size_kb"
+// and "assoc" fields of new_geom may differ from the current geometry.
+//
+// Resident blocks are re-inserted under the new geometry in recency order;
+// blocks which no longer fit in their new line are evicted.  Dirty victims
+// are allocated outbound writeback buffer entries, as with cache_fill(),
+// except that the buffer is allowed to overflow its nominal size; it will
+// then report full until enough writebacks have been accepted.  Coherence
+// lock-outs, dirty bits, and population counts are carried along.
+//
+// Returns a malloc'd array of the evicted blocks (with "dirty" set for those
+// needing writeback), or NULL if none were evicted; the number of elements
+// is written to n_evicted_ret.  The caller is responsible for issuing the
+// writebacks and any eviction notifications, as for cache_fill().
+CacheEvicted *cache_reconfigure(CacheArray *cache,
+                                const CacheGeometry *new_geom, i64 now,
+                                int *n_evicted_ret);
+
+// The work of a geometry change is billed to the cache banks: each block
+// moved or flushed occupies a port on its bank for "reconfig_block_cyc"
+// cycles (from the cache's config subtree; default 0, for free transitions),
+// plus "access_time_wb" if it's dirty, and the bank's other ports then wait
+// for that to finish.  So, lookups during a transition stall behind it, as
+// reported by cache_update_bank(); the cycles lost are counted in
+// CacheReconfigStats.
+void cache_get_reconfig_stats(const CacheArray *cache,
+                              CacheReconfigStats *dest);
+
+// Geometry-dependent timing: the cache's config subtree may hold a
+// "LatencyTable" of entries, each with "size_kb", "assoc", and an
+// "access_time" (plus optionally "access_time_wb" and "fill_time") to use
+// when that much of the cache is powered.  The entry matching the
+// as-created geometry replaces the configured timing, and the match is
+// redone after each reconfigure, way-gating change, or completed set
+// resize; with no match, the configured timing applies.  This copies the
+// timing now in effect to "dest", and returns nonzero iff it came from the
+// table.
+int cache_get_timing(const CacheArray *cache, CacheTiming *dest);
+
+// Way-gating: power a way on or off across all sets, without changing the
+// cache's nominal geometry.  Turning a way off evicts its contents, with the
+// same writeback handling and return convention as cache_reconfigure();
+// turning one on just makes it available for future fills.  At least one way
+// must stay enabled.  (A later cache_reconfigure() starts over with all
+// ways enabled.)
+CacheEvicted *cache_set_way_enabled(CacheArray *cache, int way_num,
+                                    int enable, i64 now, int *n_evicted_ret);
+int cache_get_ways_enabled(const CacheArray *cache);
+
+// Selective-sets resizing: halve the number of sets in use, or double it
+// back (up to the number of sets the cache was created or last
+// reconfigured with).  Unlike cache_reconfigure(), this is done in place and
+// incrementally: cache_resize_sets_begin() starts the change, and each
+// cache_resize_sets_step() call moves up to max_pairs pairs of sets over to
+// the new indexing.  When halving, the blocks of each pair are folded
+// together, with the least-recently used overflow evicted; when doubling,
+// blocks are redistributed by the new index bit.  The cache remains usable
+// between steps.  Evicted blocks are returned as for cache_reconfigure(),
+// and *done_ret is set nonzero once the resize has completed (at which point
+// the cache's geometry reflects the new size).
+void cache_resize_sets_begin(CacheArray *cache, int new_n_lines, i64 now);
+CacheEvicted *cache_resize_sets_step(CacheArray *cache, int max_pairs,
+                                     i64 now, int *n_evicted_ret,
+                                     int *done_ret);
+int cache_sets_resizing(const CacheArray *cache);
+
+// Warm-state checkpoints: cache_warm_export() returns a malloc'd array of
+// the blocks holding data (NULL if none; the count is written to
+// n_blocks_ret), ordered for re-insertion: every line's least-recently used
+// block first, then every line's next-least, and so on up to the MRU
+// blocks.  cache_warm_import() discards the cache's contents and fills in
+// "blocks" in order, whatever the cache's geometry: blocks which don't fit
+// push out earlier (older) ones from their new line, the way
+// cache_reconfigure() does.  Nothing is written back, and no stats or bank
+// time are charged.  Every block discarded or pushed out is returned as for
+// cache_reconfigure(), with "dirty" clear, so that the caller can keep
+// coherence state in step; the caller is also responsible for having
+// cleared each imported block with the coherence manager.
+CacheWarmBlock *cache_warm_export(const CacheArray *cache,
+                                  int *n_blocks_ret);
+CacheEvicted *cache_warm_import(CacheArray *cache,
+                                const CacheWarmBlock *blocks, int n_blocks,
+                                i64 now, int *n_evicted_ret);
+
+// Set-sampled shadow tags ("UMON"), enabled with "ShadowTags/enable" in the
+// cache's config subtree: cache_shadow_max_assoc() returns the largest
+// associativity monitored, or 0 if disabled.  cache_shadow_miss_curve()
+// writes the estimated misses since the last stats reset, for each
+// associativity a in [1, max_assoc], to est_misses_ret[a - 1], and returns
+// the estimated number of lookups.  The estimates are for the number of sets
+// the cache was created with.
+int cache_shadow_max_assoc(const CacheArray *cache);
+i64 cache_shadow_miss_curve(const CacheArray *cache, i64 *est_misses_ret);
+
+// Stack-distance profiler, enabled with "StackDist/enable" in the cache's
+// config subtree: from the cache's lookups, computes the miss rates an LRU
+// cache would see at every power-of-two size from "StackDist/min_kb" to
+// "StackDist/max_kb", at each power-of-two associativity up to
+// "StackDist/max_assoc" and fully-associative, in a single pass.  This
+// prints those curves (since the last stats reset), one line per
+// associativity, if enabled.
+void cache_print_stack_dist(const CacheArray *cache, const char *pref,
+                            const char *name);
+
+// All-associativity simulation, enabled with "AllAssoc/enable" in the
+// cache's config subtree: from the cache's lookups, counts the hits an LRU
+// cache with bit-selection indexing would see for every power-of-two set
+// count from "AllAssoc/min_sets" to "AllAssoc/max_sets", and every way
+// count up to "AllAssoc/max_ways", in a single pass.  This prints those
+// counts (since the last stats reset), one line per set count, if enabled.
+void cache_print_all_assoc(const CacheArray *cache, const char *pref,
+                           const char *name);
+
+// Lockstep shadow caches: each entry in the "Shadows" subtree of the
+// cache's config (with its own "size_kb", "assoc", and "replace_policy")
+// creates a tag-only CacheArray which sees every lookup, fill, and inbound
+// writeback this cache does, but has no effect on timing.  A shadow's
+// misses are filled immediately, and its writebacks accepted immediately,
+// so it tracks what its own geometry would hold.  Its stats (and energy,
+// with the energy model on: lookups, fills and writebacks, without bank
+// timing) are read through the usual calls on cache_lockstep_shadow().
+// Shadows are reset along with this cache, and are not reconfigured with it.
+int cache_lockstep_count(const CacheArray *cache);
+const CacheArray *cache_lockstep_shadow(const CacheArray *cache, int idx);
+const char *cache_lockstep_name(const CacheArray *cache, int idx);
+
+// Energy model, enabled with "CacheEnergy/enable": if enabled, writes the
+// energy totals since the last stats reset (with leakage charged up to
+// "now") to *dest and returns nonzero; returns 0 otherwise.  Leakage tracks
+// the powered portion of the cache, through way-gating and resizing.
+int cache_get_energy(const CacheArray *cache, i64 now,
+                     CacheEnergyStats *dest);
+
+// Cache decay, enabled with "Decay/enable" in the cache's config subtree: a
+// block left untouched for more than "Decay/interval" cycles is switched
+// off, dropping its contents (clean blocks only; dirty ones are kept), or
+// with "Decay/drowsy" set, kept in a drowsy state.  A lookup which finds a
+// switched-off block misses; one which hits a drowsy block wakes it, and
+// the following cache_update_bank() for that block adds
+// "Decay/wake_latency" cycles.  (cache_touch() and inbound writebacks see
+// switched-off blocks as absent too, and wake drowsy ones at no cost.)
+// With the energy model enabled, leakage is only charged for live blocks
+// (and "Decay/drowsy_leak" of the live rate for drowsy ones).
+// cache_get_decay_stats() returns 0 if decay is off.
+int cache_get_decay_stats(const CacheArray *cache, i64 now,
+                          CacheDecayStats *dest);
+
 
 #ifdef __cplusplus
 }
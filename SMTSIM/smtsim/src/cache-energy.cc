@@ -0,0 +1,155 @@
+//
+// Table-driven cache energy model: dynamic energy per bank operation, plus
+// leakage for the powered portion of the array
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "utils.h"
+#include "sim-cfg.h"
+#include "cache-energy.h"
+
+
+using namespace SimCfg;
+using std::string;
+
+
+namespace {
+
+struct EnergyTableEnt {
+    int size_kb, assoc, block_bytes, ports;
+    CacheEnergyCoeffs c;
+};
+
+// Rough CACTI 6.5 estimates, 45nm, high-performance devices, one bank.
+// Columns: size_kb, assoc, block_bytes, ports;
+// read_nj, write_nj, fill_nj, wb_nj, leak_mw
+const EnergyTableEnt EnergyTable[] = {
+    {    8,  2, 64, 1, { 0.010, 0.011, 0.012, 0.011,    4.1 } },
+    {   16,  2, 64, 1, { 0.014, 0.015, 0.017, 0.015,    7.6 } },
+    {   16,  4, 64, 1, { 0.019, 0.017, 0.019, 0.017,    8.2 } },
+    {   32,  2, 64, 1, { 0.020, 0.019, 0.023, 0.019,   14.4 } },
+    {   32,  4, 64, 1, { 0.025, 0.022, 0.026, 0.022,   15.1 } },
+    {   32,  8, 64, 1, { 0.034, 0.025, 0.028, 0.025,   16.0 } },
+    {   32,  4, 64, 2, { 0.031, 0.028, 0.032, 0.028,   24.3 } },
+    {   64,  1, 64, 1, { 0.022, 0.024, 0.029, 0.024,   27.2 } },
+    {   64,  2, 64, 1, { 0.028, 0.027, 0.032, 0.027,   28.0 } },
+    {   64,  4, 64, 1, { 0.036, 0.030, 0.036, 0.030,   29.1 } },
+    {   64,  8, 64, 1, { 0.048, 0.034, 0.039, 0.034,   30.5 } },
+    {   64,  2, 64, 2, { 0.035, 0.034, 0.040, 0.034,   45.2 } },
+    {  256,  8, 64, 1, { 0.090, 0.080, 0.100, 0.080,   95.0 } },
+    {  512,  2, 64, 1, { 0.110, 0.100, 0.120, 0.100,  180.0 } },
+    {  512,  8, 64, 1, { 0.140, 0.115, 0.135, 0.115,  185.0 } },
+    { 1024,  8, 64, 1, { 0.200, 0.170, 0.210, 0.170,  360.0 } },
+    { 1024, 16, 64, 1, { 0.260, 0.190, 0.230, 0.190,  368.0 } },
+    { 2048,  8, 64, 1, { 0.290, 0.240, 0.300, 0.240,  700.0 } },
+    { 4096,  2, 64, 1, { 0.380, 0.330, 0.400, 0.330, 1360.0 } },
+    { 4096, 16, 64, 1, { 0.520, 0.420, 0.530, 0.420, 1400.0 } },
+    { 8192, 16, 64, 1, { 0.740, 0.600, 0.760, 0.600, 2750.0 } },
+};
+const int EnergyTableSize = sizeof(EnergyTable) / sizeof(EnergyTable[0]);
+
+
+double
+log2_ratio(double a, double b)
+{
+    return fabs(log(a / b) / log(2.0));
+}
+
+}       // Anonymous namespace close
+
+
+void
+cache_energy_coeffs(double size_kb, int assoc, int block_bytes, int ports,
+                    CacheEnergyCoeffs *dest)
+{
+    sim_assert((size_kb > 0) && (assoc > 0) && (block_bytes > 0) &&
+               (ports > 0));
+    int best = -1;
+    double best_dist = 0;
+    for (int i = 0; i < EnergyTableSize; ++i) {
+        const EnergyTableEnt& ent = EnergyTable[i];
+        double dist = log2_ratio(size_kb, ent.size_kb) +
+            log2_ratio(assoc, ent.assoc) +
+            log2_ratio(block_bytes, ent.block_bytes) +
+            abs(ports - ent.ports);
+        if ((best < 0) || (dist < best_dist)) {
+            best = i;
+            best_dist = dist;
+        }
+    }
+    const EnergyTableEnt& ent = EnergyTable[best];
+    double port_scale = double(ports) / ent.ports;
+    double dyn_scale = sqrt(size_kb / ent.size_kb) *
+        sqrt(double(assoc) / ent.assoc) *
+        (double(block_bytes) / ent.block_bytes) * port_scale;
+    double leak_scale = (size_kb / ent.size_kb) * port_scale;
+    dest->read_nj = ent.c.read_nj * dyn_scale;
+    dest->write_nj = ent.c.write_nj * dyn_scale;
+    dest->fill_nj = ent.c.fill_nj * dyn_scale;
+    dest->wb_nj = ent.c.wb_nj * dyn_scale;
+    dest->leak_mw = ent.c.leak_mw * leak_scale;
+}
+
+
+CacheEnergyModel::CacheEnergyModel(const string& cfg_path, double size_kb,
+                                   int assoc, int block_bytes_, int ports_,
+                                   i64 now)
+    : block_bytes(block_bytes_), ports(ports_), leak_nj_per_cyc(0),
+      leak_nj_per_block_cyc(0), block_leakage(false), leak_nj(0),
+      leak_charged_cyc(now)
+{
+    clock_mhz = conf_double(cfg_path + "/clock_mhz");
+    if (clock_mhz <= 0) {
+        exit_printf("%s/clock_mhz (%g) must be positive\n", cfg_path.c_str(),
+                    clock_mhz);
+    }
+    set_powered(size_kb, assoc, now);
+    reset_stats(now);
+}
+
+
+void
+CacheEnergyModel::charge_leakage(i64 now)
+{
+    sim_assert(now >= leak_charged_cyc);
+    if (!block_leakage)
+        leak_nj += (now - leak_charged_cyc) * leak_nj_per_cyc;
+    leak_charged_cyc = now;
+}
+
+
+void
+CacheEnergyModel::set_powered(double size_kb, int assoc, i64 now)
+{
+    charge_leakage(now);
+    cache_energy_coeffs(size_kb, assoc, block_bytes, ports, &coeffs);
+    // mW / MHz = nJ per cycle
+    leak_nj_per_cyc = coeffs.leak_mw / clock_mhz;
+    double blocks = (size_kb * 1024) / block_bytes;
+    leak_nj_per_block_cyc = leak_nj_per_cyc / blocks;
+}
+
+
+void
+CacheEnergyModel::set_block_leakage(bool enable, i64 now)
+{
+    charge_leakage(now);
+    block_leakage = enable;
+}
+
+
+void
+CacheEnergyModel::reset_stats(i64 now)
+{
+    dyn_nj = 0;
+    leak_nj = 0;
+    leak_charged_cyc = now;
+    n_reads = n_writes = n_fills = n_wbs = 0;
+}
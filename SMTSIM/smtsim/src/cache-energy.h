@@ -0,0 +1,98 @@
+// -*- C++ -*-
+//
+// Table-driven cache energy model: dynamic energy per bank operation, plus
+// leakage for the powered portion of the array
+//
+
+#ifndef CACHE_ENERGY_H
+#define CACHE_ENERGY_H
+
+#include <string>
+
+
+// Per-operation energies and leakage come from a built-in table of
+// CACTI-style estimates, keyed by (size, associativity, block size, ports).
+// A geometry missing from the table is scaled from the nearest entry (by
+// log-distance): dynamic energy with the square root of the size and
+// associativity ratios and linearly with block size, leakage linearly with
+// size.  Port count scales both linearly.
+//
+// The model is re-derived for the powered geometry whenever it changes, so
+// way-gating and set resizing show up as lower lookup energy and leakage.
+// Leakage is charged lazily: at each geometry change, and when stats are
+// read.  Alternately, with set_block_leakage(), the owner charges leakage
+// itself in units of powered block-cycles (e.g. for cache decay, where only
+// live blocks leak).
+
+
+struct CacheEnergyCoeffs {
+    double read_nj, write_nj, fill_nj, wb_nj;   // per bank op
+    double leak_mw;                             // whole array
+};
+
+
+class CacheEnergyModel {
+public:
+    // Reads "clock_mhz" from config subtree "cfg_path"; the geometry is the
+    // cache's as-created one.
+    CacheEnergyModel(const std::string& cfg_path, double size_kb,
+                     int assoc, int block_bytes, int ports, i64 now);
+
+    // Powered geometry changed at time "now": charge leakage up to now, and
+    // switch coefficients.
+    void set_powered(double size_kb, int assoc, i64 now);
+
+    // Switch to (or from) per-block leakage charging, as of "now"
+    void set_block_leakage(bool enable, i64 now);
+    void charge_block_leakage(double block_cyc) {
+        leak_nj += block_leak_nj(block_cyc);
+    }
+    double block_leak_nj(double block_cyc) const {
+        return block_cyc * leak_nj_per_block_cyc;
+    }
+
+    void note_read() { dyn_nj += coeffs.read_nj; n_reads++; }
+    void note_write() { dyn_nj += coeffs.write_nj; n_writes++; }
+    void note_fill() { dyn_nj += coeffs.fill_nj; n_fills++; }
+    void note_wb() { dyn_nj += coeffs.wb_nj; n_wbs++; }
+
+    void reset_stats(i64 now);
+
+    double g_clock_mhz() const { return clock_mhz; }
+    double g_dyn_nj() const { return dyn_nj; }
+    // (includes the not-yet-charged leakage up to "now")
+    double g_leak_nj(i64 now) const {
+        return (block_leakage) ? leak_nj :
+            (leak_nj + (now - leak_charged_cyc) * leak_nj_per_cyc);
+    }
+    const CacheEnergyCoeffs& g_coeffs() const { return coeffs; }
+    i64 g_reads() const { return n_reads; }
+    i64 g_writes() const { return n_writes; }
+    i64 g_fills() const { return n_fills; }
+    i64 g_wbs() const { return n_wbs; }
+
+private:
+    double clock_mhz;
+    int block_bytes;
+    int ports;
+
+    CacheEnergyCoeffs coeffs;           // for the current powered geometry
+    double leak_nj_per_cyc;             // whole powered array
+    double leak_nj_per_block_cyc;
+    bool block_leakage;                 // owner charges per block-cycle
+
+    double dyn_nj;
+    double leak_nj;                     // charged up to leak_charged_cyc
+    i64 leak_charged_cyc;
+    i64 n_reads, n_writes, n_fills, n_wbs;
+
+    void charge_leakage(i64 now);
+};
+
+
+// Look up (or scale) the coefficients for the given geometry
+void cache_energy_coeffs(double size_kb, int assoc, int block_bytes,
+                         int ports, CacheEnergyCoeffs *dest);
+
+
+#endif  // CACHE_ENERGY_H
@@ -12,15 +12,12 @@ const char RCSid_1035918504[] =
 #include <stdlib.h>
 #include <string.h>
 
-#include <queue>
-#include <map>
-#include <set>
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include "sim-assert.h"
-#include "hash-map.h"
 #include "sys-types.h"
 #include "cache-queue.h"
 #include "sim-params.h"
@@ -31,13 +28,9 @@ const char RCSid_1035918504[] =
 #include "utils-cc.h"
 
 using std::string;
-using std::make_pair;
 using std::vector;
 
 
-#define USE_HASHMAP_NOT_MAP     (1 && HAVE_HASHMAP)
-
-
 const char *CacheQFindSense_names[] = {
     "Miss", "WB", "Coher", "All", NULL
 };
@@ -45,6 +38,20 @@ const char *CacheQFindSense_names[] = {
 
 namespace {
 
+// The timing wheel has one bucket per cycle; it covers WheelBuckets cycles
+// starting at CacheQueue::wheel_base.  Requests outside of that window go
+// in the overflow heap.
+const int WheelBucketsLg = 10;
+const int WheelBuckets = 1 << WheelBucketsLg;
+const int WheelWords = WheelBuckets / 64;       // occupancy bitmap size
+
+// Initial size of the address hash table; must be a power of 2
+const int AddrSlotsInit = 256;
+
+// Values for CacheQueueLinks.where (zero: not enqueued)
+enum CQLocation { CQL_None = 0, CQL_Wheel, CQL_Heap, CQL_Blocked };
+
+
 struct CacheAddrKey {
     LongAddr base_addr;
     int core_id;        // CACHEQ_SHARED for shared outside of cores
@@ -105,134 +112,86 @@ struct CacheAddrKey {
         ostr << "," << CacheQFindSense_names[sense];
         return ostr.str();
     }
-
-    void change_sense(CacheQFindSense new_sense) {
-        sense = new_sense;
-    }
-
-    // be careful: cacheq_find_multi() and minimum_addr_key() know about this
-    // ordering
-    bool operator < (const CacheAddrKey& r2) const {
-        return
-            (base_addr < r2.base_addr) ||
-            ((base_addr == r2.base_addr) && 
-             ((core_id < r2.core_id) ||
-              ((core_id == r2.core_id) && (sense < r2.sense))));
-    }
-    bool operator == (const CacheAddrKey& r2) const {
-        return (base_addr == r2.base_addr) &&
-            (core_id == r2.core_id) &&
-            (sense == r2.sense);
-    }
-    size_t hash() const {
-        StlHashU64 hasher;
-        return base_addr.hash() ^ hasher((core_id << 16) ^ sense);
-    }
 };
 
 
-// Returns a CacheAddrKey K such that no other CacheAddrKey with the same
-// base_addr can compare as less-than K.
-CacheAddrKey
-minimum_addr_key(const LongAddr& base_addr)
+// Compare the (core_id, sense) part of an enqueued request's address key
+// with the given one, as CMP_SCALAR() does.  Each base_addr's chain is kept
+// in this order (then in enqueue order), which is the order that
+// cacheq_find_multi() and cacheq_iter_next() report.
+inline int
+chain_key_cmp(const CacheRequest *creq, int core_id, int sense)
 {
-    // note: CACHEQ_ALL is less than _SHARED, but it's not valid in keys
-    return CacheAddrKey(base_addr, CACHEQ_SHARED, CQFS_Miss);
+    const CacheQueueLinks& links = creq->cq_links;
+    return (links.core_id != core_id) ? CMP_SCALAR(links.core_id, core_id) :
+        CMP_SCALAR(links.sense, sense);
 }
 
 
-struct CacheTimeKey {
-    i64 request_time;
-    i64 serial_num;
-    CacheTimeKey(i64 request_time_, i64 serial_num_)
-        : request_time(request_time_), serial_num(serial_num_)
-    { }
-    CacheTimeKey(const CacheRequest *creq) 
-        : request_time(creq->request_time), serial_num(creq->serial_num)
-    { }
+// Scheduling order: by request_time, then serial_num.  Since serial_num is
+// unique, this is a total order.
+inline bool
+creq_time_before(const CacheRequest *r1, const CacheRequest *r2)
+{
+    return (r1->request_time < r2->request_time) ||
+        ((r1->request_time == r2->request_time) &&
+         (r1->serial_num < r2->serial_num));
+}
 
-    string fmt() const {
-        string result;
-        result += "(";
-        result += fmt_i64(request_time);
-        result += ",";
-        result += fmt_i64(serial_num);
-        result += ")";
-        return result;
-    }
 
-    bool operator < (const CacheTimeKey& k2) const {
-        return
-            (request_time < k2.request_time) ||
-            ((request_time == k2.request_time) &&
-             (serial_num < k2.serial_num));
-    }
-    bool operator == (const CacheTimeKey& k2) const {
-        return (request_time == k2.request_time) &&
-            (serial_num == k2.serial_num);
-    }
-    size_t hash() const {
-        StlHashU64 hasher;
-        return hasher(request_time ^ serial_num);
-    }
-};
+inline bool
+creq_addr_less(const CacheRequest *r1, const CacheRequest *r2)
+{
+    return r1->base_addr < r2->base_addr;
+}
 
 
-// This compares "backwards", to get min-heap behavior out of the standard
-// max-heap priority-queue algorithms.
-struct CacheReqTimeComp {
-    inline bool
-    operator() (const CacheRequest *r1, const CacheRequest *r2) const {
-        return (r1->request_time > r2->request_time) ||
-            ((r1->request_time == r2->request_time) &&
-             (r1->serial_num > r2->serial_num));
-    }
+struct TimeBucket {
+    CacheRequest *head, *tail;          // Linked via cq_links.time_*
 };
 
 
-// We currently keep copies of CacheAddrMap iterators, to allow for easy
-// deletion later.  The hash-based container iterators don't persist; if we
-// used these, deletion would be more of a pain, since we'd have to hunt
-// around for the specific CacheRequest* we're after.  So, we'll always use
-// a non-hashed map<> for CacheAddrMap.  (This can change without mucking
-// up the external API.)
-typedef std::multimap<CacheAddrKey, CacheRequest *> CacheAddrMap;
-
-#if USE_HASHMAP_NOT_MAP
-    typedef hash_map<CacheRequest *, CacheAddrMap::iterator,
-                     StlHashPointerValue<CacheRequest *> > CacheReqRevMap;
-    typedef hash_set<CacheRequest *,
-                     StlHashPointerValue<CacheRequest *> > CacheReqSet;
-#else
-    typedef std::map<CacheRequest *, CacheAddrMap::iterator> CacheReqRevMap;
-    typedef std::set<CacheRequest *> CacheReqSet;
-#endif
-
-// We'll use a map from times to requests instead of priority-queue of
-// requests here, specifically because we want to be able to delete 
-// requests efficiently (which we can do, by searching on time keys).
-//
-// Recall that CacheTimeKeys are unique due to the "serial_num" field of
-// CacheRequest; this gives us a total order (and unique CacheTimeKeys).
-typedef std::map<CacheTimeKey, CacheRequest *> CacheTimeMap;
-
-
 } // Anonymous namespace close
 
 
+// Requests are linked in through their CacheQueueLinks, so enqueue and
+// dequeue don't allocate.  Non-blocked requests are ordered by time with a
+// timing wheel of per-cycle buckets, plus an overflow heap for those
+// outside the wheel's window; there's no need to move requests from the
+// heap to the wheel, since the two are merged when looking for the earliest.
+// For address lookups, each base_addr in the queue has one chain of
+// requests, whose head is kept in an open-addressing hash table.
 struct CacheQueue {
 protected:
-    CacheAddrMap addr_to_req;           // All requests
-    // all_reqs gives us 1) creq uniqueness, 2) easy erase from addr_to_req
-    CacheReqRevMap all_reqs;            // All reqs; iters from addr_to_req
-    CacheTimeMap time_map;              // Non-blocked requests
-    CacheReqSet blocked_reqs;           // Blocked requests
-
-    CacheAddrMap::const_iterator user_iter1;
+    // Timing wheel: non-blocked requests with request_time in
+    // [wheel_base, wheel_base + WheelBuckets), in bucket (time % buckets).
+    // Each bucket then holds just one time, in serial_num order.
+    i64 wheel_base;
+    int wheel_count;
+    TimeBucket wheel[WheelBuckets];
+    u64 wheel_occupied[WheelWords];     // Bitmap: non-empty buckets
+
+    // Overflow min-heap in scheduling order, of the other non-blocked
+    // requests; each request's cq_links.heap_idx tracks its position.
+    vector<CacheRequest *> overflow;
+
+    // Hash table of address chain heads (linear probing, NULL: empty slot)
+    vector<CacheRequest *> addr_slots;
+    int addr_slot_mask;
+    int addr_chain_count;               // Non-empty slots
+
+    int total_count;                    // All requests
+    int blocked_count;                  // Blocked requests
+
+    // Iteration: snapshot of all requests, taken at iter_reset()
+    vector<CacheRequest *> iter_reqs;
+    int iter_pos;
 
     bool invariant() const {
-        return (addr_to_req.size() == all_reqs.size()) &&
-            ((time_map.size() + blocked_reqs.size()) == all_reqs.size());
+        return (wheel_count >= 0) && (blocked_count >= 0) &&
+            ((wheel_count + intsize(overflow) + blocked_count) ==
+             total_count) &&
+            (addr_chain_count <= total_count);
     }
 
 private:
@@ -240,147 +199,473 @@ private:
     CacheQueue(const CacheQueue& src);
     CacheQueue& operator = (const CacheQueue &src);
 
+    void wheel_insert(CacheRequest *creq);
+    void wheel_remove(CacheRequest *creq);
+    const CacheRequest *wheel_first() const;
+    void heap_set(int idx, CacheRequest *creq) {
+        overflow[idx] = creq;
+        creq->cq_links.heap_idx = idx;
+    }
+    void heap_sift_up(int idx);
+    void heap_sift_down(int idx);
+    void heap_insert(CacheRequest *creq);
+    void heap_remove(CacheRequest *creq);
+    void time_insert(CacheRequest *creq);
+    void time_remove(CacheRequest *creq);
+    const CacheRequest *earliest() const;
+
+    int addr_home_slot(const LongAddr& base_addr) const {
+        return static_cast<int>(base_addr.hash()) & addr_slot_mask;
+    }
+    int addr_slot_find(const LongAddr& base_addr) const;
+    int addr_slot_claim(const LongAddr& base_addr);
+    void addr_slot_erase(int slot);
+    void addr_slots_grow();
+    void addr_insert(CacheRequest *creq, const CacheAddrKey& addr_key);
+    void addr_remove(CacheRequest *creq);
+    const CacheRequest *addr_chain(const LongAddr& base_addr) const {
+        int slot = addr_slot_find(base_addr);
+        return (slot >= 0) ? addr_slots[slot] : NULL;
+    }
+    void remove_req(CacheRequest *creq);
+
 public:
-    CacheQueue() {
+    CacheQueue()
+        : wheel_base(0), wheel_count(0),
+          addr_slots(AddrSlotsInit, static_cast<CacheRequest *>(NULL)),
+          addr_slot_mask(AddrSlotsInit - 1), addr_chain_count(0),
+          total_count(0), blocked_count(0), iter_pos(0) {
+        for (int i = 0; i < WheelBuckets; ++i)
+            wheel[i].head = wheel[i].tail = NULL;
+        for (int i = 0; i < WheelWords; ++i)
+            wheel_occupied[i] = 0;
         sim_assert(invariant());
     }
     ~CacheQueue() { }
 
     int empty() const {
         sim_assert(invariant());
-        return time_map.empty();
+        return (wheel_count + intsize(overflow)) == 0;
     }
 
-    void enqueue(CacheRequest *creq) {
-        const char *fname = "CacheQueue::enqueue";
-        CacheAddrKey addr_key(creq);
-        sim_assert(creq->serial_num >= 0);
+    void enqueue(CacheRequest *creq);
+    CacheRequest *dequeue_ready(i64 now);
+
+    i64 next_time() const {
         sim_assert(invariant());
+        const CacheRequest *first = earliest();
+        return (first) ? first->request_time : I64_MAX;
+    }
+
+    void dequeue(CacheRequest *creq);
+    void dequeue_blocked(CacheRequest *creq);
+
+    CacheRequest *find(const LongAddr& base_addr, int core_id, 
+                       CacheQFindSense sense) const;
+    CacheRequest **find_multi(const LongAddr& base_addr, int core_id, 
+                              CacheQFindSense sense) const;
+
+    void iter_reset();
+
+    CacheRequest *iter_next() {
+        return (iter_pos < intsize(iter_reqs)) ? iter_reqs[iter_pos++] : NULL;
+    }
+};
+
+
+void
+CacheQueue::wheel_insert(CacheRequest *creq)
+{
+    const int bucket_idx = int(creq->request_time & (WheelBuckets - 1));
+    TimeBucket& bucket = wheel[bucket_idx];
+    CacheQueueLinks& links = creq->cq_links;
+
+    // serial_num counts up at each enqueue, so this is normally an append
+    CacheRequest *after = bucket.tail;
+    while (after && (after->serial_num > creq->serial_num))
+        after = after->cq_links.time_prev;
+    links.time_prev = after;
+    links.time_next = (after) ? after->cq_links.time_next : bucket.head;
+    if (links.time_next) {
+        links.time_next->cq_links.time_prev = creq;
+    } else {
+        bucket.tail = creq;
+    }
+    if (after) {
+        after->cq_links.time_next = creq;
+    } else {
+        bucket.head = creq;
+    }
+    links.where = CQL_Wheel;
+    wheel_occupied[bucket_idx / 64] |= SET_BIT_64(bucket_idx % 64);
+    wheel_count++;
+}
+
+
+void
+CacheQueue::wheel_remove(CacheRequest *creq)
+{
+    const int bucket_idx = int(creq->request_time & (WheelBuckets - 1));
+    TimeBucket& bucket = wheel[bucket_idx];
+    CacheQueueLinks& links = creq->cq_links;
+    sim_assert(links.where == CQL_Wheel);
+    if (links.time_prev) {
+        links.time_prev->cq_links.time_next = links.time_next;
+    } else {
+        sim_assert(bucket.head == creq);
+        bucket.head = links.time_next;
+    }
+    if (links.time_next) {
+        links.time_next->cq_links.time_prev = links.time_prev;
+    } else {
+        sim_assert(bucket.tail == creq);
+        bucket.tail = links.time_prev;
+    }
+    if (!bucket.head)
+        wheel_occupied[bucket_idx / 64] &= ~SET_BIT_64(bucket_idx % 64);
+    links.time_prev = links.time_next = NULL;
+    wheel_count--;
+}
 
-        if (addr_key.must_be_unique()) {
-            CacheRequest **dupe = map_find(addr_to_req, addr_key);
-            if (dupe) {
-                string first_req(fmt_creq_static(*dupe));
-                string new_req(fmt_creq_static(creq));
-                abort_printf("%s: duplicate request for unique key (%s)\n"
-                             "existing creq: %s\nnew creq: %s\n", fname,
-                             addr_key.fmt().c_str(), first_req.c_str(),
-                             new_req.c_str());
-            }
-        }
 
-        CacheAddrMap::iterator addr_map_iter = 
-            addr_to_req.insert(make_pair(addr_key, creq));
-        if (!all_reqs.insert(make_pair(creq, addr_map_iter)).second) { 
-            abort_printf("%s: cache request %p already in all_reqs; %s\n",
-                         fname, (void *) creq, fmt_creq_static(creq));
+// The earliest request in the wheel, or NULL if it's empty: the head of the
+// first non-empty bucket at or after wheel_base (circularly).
+const CacheRequest *
+CacheQueue::wheel_first() const
+{
+    if (!wheel_count)
+        return NULL;
+    const int start_idx = int(wheel_base & (WheelBuckets - 1));
+    int word = start_idx / 64;
+    // (bits below start_idx are the latest times; they're checked last,
+    // when we wrap back around to this word)
+    u64 bits = wheel_occupied[word] & ~(SET_BIT_64(start_idx % 64) - 1);
+    for (int i = 0; i <= WheelWords; ++i) {
+        if (bits) {
+            const int bucket_idx = (word * 64) + LOWEST_BIT_64(bits);
+            sim_assert(wheel[bucket_idx].head != NULL);
+            return wheel[bucket_idx].head;
         }
+        word = (word + 1) % WheelWords;
+        bits = wheel_occupied[word];
+    }
+    abort_printf("CacheQueue::wheel_first: wheel_count %d, but no buckets "
+                 "occupied\n", wheel_count);
+    return NULL;
+}
+
+
+void
+CacheQueue::heap_sift_up(int idx)
+{
+    CacheRequest *creq = overflow[idx];
+    while (idx > 0) {
+        const int parent = (idx - 1) / 2;
+        if (!creq_time_before(creq, overflow[parent]))
+            break;
+        heap_set(idx, overflow[parent]);
+        idx = parent;
+    }
+    heap_set(idx, creq);
+}
+
+
+void
+CacheQueue::heap_sift_down(int idx)
+{
+    const int n = intsize(overflow);
+    CacheRequest *creq = overflow[idx];
+    for (;;) {
+        int child = (2 * idx) + 1;
+        if (child >= n)
+            break;
+        if (((child + 1) < n) &&
+            creq_time_before(overflow[child + 1], overflow[child]))
+            child++;
+        if (!creq_time_before(overflow[child], creq))
+            break;
+        heap_set(idx, overflow[child]);
+        idx = child;
+    }
+    heap_set(idx, creq);
+}
+
 
-        if (creq->blocked) {
-            if (!blocked_reqs.insert(creq).second) {
-                abort_printf("duplicate blocked cache_request %p, "
-                             "shouldn't be possible: %s\n", (void *) creq,
-                             fmt_creq_static(creq));
-            }
+void
+CacheQueue::heap_insert(CacheRequest *creq)
+{
+    creq->cq_links.where = CQL_Heap;
+    overflow.push_back(creq);
+    heap_sift_up(intsize(overflow) - 1);
+}
+
+
+void
+CacheQueue::heap_remove(CacheRequest *creq)
+{
+    const int idx = creq->cq_links.heap_idx;
+    sim_assert(creq->cq_links.where == CQL_Heap);
+    sim_assert((idx >= 0) && (idx < intsize(overflow)) &&
+               (overflow[idx] == creq));
+    CacheRequest *last = overflow.back();
+    overflow.pop_back();
+    if (last != creq) {
+        heap_set(idx, last);
+        if ((idx > 0) && creq_time_before(last, overflow[(idx - 1) / 2])) {
+            heap_sift_up(idx);
         } else {
-            time_map.insert(make_pair(CacheTimeKey(creq), creq));
+            heap_sift_down(idx);
         }
-        sim_assert(invariant());
     }
+    creq->cq_links.heap_idx = -1;
+}
 
-    CacheRequest *dequeue_ready(i64 now) {
-        CacheRequest *result = NULL;
-        sim_assert(invariant());
-        if (!time_map.empty()) {
-            CacheTimeMap::iterator earliest = time_map.begin();
-            CacheRequest *creq = earliest->second;
-            sim_assert(!creq->blocked);
-            if (creq->request_time <= now) {
-                result = creq;
-                CacheReqRevMap::iterator rev_found = all_reqs.find(creq);
-                if (rev_found != all_reqs.end()) {
-                    addr_to_req.erase(rev_found->second);
-                    all_reqs.erase(rev_found);
-                } else {
-                    abort_printf("cache req %p dequeued, but not in "
-                                 "all_reqs: %s\n",
-                                 (void *) creq, fmt_creq_static(creq));
-                }
-                time_map.erase(earliest);
-            }
-            sim_assert(invariant());
-        }
-        return result;
+
+void
+CacheQueue::time_insert(CacheRequest *creq)
+{
+    const i64 req_time = creq->request_time;
+    if ((req_time >= wheel_base) && (req_time < (wheel_base + WheelBuckets))) {
+        wheel_insert(creq);
+    } else {
+        heap_insert(creq);
     }
+}
 
-    void dequeue(CacheRequest *creq);
 
-    void dequeue_blocked(CacheRequest *creq)
-    {
-        sim_assert(invariant());
-        sim_assert(blocked_reqs.count(creq));
-        sim_assert(creq->blocked);
-        CacheReqRevMap::iterator rev_found = all_reqs.find(creq);
-        if (rev_found != all_reqs.end()) {
-            addr_to_req.erase(rev_found->second);
-            all_reqs.erase(rev_found);
-        } else {
-            abort_printf("cache req %p dequeued, but not in "
-                         "all_reqs: %s\n",
-                         (void *) creq, fmt_creq_static(creq));
+void
+CacheQueue::time_remove(CacheRequest *creq)
+{
+    switch (creq->cq_links.where) {
+    case CQL_Wheel:
+        wheel_remove(creq);
+        break;
+    case CQL_Heap:
+        heap_remove(creq);
+        break;
+    default:
+        abort_printf("cache req %p dequeued, but not time-ordered "
+                     "(location %d): %s\n", (void *) creq,
+                     creq->cq_links.where, fmt_creq_static(creq));
+    }
+}
+
+
+// The earliest non-blocked request, or NULL if there are none
+const CacheRequest *
+CacheQueue::earliest() const
+{
+    const CacheRequest *first = wheel_first();
+    if (!overflow.empty() &&
+        (!first || creq_time_before(overflow[0], first)))
+        first = overflow[0];
+    return first;
+}
+
+
+// The slot holding the chain for "base_addr", or -1 if there's none
+int
+CacheQueue::addr_slot_find(const LongAddr& base_addr) const
+{
+    int slot = addr_home_slot(base_addr);
+    const CacheRequest *head;
+    while ((head = addr_slots[slot]) != NULL) {
+        if (head->base_addr == base_addr)
+            return slot;
+        slot = (slot + 1) & addr_slot_mask;
+    }
+    return -1;
+}
+
+
+// The empty slot at which a new chain for "base_addr" should start (which
+// must not already be present)
+int
+CacheQueue::addr_slot_claim(const LongAddr& base_addr)
+{
+    // Keep the load factor at or below 1/2
+    if ((2 * (addr_chain_count + 1)) > intsize(addr_slots))
+        addr_slots_grow();
+    int slot = addr_home_slot(base_addr);
+    while (addr_slots[slot] != NULL) {
+        sim_assert(!(addr_slots[slot]->base_addr == base_addr));
+        slot = (slot + 1) & addr_slot_mask;
+    }
+    return slot;
+}
+
+
+// Empty the given slot, moving later members of its probe run back into the
+// gap as needed, so that addr_slot_find() never stops short.
+void
+CacheQueue::addr_slot_erase(int slot)
+{
+    int hole = slot;
+    int scan = slot;
+    for (;;) {
+        scan = (scan + 1) & addr_slot_mask;
+        CacheRequest *head = addr_slots[scan];
+        if (!head)
+            break;
+        const int home = addr_home_slot(head->base_addr);
+        // "head" may fill the hole unless its home is cyclically in
+        // (hole, scan]
+        const bool home_after_hole = (hole <= scan) ?
+            ((home > hole) && (home <= scan)) :
+            ((home > hole) || (home <= scan));
+        if (!home_after_hole) {
+            addr_slots[hole] = head;
+            hole = scan;
         }
-        sim_assert(blocked_reqs.count(creq));
-        blocked_reqs.erase(creq);
-        sim_assert(invariant());
     }
+    addr_slots[hole] = NULL;
+    addr_chain_count--;
+}
 
-    CacheRequest *find(const LongAddr& base_addr, int core_id, 
-                       CacheQFindSense sense) const {
-        CacheRequest *result = NULL;
-        sim_assert(core_id != CACHEQ_ALL_CORES);
-        sim_assert(sense != CQFS_All);
-        sim_assert(sense != CQFS_WB);
-        CacheAddrKey addr_key(base_addr, core_id, sense);
-        // try to exclude queries which could return multiple matches
-        sim_assert(addr_key.must_be_unique());
-        CacheAddrMap::const_iterator found = addr_to_req.find(addr_key);
-        if (found != addr_to_req.end()) {
-            result = found->second;
-            // ensure there's not a duplicate match
-            ++found;
-            if ((found != addr_to_req.end()) &&
-                (found->first == addr_key)) {
-                // oh, we've done it now: there are multiple matching requests,
-                // but the caller is only semantically equipped to handle one
-                string first_req(fmt_creq_static(result));
-                string second_req(fmt_creq_static(found->second));
-                abort_printf("cacheq_find(): multiple matches for "
-                             "key %s; first two:\n%s\n%s\n",
-                             addr_key.fmt().c_str(), first_req.c_str(),
-                             second_req.c_str());
-            }
+
+void
+CacheQueue::addr_slots_grow()
+{
+    vector<CacheRequest *> old_slots(2 * addr_slots.size(),
+                                     static_cast<CacheRequest *>(NULL));
+    old_slots.swap(addr_slots);
+    addr_slot_mask = intsize(addr_slots) - 1;
+    for (int i = 0; i < intsize(old_slots); ++i) {
+        CacheRequest *head = old_slots[i];
+        if (head) {
+            int slot = addr_home_slot(head->base_addr);
+            while (addr_slots[slot] != NULL)
+                slot = (slot + 1) & addr_slot_mask;
+            addr_slots[slot] = head;
         }
-        return result;
     }
+}
 
-    CacheRequest **find_multi(const LongAddr& base_addr, int core_id, 
-                              CacheQFindSense sense) const;
 
-    void iter_reset() {
-        user_iter1 = addr_to_req.begin();
+// Link a request into its address chain, after any others with the same
+// key; aborts on duplicates of unique keys.
+void
+CacheQueue::addr_insert(CacheRequest *creq, const CacheAddrKey& addr_key)
+{
+    CacheQueueLinks& links = creq->cq_links;
+    links.core_id = addr_key.core_id;
+    links.sense = addr_key.sense;
+
+    int slot = addr_slot_find(addr_key.base_addr);
+    if (slot < 0) {
+        slot = addr_slot_claim(addr_key.base_addr);
+        links.addr_next = NULL;
+        addr_slots[slot] = creq;
+        addr_chain_count++;
+        return;
     }
 
-    CacheRequest *iter_next() {
-        CacheRequest *result;
-        if (user_iter1 != addr_to_req.end()) {
-            result = user_iter1->second;
-            ++user_iter1;
-        } else {
-            result = NULL;
+    CacheRequest *prev = NULL, *scan = addr_slots[slot];
+    int cmp;
+    while (scan && ((cmp = chain_key_cmp(scan, links.core_id,
+                                         links.sense)) <= 0)) {
+        if ((cmp == 0) && addr_key.must_be_unique()) {
+            string first_req(fmt_creq_static(scan));
+            string new_req(fmt_creq_static(creq));
+            abort_printf("CacheQueue::enqueue: duplicate request for unique "
+                         "key (%s)\nexisting creq: %s\nnew creq: %s\n",
+                         addr_key.fmt().c_str(), first_req.c_str(),
+                         new_req.c_str());
         }
-        return result;
+        prev = scan;
+        scan = scan->cq_links.addr_next;
     }
-};
+    links.addr_next = scan;
+    if (prev) {
+        prev->cq_links.addr_next = creq;
+    } else {
+        addr_slots[slot] = creq;
+    }
+}
+
+
+void
+CacheQueue::addr_remove(CacheRequest *creq)
+{
+    const int slot = addr_slot_find(creq->base_addr);
+    CacheRequest *prev = NULL;
+    CacheRequest *scan = (slot >= 0) ? addr_slots[slot] : NULL;
+    while (scan && (scan != creq)) {
+        prev = scan;
+        scan = scan->cq_links.addr_next;
+    }
+    if (!scan) {
+        abort_printf("cache req %p dequeued, but not in its address "
+                     "chain: %s\n", (void *) creq, fmt_creq_static(creq));
+    }
+    if (prev) {
+        prev->cq_links.addr_next = creq->cq_links.addr_next;
+    } else if (creq->cq_links.addr_next) {
+        addr_slots[slot] = creq->cq_links.addr_next;
+    } else {
+        addr_slot_erase(slot);
+    }
+    creq->cq_links.addr_next = NULL;
+}
+
+
+// Common tail of the dequeue operations, once "creq" is out of the time
+// ordering (if it was ever in it)
+void
+CacheQueue::remove_req(CacheRequest *creq)
+{
+    addr_remove(creq);
+    creq->cq_links.where = CQL_None;
+    total_count--;
+    sim_assert(invariant());
+}
+
+
+void
+CacheQueue::enqueue(CacheRequest *creq)
+{
+    const char *fname = "CacheQueue::enqueue";
+    CacheAddrKey addr_key(creq);
+    sim_assert(creq->serial_num >= 0);
+    sim_assert(invariant());
+
+    if (creq->cq_links.where != CQL_None) {
+        abort_printf("%s: cache request %p already enqueued; %s\n",
+                     fname, (void *) creq, fmt_creq_static(creq));
+    }
+
+    addr_insert(creq, addr_key);
+    creq->cq_links.heap_idx = -1;
+    if (creq->blocked) {
+        creq->cq_links.where = CQL_Blocked;
+        creq->cq_links.time_prev = creq->cq_links.time_next = NULL;
+        blocked_count++;
+    } else {
+        time_insert(creq);
+    }
+    total_count++;
+    sim_assert(invariant());
+}
+
+
+CacheRequest *
+CacheQueue::dequeue_ready(i64 now)
+{
+    sim_assert(invariant());
+    CacheRequest *creq = const_cast<CacheRequest *>(earliest());
+    if (creq && (creq->request_time <= now)) {
+        sim_assert(!creq->blocked);
+        time_remove(creq);
+        remove_req(creq);
+        return creq;
+    }
+    // Nothing is ready by "now", so every request in the wheel is later; we
+    // can slide the wheel's window up to "now", making room for later
+    // requests there, rather than in the overflow heap.
+    if (now > wheel_base)
+        wheel_base = now;
+    return NULL;
+}
 
 
 void
@@ -390,66 +675,74 @@ CacheQueue::dequeue(CacheRequest *creq)
         dequeue_blocked(creq);
     } else {
         sim_assert(invariant());
-        CacheReqRevMap::iterator rev_found = all_reqs.find(creq);
-        if (rev_found != all_reqs.end()) {
-            addr_to_req.erase(rev_found->second);
-            all_reqs.erase(rev_found);
-        } else {
-            abort_printf("cache req %p dequeued, but not in "
-                         "all_reqs: %s\n",
-                         (void *) creq, fmt_creq_static(creq));
-        }
-        CacheTimeMap::iterator time_found = time_map.find(CacheTimeKey(creq));
-        if (time_found != time_map.end()) {
-            time_map.erase(time_found);
-        } else {
-            abort_printf("cache req %p dequeued, but not in "
-                         "time_map: %s\n",
-                         (void *) creq, fmt_creq_static(creq));
-        }
-        sim_assert(invariant());
+        time_remove(creq);
+        remove_req(creq);
     }
 }
 
 
+void
+CacheQueue::dequeue_blocked(CacheRequest *creq)
+{
+    sim_assert(invariant());
+    sim_assert(creq->cq_links.where == CQL_Blocked);
+    sim_assert(creq->blocked);
+    blocked_count--;
+    remove_req(creq);
+}
+
+
+CacheRequest *
+CacheQueue::find(const LongAddr& base_addr, int core_id, 
+                 CacheQFindSense sense) const
+{
+    sim_assert(core_id != CACHEQ_ALL_CORES);
+    sim_assert(sense != CQFS_All);
+    sim_assert(sense != CQFS_WB);
+    CacheAddrKey addr_key(base_addr, core_id, sense);
+    // try to exclude queries which could return multiple matches
+    sim_assert(addr_key.must_be_unique());
+
+    const CacheRequest *scan = addr_chain(base_addr);
+    int cmp = 1;
+    while (scan && ((cmp = chain_key_cmp(scan, core_id, sense)) < 0))
+        scan = scan->cq_links.addr_next;
+    if (!scan || (cmp != 0))
+        return NULL;
+
+    // ensure there's not a duplicate match
+    const CacheRequest *next = scan->cq_links.addr_next;
+    if (next && (chain_key_cmp(next, core_id, sense) == 0)) {
+        // oh, we've done it now: there are multiple matching requests,
+        // but the caller is only semantically equipped to handle one
+        string first_req(fmt_creq_static(scan));
+        string second_req(fmt_creq_static(next));
+        abort_printf("cacheq_find(): multiple matches for "
+                     "key %s; first two:\n%s\n%s\n",
+                     addr_key.fmt().c_str(), first_req.c_str(),
+                     second_req.c_str());
+    }
+    return const_cast<CacheRequest *>(scan);
+}
+
+
 CacheRequest **
 CacheQueue::find_multi(const LongAddr& base_addr, int core_id, 
                        CacheQFindSense sense) const
 {
     vector<CacheRequest *> found;
-    bool use_wildcard = (core_id == CACHEQ_ALL_CORES) ||
-        ((sense == CQFS_All) || (sense == CQFS_WB));
-    // (we treat CQFS_WB as a wildcard here, since we don't enforce any
-    // uniqueness critera on them)
-
-    if (use_wildcard) {
-        // we have a few options here: we could do individual
-        // addr_to_req.find() calls for each possible requested core/sense.
-        // since we're already using an ordered multimap<>, we can also find
-        // the "lowest" key with matching base_addr, and then step through the
-        // cores/senses present for that address and pick out the ones we
-        // want.  We'll do the latter since it's simpler; we can revisit this
-        // later if need be, without changing the API.
-        CacheAddrKey addr_key = minimum_addr_key(base_addr);
-        CacheAddrMap::const_iterator iter = addr_to_req.lower_bound(addr_key);
-        for (; (iter != addr_to_req.end()) &&
-                 (iter->first.base_addr == base_addr); ++iter) {
-            bool match = 
-                ((core_id == CACHEQ_ALL_CORES) ||
-                 (iter->first.core_id == core_id)) &&
-                ((sense == CQFS_All) ||
-                 (iter->first.sense == sense));
-            if (match)
-                found.push_back(iter->second);
-            
-        }
-    } else {
-        CacheAddrKey addr_key(base_addr, core_id, sense);
-        CacheAddrMap::const_iterator iter = addr_to_req.lower_bound(addr_key);
-        CacheAddrMap::const_iterator last = addr_to_req.upper_bound(addr_key);
-        for (; iter != last; ++iter) {
-            found.push_back(iter->second);
-        }
+
+    // The chain holds just this base_addr, in key order, so wildcard and
+    // exact searches are the same scan.  (We treat CQFS_WB as a wildcard
+    // here, since we don't enforce any uniqueness critera on them.)
+    for (const CacheRequest *scan = addr_chain(base_addr); scan;
+         scan = scan->cq_links.addr_next) {
+        const CacheQueueLinks& links = scan->cq_links;
+        bool match = 
+            ((core_id == CACHEQ_ALL_CORES) || (links.core_id == core_id)) &&
+            ((sense == CQFS_All) || (links.sense == sense));
+        if (match)
+            found.push_back(const_cast<CacheRequest *>(scan));
     }
 
     CacheRequest **result = static_cast<CacheRequest **>
@@ -462,6 +755,29 @@ CacheQueue::find_multi(const LongAddr& base_addr, int core_id,
 }
 
 
+// Iteration is in address-key order: by base_addr, then along each chain.
+void
+CacheQueue::iter_reset()
+{
+    vector<CacheRequest *> heads;
+    heads.reserve(addr_chain_count);
+    for (int i = 0; i < intsize(addr_slots); ++i) {
+        if (addr_slots[i])
+            heads.push_back(addr_slots[i]);
+    }
+    sim_assert(intsize(heads) == addr_chain_count);
+    std::sort(heads.begin(), heads.end(), creq_addr_less);
+    iter_reqs.clear();
+    iter_pos = 0;
+    for (int i = 0; i < intsize(heads); ++i) {
+        for (CacheRequest *scan = heads[i]; scan;
+             scan = scan->cq_links.addr_next)
+            iter_reqs.push_back(scan);
+    }
+    sim_assert(intsize(iter_reqs) == total_count);
+}
+
+
 //
 // C interface
 //
@@ -498,6 +814,12 @@ cacheq_dequeue_ready(CacheQueue *cq, i64 now)
     return cq->dequeue_ready(now);
 }
 
+i64
+cacheq_next_time(const CacheQueue *cq)
+{
+    return cq->next_time();
+}
+
 void
 cacheq_dequeue(CacheQueue *cq, struct CacheRequest *creq)
 {
@@ -38,6 +38,12 @@ void cacheq_enqueue(CacheQueue *cq, struct CacheRequest *creq);
 struct CacheRequest *
 cacheq_dequeue_ready(CacheQueue *cq, i64 now);
 
+/*
+ * The time of the earliest non-blocked request, or I64_MAX if there are
+ * none; cacheq_dequeue_ready() returns NULL for any earlier "now".
+ */
+i64 cacheq_next_time(const CacheQueue *cq);
+
 // Remove a given request from the cache queue.  It must be present.
 void cacheq_dequeue(CacheQueue *cq, struct CacheRequest *creq);
 
@@ -60,11 +66,11 @@ void cacheq_dequeue_blocked(CacheQueue *cq, struct CacheRequest *creq);
 // WB->Miss ordering, so multiple outstanding WBs are possible.  WB->Coher
 // ordering is achieved coarsely through cache "port synchronization".)
 
-// warning: minimum_addr_key() relies on CACHEQ_ value order
+// note: cacheq_find_multi() and iteration report in CACHEQ_ value order
 #define CACHEQ_SHARED -1
 #define CACHEQ_ALL_CORES -2     // matches all cores, plus CACHEQ_SHARED
 
-// warning: minimum_addr_key() relies on CQFS_ value order
+// note: cacheq_find_multi() and iteration report in CQFS_ value order
 typedef enum { 
     CQFS_Miss,          // Serving some sort of miss (0,1 only)
     CQFS_WB,            // Outbound writeback (currently not unique)
@@ -84,8 +90,8 @@ cacheq_find(CacheQueue *cq, LongAddr base_addr, int core_id,
 // terminated with a NULL pointer.  The return value is malloc()d, and must be
 // free()d by the caller.
 //
-// This is more expensive than cacheq_find(), particularly when wildcards
-// are used.
+// Matches are returned ordered by core_id, then sense, then enqueue order.
+// This is more expensive than cacheq_find(), mainly due to the malloc().
 struct CacheRequest **
 cacheq_find_multi(CacheQueue *cq, LongAddr base_addr, int core_id, 
                   CacheQFindSense sense);
@@ -94,7 +100,8 @@ cacheq_find_multi(CacheQueue *cq, LongAddr base_addr, int core_id,
 /*
  * Each CacheQueue has one iterator.  cacheq_iter_reset() resets it.
  * cacheq_iter_next() returns a different queue entry each time it is called,
- * or NULL when all entries are exhausted.
+ * or NULL when all entries are exhausted.  Entries are visited by base_addr,
+ * then as for cacheq_find_multi().
  *
  * Do not modify the queue while iterating over it.
  */
@@ -48,6 +48,19 @@ typedef struct CacheRequestCore {
 } CacheRequestCore;
 
 
+// Intrusive links for the CacheQueue holding a request (cache-queue.cc);
+// private to that code.  All-zero means "not enqueued".
+typedef struct CacheQueueLinks {
+    int where;                          // Queue-private location code
+    int heap_idx;                       // Index in overflow heap, if there
+    int core_id;                        // Address key, as of enqueue
+    int sense;                          //   "
+    struct CacheRequest *addr_next;     // Same base_addr, in key order
+    struct CacheRequest *time_prev;     // Same timing-wheel bucket,
+    struct CacheRequest *time_next;     //   in serial_num order
+} CacheQueueLinks;
+
+
 // If you add or change fields/semantics, be sure to update creq_invariant()
 typedef struct CacheRequest {
     i64 request_time;           /* Earliest time this request can _begin_ */
@@ -90,6 +103,8 @@ typedef struct CacheRequest {
     // indicate whether any peer has supplied a copy of that data.
     int coher_data_seen;
 
+    CacheQueueLinks cq_links;           // Private to CacheQueue
+
     // If you add or change fields/semantics, update creq_invariant()
 } CacheRequest;
 
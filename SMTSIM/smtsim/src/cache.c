@@ -76,7 +76,9 @@ which contains the following copyright:
 #include "mem-unit.h"
 #include "prefetch-streambuf.h"
 #include "deadblock-pred.h"
+#include "phase-tracker.h"
 #include "mshr.h"
+#include "callback-queue.h"
 
 
 #define DEBUG 1
@@ -2621,6 +2623,13 @@ process_cache_queues(void)
 }
 
 
+i64
+cachesim_next_event_time(void)
+{
+    return cacheq_next_time(CacheQ);
+}
+
+
 // non-modifying helper function: for a CacheRequest, including along its
 // dependent_coher chain, compute and return the union of all L1-related
 // CacheSource members for a given core.
@@ -3340,6 +3349,18 @@ dodaccess(mem_addr addr, int is_write, context *ctx,
 }
 
 
+// The timing "cache" is actually using (see cache_get_timing()), which may
+// come from its latency table; "config" if there is no such cache
+static CacheTiming
+timing_in_effect(const CacheArray *cache, const CacheTiming *config)
+{
+    CacheTiming timing = *config;
+    if (cache)
+        cache_get_timing(cache, &timing);
+    return timing;
+}
+
+
 // Report best-case (contention-free) data-access latencies, for hits at
 // various levels in the cache hierarchy.  Latencies are measured from the
 // start of the cycle an address becomes available to the memory subsystem, to
@@ -3354,43 +3375,51 @@ dodaccess(mem_addr addr, int is_write, context *ctx,
 static void
 report_hit_latencies(const CoreResources *core, const char *pref)
 {
+    const int private_l2 = GlobalParams.mem.private_l2caches;
+    const CacheTiming d_tm =
+        timing_in_effect(core->dcache, &core->params.dcache.timing);
+    const CacheTiming l2_tm = (private_l2) ?
+        timing_in_effect(core->l2cache, &core->params.private_l2cache.timing) :
+        timing_in_effect(SharedL2Cache, &GlobalParams.mem.l2cache_timing);
+    const CacheTiming l3_tm =
+        timing_in_effect(SharedL3Cache, &GlobalParams.mem.l3cache_timing);
     int lat = 0;
-    lat += core->params.dcache.timing.access_time.latency;
+    lat += d_tm.access_time.latency;
     printf("%sHit times (excluding exec) from: L1=%d", pref, lat);
-    lat += core->params.dcache.timing.miss_penalty;
-    if (GlobalParams.mem.private_l2caches) {
-        lat += core->params.private_l2cache.timing.access_time.latency;
+    lat += d_tm.miss_penalty;
+    if (private_l2) {
+        lat += l2_tm.access_time.latency;
     } else {
         lat += GlobalParams.mem.bus_request_time.latency;
-        lat += GlobalParams.mem.l2cache_timing.access_time.latency;
+        lat += l2_tm.access_time.latency;
         lat += GlobalParams.mem.bus_transfer_time.latency;
     }
-    lat += core->params.dcache.timing.fill_time.latency;
+    lat += d_tm.fill_time.latency;
     printf(", L2=%d", lat);
     if (GlobalParams.mem.use_l3cache) {
-        if (GlobalParams.mem.private_l2caches) {
-            lat += core->params.private_l2cache.timing.miss_penalty;
+        if (private_l2) {
+            lat += l2_tm.miss_penalty;
             lat += GlobalParams.mem.bus_request_time.latency;
-            lat += GlobalParams.mem.l3cache_timing.access_time.latency;
+            lat += l3_tm.access_time.latency;
             lat += GlobalParams.mem.bus_transfer_time.latency;
-            lat += core->params.private_l2cache.timing.fill_time.latency;
+            lat += l2_tm.fill_time.latency;
         } else {
-            lat += GlobalParams.mem.l2cache_timing.miss_penalty;
-            lat += GlobalParams.mem.l3cache_timing.access_time.latency;
-            lat += GlobalParams.mem.l2cache_timing.fill_time.latency;
+            lat += l2_tm.miss_penalty;
+            lat += l3_tm.access_time.latency;
+            lat += l2_tm.fill_time.latency;
         }
         printf(", L3=%d", lat);
-        lat += GlobalParams.mem.l3cache_timing.miss_penalty;
-        lat += GlobalParams.mem.l3cache_timing.fill_time.latency;
+        lat += l3_tm.miss_penalty;
+        lat += l3_tm.fill_time.latency;
     } else {
-        if (GlobalParams.mem.private_l2caches) {
+        if (private_l2) {
             lat += GlobalParams.mem.bus_request_time.latency;
-            lat += core->params.private_l2cache.timing.miss_penalty;
+            lat += l2_tm.miss_penalty;
             lat += GlobalParams.mem.bus_transfer_time.latency;
-            lat += core->params.private_l2cache.timing.fill_time.latency;
+            lat += l2_tm.fill_time.latency;
         } else {
-            lat += GlobalParams.mem.l2cache_timing.miss_penalty;
-            lat += GlobalParams.mem.l2cache_timing.fill_time.latency;
+            lat += l2_tm.miss_penalty;
+            lat += l2_tm.fill_time.latency;
         }
     }
     lat += GlobalParams.mem.main_mem.read_time.latency;
@@ -3412,20 +3441,29 @@ report_core_bw(const CoreResources *core, const char *pref)
     double bw[NELEM(part_names)][NELEM(op_names)];
     int xfer_sz[NELEM(part_names)][NELEM(op_names)];    // in bytes
     int xfer_para[NELEM(part_names)][NELEM(op_names)];
+    const CacheTiming i_tm =
+        timing_in_effect(core->icache, &core->params.icache.timing);
+    const CacheTiming d_tm =
+        timing_in_effect(core->dcache, &core->params.dcache.timing);
+    const CacheTiming l2_tm = (GlobalParams.mem.private_l2caches) ?
+        timing_in_effect(core->l2cache, &core->params.private_l2cache.timing) :
+        timing_in_effect(SharedL2Cache, &GlobalParams.mem.l2cache_timing);
+    const CacheTiming l3_tm =
+        timing_in_effect(SharedL3Cache, &GlobalParams.mem.l3cache_timing);
     
     // Bandwidth estimates are calculated in steps; first, bw[][] is set to
     // the inter-request time in cycles, then bank-parallelism and transfer
     // widths are accounted for.
 
     // L1 I
-    bw[0][0] = core->params.icache.timing.access_time.interval;
+    bw[0][0] = i_tm.access_time.interval;
     bw[0][1] = -1;       // no WBs to L1
-    bw[0][2] = core->params.icache.timing.fill_time.interval;
+    bw[0][2] = i_tm.fill_time.interval;
 
     // L1 D
-    bw[1][0] = core->params.dcache.timing.access_time.interval;
+    bw[1][0] = d_tm.access_time.interval;
     bw[1][1] = -1;       // no WBs to L1
-    bw[1][2] = core->params.dcache.timing.fill_time.interval;
+    bw[1][2] = d_tm.fill_time.interval;
 
     // Bus: cheat and use access/fill op titles for request/transfer times
     bw[2][0] = GlobalParams.mem.bus_request_time.interval;
@@ -3433,20 +3471,14 @@ report_core_bw(const CoreResources *core, const char *pref)
     bw[2][2] = GlobalParams.mem.bus_transfer_time.interval;
 
     // L2 (may be private)
-    if (GlobalParams.mem.private_l2caches) {
-        bw[3][0] = core->params.private_l2cache.timing.access_time.interval;
-        bw[3][1] = core->params.private_l2cache.timing.access_time_wb.interval;
-        bw[3][2] = core->params.private_l2cache.timing.fill_time.interval;
-    } else {
-        bw[3][0] = GlobalParams.mem.l2cache_timing.access_time.interval;
-        bw[3][1] = GlobalParams.mem.l2cache_timing.access_time_wb.interval;
-        bw[3][2] = GlobalParams.mem.l2cache_timing.fill_time.interval;
-    }
+    bw[3][0] = l2_tm.access_time.interval;
+    bw[3][1] = l2_tm.access_time_wb.interval;
+    bw[3][2] = l2_tm.fill_time.interval;
 
     // L3 (may be unused)
-    bw[4][0] = GlobalParams.mem.l3cache_timing.access_time.interval;
-    bw[4][1] = GlobalParams.mem.l3cache_timing.access_time_wb.interval;
-    bw[4][2] = GlobalParams.mem.l3cache_timing.fill_time.interval;
+    bw[4][0] = l3_tm.access_time.interval;
+    bw[4][1] = l3_tm.access_time_wb.interval;
+    bw[4][2] = l3_tm.fill_time.interval;
 
     // Memory
     bw[5][0] = GlobalParams.mem.main_mem.read_time.interval;
@@ -3557,11 +3589,123 @@ report_core_bw(const CoreResources *core, const char *pref)
 }
 
 
-static void 
+// Print the estimated miss-rate curve from a cache's shadow tags, if any
+static void
+print_shadow_curve(const char *pref, const char *name,
+                   const CacheArray *cache)
+{
+    int max_assoc = cache_shadow_max_assoc(cache);
+    if (max_assoc > 0) {
+        i64 *est_misses = emalloc(max_assoc * sizeof(est_misses[0]));
+        i64 est_accesses = cache_shadow_miss_curve(cache, est_misses);
+        printf("%s%s: est. miss rate by assoc:", pref, name);
+        for (int assoc = 1; assoc <= max_assoc; assoc++) {
+            printf(" %d:%.4f", assoc, (est_accesses > 0) ?
+                   ((double) est_misses[assoc - 1] / est_accesses) : 0.0);
+        }
+        printf("\n");
+        free(est_misses);
+    }
+}
+
+
+// Print a cache's energy-model totals, if enabled; returns the total energy
+// in nJ (0 if disabled).
+static double
+print_cache_energy(const char *pref, const char *name,
+                   const CacheArray *cache)
+{
+    CacheEnergyStats es;
+    double total_nj = 0;
+    if (cache_get_energy(cache, cyc, &es)) {
+        double secs = es.cyc / (es.clock_mhz * 1e6);
+        total_nj = es.dyn_nj + es.leak_nj;
+        printf("%s%s: energy: dyn %.1f nJ leak %.1f nJ total %.1f nJ "
+               "(%s rd %s wr %s fill %s wb)\n", pref, name,
+               es.dyn_nj, es.leak_nj, total_nj, fmt_i64(es.reads),
+               fmt_i64(es.writes), fmt_i64(es.fills), fmt_i64(es.wbs));
+        printf("%s%s: avg power %.2f mW leak now %.2f mW EDP %.4g nJ*s\n",
+               pref, name, (secs > 0) ? (total_nj * 1e-6 / secs) : 0.0,
+               es.leak_mw, total_nj * secs);
+    }
+    return total_nj;
+}
+
+
+// Print a cache's decay stats, if decay is enabled
+static void
+print_cache_decay(const char *pref, const char *name,
+                  const CacheArray *cache)
+{
+    CacheDecayStats ds;
+    if (cache_get_decay_stats(cache, cyc, &ds)) {
+        int n_blocks;
+        cache_get_geom(cache, NULL, &n_blocks);
+        printf("%s%s: decay: misses: %s drowsy_wakes: %s "
+               "avg live blocks: %.1f drowsy: %.1f (of %d)\n", pref, name,
+               fmt_i64(ds.decay_misses), fmt_i64(ds.drowsy_wakes),
+               ds.avg_live_blocks, ds.avg_drowsy_blocks, n_blocks);
+    }
+}
+
+
+// Print hit/miss stats and energy for a cache's lockstep shadows, if any
+static void
+print_lockstep_shadows(const char *pref, const char *name,
+                       const CacheArray *cache)
+{
+    int n_shadows = cache_lockstep_count(cache);
+    for (int i = 0; i < n_shadows; i++) {
+        const CacheArray *shadow = cache_lockstep_shadow(cache, i);
+        const CacheGeometry *geom = cache_get_geom(shadow, NULL, NULL);
+        CacheStats cs;
+        char sh_name[200];
+        cache_get_stats(shadow, &cs);
+        e_snprintf(sh_name, NELEM(sh_name), "%s shadow %s", name,
+                   cache_lockstep_name(cache, i));
+        printf("%s%s: size: %d KB assoc: %d hits: %s misses: %s  "
+               "Hit Ratio: %.2f%%\n", pref, sh_name, geom->size_kb,
+               geom->assoc, fmt_i64(cs.hits), fmt_i64(cs.misses),
+               (cs.lookups > 0) ? (100.0 * cs.hits / cs.lookups) : 0.0);
+        print_cache_energy(pref, sh_name, shadow);
+    }
+}
+
+
+// Print a cache's geometry-change costs, if it has changed at all, and its
+// timing if that came from a latency table
+static void
+print_cache_reconfig(const char *pref, const char *name,
+                     const CacheArray *cache)
+{
+    CacheReconfigStats rs;
+    CacheTiming timing;
+    if (cache_get_timing(cache, &timing)) {
+        printf("%s%s: table timing: access: %d/%d wb: %d/%d fill: %d/%d "
+               "(latency/interval)\n", pref, name,
+               timing.access_time.latency, timing.access_time.interval,
+               timing.access_time_wb.latency, timing.access_time_wb.interval,
+               timing.fill_time.latency, timing.fill_time.interval);
+    }
+    cache_get_reconfig_stats(cache, &rs);
+    if (rs.transitions > 0) {
+        printf("%s%s: reconfig: transitions: %s moved: %s flushed: %s "
+               "(%s dirty)\n", pref, name, fmt_i64(rs.transitions),
+               fmt_i64(rs.blocks_moved), fmt_i64(rs.blocks_flushed),
+               fmt_i64(rs.dirty_flushes));
+        printf("%s%s: reconfig: bank busy cyc: %s cycles lost to "
+               "reconfiguration: %s\n", pref, name,
+               fmt_i64(rs.bank_busy_cyc), fmt_i64(rs.lookup_stall_cyc));
+    }
+}
+
+
+static double
 print_cstats_core(CoreResources *core) 
 {
     CacheStats i_stats, d_stats;
     TLBStats itlb_stats, dtlb_stats;
+    double energy_nj = 0;
     int i;
 
     cache_get_stats(core->icache, &i_stats);
@@ -3588,6 +3732,13 @@ print_cstats_core(CoreResources *core)
            fmt_i64(i_stats.coher_misses), 
            fmt_i64(i_stats.coher_invalidates),
            fmt_i64(i_stats.wbfull_confs));
+    print_shadow_curve("  ", "ICACHE", core->icache);
+    cache_print_stack_dist(core->icache, "  ", "ICACHE");
+    cache_print_all_assoc(core->icache, "  ", "ICACHE");
+    print_lockstep_shadows("  ", "ICACHE", core->icache);
+    energy_nj += print_cache_energy("  ", "ICACHE", core->icache);
+    print_cache_decay("  ", "ICACHE", core->icache);
+    print_cache_reconfig("  ", "ICACHE", core->icache);
     if (core->tcache) {
         TraceCacheStats t_stats;
         tc_get_stats(core->tcache, &t_stats);
@@ -3627,6 +3778,13 @@ print_cstats_core(CoreResources *core)
            fmt_i64(d_stats.coher_invalidates),
            fmt_i64(d_stats.wbfull_confs),
            fmt_i64(d_stats.coher_busy));
+    print_shadow_curve("  ", "DCACHE", core->dcache);
+    cache_print_stack_dist(core->dcache, "  ", "DCACHE");
+    cache_print_all_assoc(core->dcache, "  ", "DCACHE");
+    print_lockstep_shadows("  ", "DCACHE", core->dcache);
+    energy_nj += print_cache_energy("  ", "DCACHE", core->dcache);
+    print_cache_decay("  ", "DCACHE", core->dcache);
+    print_cache_reconfig("  ", "DCACHE", core->dcache);
     if (GlobalParams.mem.private_l2caches) {
         CacheStats l2_stats;
         cache_get_stats(core->l2cache, &l2_stats);
@@ -3649,6 +3807,13 @@ print_cstats_core(CoreResources *core)
                fmt_i64(l2_stats.coher_invalidates),
                fmt_i64(l2_stats.wbfull_confs),
                fmt_i64(l2_stats.coher_busy));
+        print_shadow_curve("  ", "SCACHE", core->l2cache);
+        cache_print_stack_dist(core->l2cache, "  ", "SCACHE");
+        cache_print_all_assoc(core->l2cache, "  ", "SCACHE");
+        print_lockstep_shadows("  ", "SCACHE", core->l2cache);
+        energy_nj += print_cache_energy("  ", "SCACHE", core->l2cache);
+        print_cache_decay("  ", "SCACHE", core->l2cache);
+        print_cache_reconfig("  ", "SCACHE", core->l2cache);
         printf("  Stalls for L2 MSHR conflicts: %s\n",
                fmt_i64(core->private_l2mshr_confs));
     }
@@ -3665,6 +3830,10 @@ print_cstats_core(CoreResources *core)
         printf("  D-deadblock stats:\n");
         dbp_print_stats(core->d_dbp, stdout, "    ");
     }
+    if (core->phase_trk) {
+        printf("  Phase-tracker stats:\n");
+        phasetrk_print_stats(core->phase_trk, stdout, "    ");
+    }
 
     printf("  ITLB: size: %d, misses %s, miss rate %.2f\n",
            core->params.itlb_entries, fmt_i64(itlb_stats.misses), 
@@ -3696,27 +3865,30 @@ print_cstats_core(CoreResources *core)
         }
         printf("\n");
     }
+    return energy_nj;
 }
 
 
 void 
 print_cstats(void) 
 {
+    double energy_nj = 0;
     int i;
 
     printf("Cache Statistics\n");
 
     for (i = 0; i < CoreCount; i++)
-        print_cstats_core(Cores[i]);
+        energy_nj += print_cstats_core(Cores[i]);
 
     printf("Stall for miss queue full %s cycles (%.2f%%)\n",
            fmt_u64(miss_queue_full), (double) miss_queue_full/cyc);
     if (!GlobalParams.mem.private_l2caches) {
         CacheStats l2_stats;
         cache_get_stats(SharedL2Cache, &l2_stats);
-        printf("SCACHE: size: %d KB assoc: %d\n", 
-               GlobalParams.mem.l2cache_geom->size_kb,
-               GlobalParams.mem.l2cache_geom->assoc);
+        const CacheGeometry *l2_geom =
+            cache_get_geom(SharedL2Cache, NULL, NULL);
+        printf("SCACHE: size: %d KB assoc: %d\n", l2_geom->size_kb,
+               l2_geom->assoc);
         if((l2_stats.hits+l2_stats.misses) > 0) {
             printf("SCACHE: hits: %s misses: %s  writebacks: %s  "
                    "Hit Ratio: %.2f%%\n",
@@ -3725,13 +3897,21 @@ print_cstats(void)
                    (double) 100*l2_stats.hits/(l2_stats.hits+l2_stats.misses));
         }
         printf("SCACHE: wbfull_confs: %s\n", fmt_i64(l2_stats.wbfull_confs));
+        print_shadow_curve("", "SCACHE", SharedL2Cache);
+        cache_print_stack_dist(SharedL2Cache, "", "SCACHE");
+        cache_print_all_assoc(SharedL2Cache, "", "SCACHE");
+        print_lockstep_shadows("", "SCACHE", SharedL2Cache);
+        energy_nj += print_cache_energy("", "SCACHE", SharedL2Cache);
+        print_cache_decay("", "SCACHE", SharedL2Cache);
+        print_cache_reconfig("", "SCACHE", SharedL2Cache);
     }
     if (GlobalParams.mem.use_l3cache) {
         CacheStats l3_stats;
         cache_get_stats(SharedL3Cache, &l3_stats);
-        printf("3CACHE: size: %d KB assoc: %d\n",
-               GlobalParams.mem.l3cache_geom->size_kb,
-               GlobalParams.mem.l3cache_geom->assoc);
+        const CacheGeometry *l3_geom =
+            cache_get_geom(SharedL3Cache, NULL, NULL);
+        printf("3CACHE: size: %d KB assoc: %d\n", l3_geom->size_kb,
+               l3_geom->assoc);
         if((l3_stats.hits+l3_stats.misses) > 0) {
             printf("3CACHE: hits: %s misses: %s  writebacks: %s  "
                    "Hit Ratio: %.2f%%\n",
@@ -3740,6 +3920,22 @@ print_cstats(void)
                    (double) 100*l3_stats.hits/(l3_stats.hits+l3_stats.misses));
         }
         printf("3CACHE: wbfull_confs: %s\n", fmt_i64(l3_stats.wbfull_confs));
+        print_shadow_curve("", "3CACHE", SharedL3Cache);
+        cache_print_stack_dist(SharedL3Cache, "", "3CACHE");
+        cache_print_all_assoc(SharedL3Cache, "", "3CACHE");
+        print_lockstep_shadows("", "3CACHE", SharedL3Cache);
+        energy_nj += print_cache_energy("", "3CACHE", SharedL3Cache);
+        print_cache_decay("", "3CACHE", SharedL3Cache);
+        print_cache_reconfig("", "3CACHE", SharedL3Cache);
+    }
+    {
+        // (all caches share the clock and stats-reset time)
+        CacheEnergyStats es;
+        if (cache_get_energy(Cores[0]->dcache, cyc, &es)) {
+            double secs = es.cyc / (es.clock_mhz * 1e6);
+            printf("Cache energy: total %.1f nJ over %.4g s, "
+                   "EDP %.4g nJ*s\n", energy_nj, secs, energy_nj * secs);
+        }
     }
     printf("avg mem delay %.3f\n", (double) totmemdelay/totmem);
     if (!GlobalParams.mem.private_l2caches) {
@@ -4424,3 +4620,322 @@ cachesim_prefetch_for_nextblock(struct CoreResources *core, LongAddr base_addr,
                                             pf_source, &merge_stat, &creq);
     return success;
 }
+
+
+// Take care of the blocks which fell out of a cache due to a geometry change
+// or way-gating: dirty victims become writeback requests to the next level
+// down, and core-private evictions are reported to the coherence manager,
+// just as for ordinary replacement in icache_replace()/dcache_replace()/etc.
+// "evicted" is consumed.
+static void
+dispose_reconfig_evicted(CoreResources *core, CacheArray *cache,
+                         CacheEvicted *evicted, int n_evicted)
+{
+    const char *fname = "dispose_reconfig_evicted";
+    int is_icache = core && (cache == core->icache);
+    int is_dcache = core && (cache == core->dcache);
+    int is_priv_l2 = core && GlobalParams.mem.private_l2caches &&
+        (cache == core->l2cache);
+    int is_shared_l2 = (cache == SharedL2Cache);
+    int is_l3 = (cache == SharedL3Cache);
+    DeadBlockPred *dbp = NULL;
+    CacheAction wb_action;
+    int i;
+
+    if (is_icache || is_dcache) {
+        dbp = (is_icache) ? core->i_dbp : core->d_dbp;
+        wb_action = (GlobalParams.mem.private_l2caches) ? L2_WB : BUS_WB;
+    } else if (is_priv_l2) {
+        wb_action = BUS_WB;
+    } else if (is_shared_l2) {
+        wb_action = (GlobalParams.mem.use_l3cache) ? L3_WB : MEM_WB;
+        core = NULL;
+    } else if (is_l3) {
+        wb_action = MEM_WB;
+        core = NULL;
+    } else {
+        abort_printf("%s: cache %d isn't attached as expected\n", fname,
+                     cache_get_id(cache));
+        wb_action = MEM_WB;
+    }
+
+    for (i = 0; i < n_evicted; i++) {
+        const CacheEvicted *ev = &evicted[i];
+        if (dbp)
+            dbp_block_kill(dbp, ev->base_addr);
+        if (ev->dirty) {
+            sim_assert(!is_icache);
+            enq_evict_writeback(core, ev, wb_action, ev->wb_ready_time);
+            if (is_dcache && core->d_streambuf)
+                pfsg_cache_dirty_evict(core->d_streambuf, ev->base_addr);
+        }
+    }
+    // (evict-notify after all writebacks are enqueued, so that the
+    // outbound WB requests are visible to core_has_coher_block_maybe())
+    if (core) {
+        for (i = 0; i < n_evicted; i++)
+            cache_core_evict_maybe(core, evicted[i].base_addr);
+    }
+    free(evicted);
+}
+
+
+typedef struct ResizeSetsJob {
+    CoreResources *core;
+    CacheArray *cache;
+    int pairs_per_cyc;
+    CBQ_Callback *cb;                   // pending in GlobalEventQueue
+    struct ResizeSetsJob *next;         // in ResizeSetsJobs
+} ResizeSetsJob;
+
+// Set resizes in progress, so that a reconfigure can cancel its cache's
+static ResizeSetsJob *ResizeSetsJobs = NULL;
+
+
+static void
+resize_sets_job_unlink(ResizeSetsJob *job)
+{
+    ResizeSetsJob **link = &ResizeSetsJobs;
+    while (*link != job) {
+        sim_assert(*link != NULL);
+        link = &(*link)->next;
+    }
+    *link = job->next;
+}
+
+
+void
+cachesim_reconfigure(struct CoreResources *core, struct CacheArray *cache,
+                     const struct CacheGeometry *new_geom)
+{
+    int n_evicted;
+    CacheEvicted *evicted;
+    ResizeSetsJob *job;
+
+    // Reconfiguring abandons any set resize in progress (the array is
+    // rebuilt from scratch), so its job mustn't step the new geometry
+    for (job = ResizeSetsJobs; job; job = job->next) {
+        if (job->cache == cache) {
+            DEBUGPRINTF("cache: time %s cache %d set resize canceled\n",
+                        fmt_now(), cache_get_id(cache));
+            callbackq_cancel(GlobalEventQueue, job->cb);
+            resize_sets_job_unlink(job);
+            free(job);
+            break;
+        }
+    }
+
+    evicted = cache_reconfigure(cache, new_geom, cyc, &n_evicted);
+    DEBUGPRINTF("cache: time %s cache %d reconfigured to %d KB %d-way, "
+                "%d blocks evicted\n", fmt_now(), cache_get_id(cache),
+                new_geom->size_kb, new_geom->assoc, n_evicted);
+    dispose_reconfig_evicted(core, cache, evicted, n_evicted);
+}
+
+
+int
+cachesim_warm_restore(struct CoreResources *core, struct CacheArray *cache,
+                      const struct CacheWarmBlock *blocks, int n_blocks)
+{
+    CacheWarmBlock *granted = NULL;
+    CacheEvicted *evicted;
+    int n_granted = 0, n_evicted, i;
+
+    if (n_blocks > 0)
+        granted = (CacheWarmBlock *) emalloc(n_blocks * sizeof(granted[0]));
+    for (i = 0; i < n_blocks; i++) {
+        CacheWarmBlock blk = blocks[i];
+        if (GlobalCoherMgr && core) {
+            int got = cm_warm_insert(GlobalCoherMgr, blk.base_addr,
+                                     core->core_id, blk.writeable);
+            if (!got)
+                continue;
+            if (got < 2)
+                blk.writeable = blk.dirty = 0;
+        }
+        granted[n_granted] = blk;
+        n_granted++;
+    }
+    evicted = cache_warm_import(cache, granted, n_granted, cyc, &n_evicted);
+    DEBUGPRINTF("cache: time %s cache %d warm restore: %d of %d blocks "
+                "granted, %d displaced\n", fmt_now(), cache_get_id(cache),
+                n_granted, n_blocks, n_evicted);
+    dispose_reconfig_evicted(core, cache, evicted, n_evicted);
+    free(granted);
+    return n_granted;
+}
+
+
+// Functional-warming fill of "cache" (see cachesim_warm_access()).  A dirty
+// victim is written straight into "wb_dest" (the next level down, or NULL
+// for memory) if that has it writeable, and is otherwise dropped.  Returns
+// nonzero iff the block was filled.
+static int
+warm_fill(CoreResources *core, CacheArray *cache, DeadBlockPred *dbp,
+          LongAddr base_addr, CacheAccessType access_type,
+          CacheArray *wb_dest)
+{
+    CacheEvicted evicted;
+    CacheFillOutcome fill_stat;
+
+    if (cache_wb_buffer_full(cache))
+        return 0;
+    laddr_set(evicted.base_addr, 0, 0);
+    fill_stat = cache_fill(cache, base_addr, access_type, &evicted);
+    if (fill_stat == CacheFill_EvictDirty) {
+        cache_wb_accepted(cache, evicted.base_addr);
+        if (wb_dest &&
+            cache_access_ok(wb_dest, evicted.base_addr, Cache_Write))
+            cache_mark_dirty(wb_dest, evicted.base_addr);
+    }
+    if (fill_stat != CacheFill_NoEvict) {
+        if (dbp)
+            dbp_block_kill(dbp, evicted.base_addr);
+        if (core)
+            cache_core_evict_maybe(core, evicted.base_addr);
+    }
+    return 1;
+}
+
+
+// Functional-warming lookup: as cache_lookup(), but with no bank access to
+// follow, any drowsy-block wake is dropped rather than left pending
+static CacheLOutcome
+warm_lookup(CacheArray *cache, LongAddr addr, CacheAccessType access_type)
+{
+    CacheLOutcome result = cache_lookup(cache, addr, access_type, NULL);
+    cache_cancel_wake(cache);
+    return result;
+}
+
+
+void
+cachesim_warm_access(struct CoreResources *core, LongAddr addr, int is_inst,
+                     int is_write)
+{
+    const int private_l2 = GlobalParams.mem.private_l2caches;
+    CacheArray *l1 = (is_inst) ? core->icache : core->dcache;
+    DeadBlockPred *dbp = (is_inst) ? core->i_dbp : core->d_dbp;
+    CacheArray *l2 = core->l2cache;
+    CacheArray *l3 = SharedL3Cache;
+    CacheAccessType fill_type = (is_write) ? Cache_ReadExcl : Cache_Read;
+    CacheLOutcome l1_stat, l2_stat;
+
+    sim_assert(!is_inst || !is_write);
+    cache_align_addr(l1, &addr);
+    l1_stat = warm_lookup(l1, addr, (is_write) ? Cache_Write : Cache_Read);
+    if ((l1_stat == Cache_Hit) || (l1_stat == Cache_CoherBusy))
+        return;
+
+    if (GlobalCoherMgr) {
+        int got = cm_warm_insert(GlobalCoherMgr, addr, core->core_id,
+                                 is_write);
+        if (!got)
+            return;
+        if (got < 2)
+            fill_type = Cache_Read;
+    }
+
+    if (l1_stat == Cache_UpgradeMiss) {
+        // present read-only: no fill needed, just the permission
+        if (fill_type == Cache_ReadExcl) {
+            if (private_l2 && cache_access_ok(l2, addr, Cache_Read))
+                cache_mark_writeable(l2, addr);
+            cache_mark_writeable(l1, addr);
+            cache_mark_dirty(l1, addr);
+        }
+        return;
+    }
+
+    l2_stat = warm_lookup(l2, addr, (private_l2) ? fill_type : Cache_Read);
+    if (l2_stat != Cache_Hit) {
+        if (l3 && (l2_stat == Cache_Miss) &&
+            (warm_lookup(l3, addr, Cache_Read) != Cache_Hit))
+            warm_fill(NULL, l3, NULL, addr, Cache_ReadExcl, NULL);
+        // (shared L2 fills are always exclusive; see l2_replace())
+        warm_fill((private_l2) ? core : NULL, l2, NULL, addr,
+                  (private_l2) ? fill_type : Cache_ReadExcl, l3);
+    }
+    if (warm_fill(core, l1, dbp, addr, fill_type, l2) &&
+        (fill_type == Cache_ReadExcl))
+        cache_mark_dirty(l1, addr);
+}
+
+
+// GlobalEventQueue callback: move the next few set-pairs of an in-progress
+// resize, rescheduling for the next cycle until it's done.
+static i64
+resize_sets_step_cb(void *data, CBQ_Args *args)
+{
+    ResizeSetsJob *job = (ResizeSetsJob *) data;
+    int n_evicted, done;
+    CacheEvicted *evicted = cache_resize_sets_step(job->cache,
+                                                   job->pairs_per_cyc, cyc,
+                                                   &n_evicted, &done);
+    dispose_reconfig_evicted(job->core, job->cache, evicted, n_evicted);
+    if (done) {
+        DEBUGPRINTF("cache: time %s cache %d set resize done\n", fmt_now(),
+                    cache_get_id(job->cache));
+        resize_sets_job_unlink(job);
+        free(job);
+        return -1;
+    }
+    return cyc + 1;
+}
+
+
+void
+cachesim_resize_sets(struct CoreResources *core, struct CacheArray *cache,
+                     int new_n_lines, int pairs_per_cyc)
+{
+    ResizeSetsJob *job;
+    if (pairs_per_cyc < 1) {
+        abort_printf("cachesim_resize_sets: bad pairs_per_cyc %d\n",
+                     pairs_per_cyc);
+    }
+    DEBUGPRINTF("cache: time %s cache %d set resize to %d lines, %d "
+                "pairs/cyc\n", fmt_now(), cache_get_id(cache), new_n_lines,
+                pairs_per_cyc);
+    cache_resize_sets_begin(cache, new_n_lines, cyc);
+    job = (ResizeSetsJob *) emalloc(sizeof(*job));
+    job->core = core;
+    job->cache = cache;
+    job->pairs_per_cyc = pairs_per_cyc;
+    job->cb = callback_c_create(resize_sets_step_cb, job);
+    job->next = ResizeSetsJobs;
+    ResizeSetsJobs = job;
+    // First step happens this cycle, if the event queue hasn't been serviced
+    // yet; otherwise, next cycle.
+    callbackq_enqueue(GlobalEventQueue, cyc, job->cb);
+}
+
+
+void
+cachesim_set_active_ways(struct CoreResources *core, struct CacheArray *cache,
+                         int n_ways)
+{
+    const CacheGeometry *geom = cache_get_geom(cache, NULL, NULL);
+    int way;
+    if ((n_ways < 1) || (n_ways > geom->assoc)) {
+        abort_printf("cachesim_set_active_ways: cache %d: can't enable %d "
+                     "of %d ways\n", cache_get_id(cache), n_ways,
+                     geom->assoc);
+    }
+    // Enable first, so that there's always at least one way left on
+    for (way = 0; way < n_ways; way++) {
+        int n_evicted;
+        CacheEvicted *evicted = cache_set_way_enabled(cache, way, 1, cyc,
+                                                      &n_evicted);
+        sim_assert(n_evicted == 0);
+        free(evicted);
+    }
+    for (way = n_ways; way < geom->assoc; way++) {
+        int n_evicted;
+        CacheEvicted *evicted = cache_set_way_enabled(cache, way, 0, cyc,
+                                                      &n_evicted);
+        DEBUGPRINTF("cache: time %s cache %d way %d gated, %d blocks "
+                    "evicted\n", fmt_now(), cache_get_id(cache), way,
+                    n_evicted);
+        dispose_reconfig_evicted(core, cache, evicted, n_evicted);
+    }
+}
@@ -98,6 +98,8 @@ extern const char *CacheSource_names[];         // cache.c
 void initcache(void);
 void init_coher(void);
 void process_cache_queues(void);
+// The next cycle at which process_cache_queues() has work to do, or I64_MAX
+i64 cachesim_next_event_time(void);
 int doiaccess(mem_addr addr, struct context *current);
 int dodaccess(mem_addr addr, int is_write, struct context *current,
               struct activelist *meminst, i64 addr_ready_cyc);
@@ -145,6 +147,50 @@ cachesim_prefetch_for_nextblock(struct CoreResources *core, LongAddr base_addr,
                                 int exclusive_access, CacheSource pf_source);
 
 
+// Change the size and/or associativity of a live cache at the current
+// simulation time.  "cache" is one of the given core's L1 or private L2
+// caches, or the shared L2/L3 (in which case "core" may be NULL).  Blocks
+// which no longer fit are evicted, with writebacks and coherence
+// notifications issued as for ordinary replacement.  Any set resize still
+// in progress on that cache (see cachesim_resize_sets()) is abandoned.
+struct CacheGeometry;
+void cachesim_reconfigure(struct CoreResources *core, struct CacheArray *cache,
+                          const struct CacheGeometry *new_geom);
+
+// Load a cache's contents from a warm-state checkpoint (see
+// cache_warm_import()) at the current simulation time; "core" is as for
+// cachesim_reconfigure().  Blocks for a core's caches are first registered
+// with the coherence manager, if any: those it won't grant are skipped, and
+// those it grants only shared are loaded clean and read-only.  Returns the
+// number of blocks loaded (including any pushed out by later ones).
+struct CacheWarmBlock;
+int cachesim_warm_restore(struct CoreResources *core,
+                          struct CacheArray *cache,
+                          const struct CacheWarmBlock *blocks, int n_blocks);
+
+// Functional warming: apply one instruction fetch ("is_inst"), load, or
+// store ("is_write") at "addr" to the given core's L1 and the levels below
+// it, with no timing, bank, or queue effects.  Each level is looked up in
+// turn, and misses are filled on the way back up, with dirty victims
+// written straight into the next level if it's there (and dropped if not).
+// Blocks the coherence manager won't grant this core are left out, and
+// stores to blocks it grants only shared are filled read-only.
+void cachesim_warm_access(struct CoreResources *core, LongAddr addr,
+                          int is_inst, int is_write);
+
+// Way-gating version of the above: leave ways [0, n_ways) of the given cache
+// powered, and gate off the rest, evicting their contents.
+void cachesim_set_active_ways(struct CoreResources *core,
+                              struct CacheArray *cache, int n_ways);
+
+// Selective-sets version: halve or double the number of sets in use in the
+// given cache.  The blocks are moved over incrementally, "pairs_per_cyc"
+// pairs of sets each cycle, from GlobalEventQueue; the cache stays in service
+// meanwhile.  Use cache_sets_resizing() to check for completion.
+void cachesim_resize_sets(struct CoreResources *core, struct CacheArray *cache,
+                          int new_n_lines, int pairs_per_cyc);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,6 +12,7 @@ const char RCSid_1109058507[] =
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
 #include <map>
 #include <queue>
 #include <sstream>
@@ -30,6 +31,14 @@ using std::pair;
 using std::vector;
 
 
+// Backend selection: a hierarchical timing wheel, with O(1) enqueue and
+// cancel, or a binary heap which leaves canceled entries in place until
+// their time comes.  Both give the same callback order.
+#ifndef CALLBACKQ_USE_TIMING_WHEEL
+    #define CALLBACKQ_USE_TIMING_WHEEL 1
+#endif
+
+
 class C_Callback : public CBQ_Callback {
     CBQ_FuncPtr func_ptr_;
     void *data_ptr_;
@@ -43,6 +52,595 @@ public:
 };
 
 
+// variant of standard "offsetof" macro which ignores C++ restrictions
+// data-types (C++ offsetof only works on POD-types, and CallbackQueue may
+// not be Plain Old Data due to its inclusion of STL containers)
+#define object_offsetof_dangerous(obj, field) \
+    (reinterpret_cast<const char *>(&((obj).field)) - \
+     reinterpret_cast<const char *>(&(obj)))
+
+// Check the placement of CallbackQueue's "next_event_MUST_BE_FIRST" field,
+// given its offset and size.
+static void
+check_ready_field(int special_offset, int special_size)
+{
+    if (CALLBACKQ_USE_NEUROTICALLY_OPTIMIZED_READY) {
+        // If this fails to compile or when run, you can safely just switch
+        // off CALLBACKQ_USE_NEUROTICALLY_OPTIMIZED_READY in the header file
+        if ((special_offset != 0) || (special_size != sizeof(i64))) {
+            abort_printf("CallbackQueue type failure: using neurotically-"
+                         "optimized ready() implementation, but field "
+                         "offset %d or size %d don't match required "
+                         "offset %d, size %d\n", special_offset, special_size,
+                         0, sizeof(i64));
+        }
+    }
+}
+
+
+#if CALLBACKQ_USE_TIMING_WHEEL
+
+namespace {
+
+// Each level of the wheel has WheelSlots slots; those at level "lvl" each
+// span 2^(lvl * WheelSlotsLg) time units, and the level as a whole covers
+// one aligned span of the next size up, the one containing the current
+// time.  Later times go in the overflow bucket.
+const int WheelSlotsLg = 8;
+const int WheelSlots = 1 << WheelSlotsLg;
+const int WheelLevels = 3;
+const int WheelWords = WheelSlots / 64;         // per-level bitmap size
+
+// Bucket numbers: [0, CBQB_Overflow) are wheel slots, level-major
+enum {
+    CBQB_Overflow = WheelLevels * WheelSlots,
+    CBQB_Late,                  // Times before the current time
+    CBQB_Count,
+    CBQB_Running = CBQB_Count,  // Entry is being invoked; in no bucket
+    CBQB_Free                   // Entry is on the free list
+};
+
+const int EntryChunkSize = 256;         // Entries allocated at a time
+const int EntryTableInitSlots = 64;     // Must be a power of 2
+
+
+struct CBQ_WheelEntry {
+    i64 time;
+    u64 order;          // Provides total ordering for requests with same times
+    CBQ_Callback *cb;   // NULL <=> canceled while being invoked
+    CBQ_WheelEntry *prev, *next;        // Bucket list; "next" for free list
+    int bucket;         // CBQB_* or wheel slot
+    bool owned;         // Flag: callback is "owned" by this, delete when done
+
+    bool before(const CBQ_WheelEntry *e2) const {
+        return (time < e2->time) ||
+            ((time == e2->time) && (order < e2->order));
+    }
+
+    std::string fmt() const {
+        std::ostringstream out;
+        out << "time " << time << " cb " << (void *) cb
+            << " (order " << order << ")";
+        return out.str();
+    }
+};
+
+
+inline bool
+wheel_entry_before(const CBQ_WheelEntry *e1, const CBQ_WheelEntry *e2)
+{
+    return e1->before(e2);
+}
+
+
+// Map from callback pointers (used as IDs) to their entries: an
+// open-addressing hash table, with linear probing
+class CBQ_EntryTable {
+    vector<CBQ_WheelEntry *> slots;     // NULL: empty slot
+    int mask;
+    int count;
+    NoDefaultCopy nocopy;
+
+    int home_slot(const CBQ_Callback *cb) const {
+        HashU64 h;
+        return static_cast<int>(h(reinterpret_cast<size_t>(cb))) & mask;
+    }
+    int find_slot(const CBQ_Callback *cb) const {
+        int slot = home_slot(cb);
+        const CBQ_WheelEntry *ent;
+        while ((ent = slots[slot]) != NULL) {
+            if (ent->cb == cb)
+                return slot;
+            slot = (slot + 1) & mask;
+        }
+        return -1;
+    }
+    void grow();
+
+public:
+    CBQ_EntryTable()
+        : slots(EntryTableInitSlots, static_cast<CBQ_WheelEntry *>(NULL)),
+          mask(EntryTableInitSlots - 1), count(0) { }
+    CBQ_WheelEntry *find(const CBQ_Callback *cb) const {
+        int slot = find_slot(cb);
+        return (slot >= 0) ? slots[slot] : NULL;
+    }
+    bool insert(CBQ_WheelEntry *ent);   // false <=> ent->cb already present
+    void erase(const CBQ_Callback *cb);
+};
+
+
+void
+CBQ_EntryTable::grow()
+{
+    vector<CBQ_WheelEntry *> old_slots(2 * slots.size(),
+                                       static_cast<CBQ_WheelEntry *>(NULL));
+    old_slots.swap(slots);
+    mask = intsize(slots) - 1;
+    for (int i = 0; i < intsize(old_slots); ++i) {
+        CBQ_WheelEntry *ent = old_slots[i];
+        if (ent) {
+            int slot = home_slot(ent->cb);
+            while (slots[slot] != NULL)
+                slot = (slot + 1) & mask;
+            slots[slot] = ent;
+        }
+    }
+}
+
+
+bool
+CBQ_EntryTable::insert(CBQ_WheelEntry *ent)
+{
+    if (find_slot(ent->cb) >= 0)
+        return false;
+    // Keep the load factor at or below 1/2
+    if ((2 * (count + 1)) > intsize(slots))
+        grow();
+    int slot = home_slot(ent->cb);
+    while (slots[slot] != NULL)
+        slot = (slot + 1) & mask;
+    slots[slot] = ent;
+    count++;
+    return true;
+}
+
+
+void
+CBQ_EntryTable::erase(const CBQ_Callback *cb)
+{
+    int hole = find_slot(cb);
+    sim_assert(hole >= 0);
+    // Move later members of the probe run back into the gap as needed, so
+    // that find_slot() never stops short.
+    int scan = hole;
+    for (;;) {
+        scan = (scan + 1) & mask;
+        CBQ_WheelEntry *ent = slots[scan];
+        if (!ent)
+            break;
+        const int home = home_slot(ent->cb);
+        // "ent" may fill the hole unless its home is cyclically in
+        // (hole, scan]
+        const bool home_after_hole = (hole <= scan) ?
+            ((home > hole) && (home <= scan)) :
+            ((home > hole) || (home <= scan));
+        if (!home_after_hole) {
+            slots[hole] = ent;
+            hole = scan;
+        }
+    }
+    slots[hole] = NULL;
+    count--;
+}
+
+
+} // Anonymous namespace close
+
+
+// Entries at or after "cur_time" go in the lowest wheel level whose window
+// contains their time; since the windows are aligned, every entry in a
+// level precedes every entry in the levels above it (and in the overflow
+// bucket).  As cur_time moves into the next slot of an upper level, that
+// slot is cascaded down into the (then-empty) levels below.  Level-0 slots
+// hold a single time each, and are kept in order; upper slots aren't sorted.
+// Entries with times before cur_time (enqueued after it has passed) are
+// kept sorted in CBQB_Late, and are serviced first.
+struct CallbackQueue {
+private:
+    // Time of earliest enqueued event, or I64_MAX if empty.  This is used for
+    // very-low-cost testing for readiness, particularly if
+    // CALLBACKQ_USE_NEUROTICALLY_OPTIMIZED_READY is active.  (Canceled
+    // entries aren't removed from this until the next service().)
+    i64 next_event_MUST_BE_FIRST;       // this field must come first (checked)
+
+    i64 cur_time;       // No entries are before this, other than CBQB_Late
+    u64 next_order;     // (64 bits: won't overflow)
+    struct Bucket {
+        CBQ_WheelEntry *head, *tail;
+    };
+    Bucket buckets[CBQB_Count];
+    u64 occupied[WheelLevels][WheelWords];      // Bitmaps: non-empty slots
+    CBQ_EntryTable cb_to_ent;   // (CBQ_Callback pointers used as IDs.)
+    CBQ_WheelEntry *free_ents;
+    vector<CBQ_WheelEntry *> ent_chunks;        // Allocated with new[]
+    NoDefaultCopy nocopy;
+
+    void set_occupied(int bucket) {
+        if (bucket < CBQB_Overflow) {
+            occupied[bucket / WheelSlots][(bucket % WheelSlots) / 64] |=
+                SET_BIT_64(bucket % 64);
+        }
+    }
+    void clear_occupied(int bucket) {
+        if (bucket < CBQB_Overflow) {
+            occupied[bucket / WheelSlots][(bucket % WheelSlots) / 64] &=
+                ~SET_BIT_64(bucket % 64);
+        }
+    }
+
+    CBQ_WheelEntry *alloc_entry();
+    void release(CBQ_WheelEntry *ent);
+    int bucket_for(i64 time) const;
+    void link(CBQ_WheelEntry *ent);
+    void unlink(CBQ_WheelEntry *ent);
+    int first_slot(int level, int start_slot) const;
+    int first_bucket(i64 *start_time_ret) const;
+    i64 earliest_time() const;
+    void cascade(int bucket);
+    void advance_to(i64 new_time);
+
+public:
+    CallbackQueue();
+    ~CallbackQueue();
+
+    void enqueue(i64 cb_time, CBQ_Callback *callback, bool owned) {
+        sim_assert(cb_time >= 0);
+        CBQ_WheelEntry *new_ent = alloc_entry();
+        new_ent->time = cb_time;
+        new_ent->order = next_order;
+        new_ent->cb = callback;
+        new_ent->owned = owned;
+        if (!cb_to_ent.insert(new_ent)) {
+            abort_printf("callback enqueue(%s,%p) failed: dup callback\n",
+                         fmt_i64(cb_time), (void *) callback);
+        }
+        link(new_ent);
+        next_order++;
+        if (cb_time < next_event_MUST_BE_FIRST)
+            next_event_MUST_BE_FIRST = cb_time;
+    }
+
+    bool ready(i64 time_now) const {
+        return next_event_MUST_BE_FIRST <= time_now;
+    }
+
+    i64 next_time() const { return next_event_MUST_BE_FIRST; }
+
+    void service(i64 time_now, CBQ_Args *cb_args);
+
+    // true <=> is owned by CallbackQueue
+    bool cancel(CBQ_Callback *callback);
+    void dump(void *FILE_out, const char *prefix) const;
+};
+
+
+CallbackQueue::CallbackQueue()
+    : next_event_MUST_BE_FIRST(I64_MAX), cur_time(0), next_order(0),
+      free_ents(NULL)
+{
+    check_ready_field(object_offsetof_dangerous(*this,
+                                                next_event_MUST_BE_FIRST),
+                      sizeof(next_event_MUST_BE_FIRST));
+    for (int i = 0; i < CBQB_Count; ++i)
+        buckets[i].head = buckets[i].tail = NULL;
+    for (int lvl = 0; lvl < WheelLevels; ++lvl) {
+        for (int i = 0; i < WheelWords; ++i)
+            occupied[lvl][i] = 0;
+    }
+}
+
+
+CallbackQueue::~CallbackQueue()
+{
+    for (int i = 0; i < CBQB_Count; ++i) {
+        for (CBQ_WheelEntry *ent = buckets[i].head; ent; ent = ent->next) {
+            if (ent->owned)
+                delete ent->cb;
+        }
+    }
+    FOR_ITER(vector<CBQ_WheelEntry *>, ent_chunks, iter) {
+        delete[] *iter;
+    }
+}
+
+
+CBQ_WheelEntry *
+CallbackQueue::alloc_entry()
+{
+    if (!free_ents) {
+        CBQ_WheelEntry *chunk = new CBQ_WheelEntry[EntryChunkSize];
+        ent_chunks.push_back(chunk);
+        for (int i = EntryChunkSize - 1; i >= 0; --i) {
+            chunk[i].bucket = CBQB_Free;
+            chunk[i].next = free_ents;
+            free_ents = &chunk[i];
+        }
+    }
+    CBQ_WheelEntry *ent = free_ents;
+    sim_assert(ent->bucket == CBQB_Free);
+    free_ents = ent->next;
+    return ent;
+}
+
+
+// Return an entry (in no bucket) to the free list, deleting its callback if
+// it's still attached and owned.
+void
+CallbackQueue::release(CBQ_WheelEntry *ent)
+{
+    if (ent->cb) {
+        cb_to_ent.erase(ent->cb);
+        if (ent->owned)
+            delete ent->cb;
+        ent->cb = NULL;
+    }
+    ent->bucket = CBQB_Free;
+    ent->prev = NULL;
+    ent->next = free_ents;
+    free_ents = ent;
+}
+
+
+int
+CallbackQueue::bucket_for(i64 time) const
+{
+    if (time < cur_time)
+        return CBQB_Late;
+    for (int lvl = 0; lvl < WheelLevels; ++lvl) {
+        const int slot_shift = lvl * WheelSlotsLg;
+        const int window_shift = slot_shift + WheelSlotsLg;
+        if ((time >> window_shift) == (cur_time >> window_shift)) {
+            return (lvl * WheelSlots) +
+                static_cast<int>((time >> slot_shift) & (WheelSlots - 1));
+        }
+    }
+    return CBQB_Overflow;
+}
+
+
+void
+CallbackQueue::link(CBQ_WheelEntry *ent)
+{
+    const int bucket_num = bucket_for(ent->time);
+    Bucket& bucket = buckets[bucket_num];
+    CBQ_WheelEntry *after = bucket.tail;
+    if ((bucket_num < WheelSlots) || (bucket_num == CBQB_Late)) {
+        // Sorted; new entries have the latest order, so this is normally an
+        // append
+        while (after && ent->before(after))
+            after = after->prev;
+    }
+    ent->prev = after;
+    ent->next = (after) ? after->next : bucket.head;
+    if (ent->next) {
+        ent->next->prev = ent;
+    } else {
+        bucket.tail = ent;
+    }
+    if (after) {
+        after->next = ent;
+    } else {
+        bucket.head = ent;
+    }
+    ent->bucket = bucket_num;
+    set_occupied(bucket_num);
+}
+
+
+void
+CallbackQueue::unlink(CBQ_WheelEntry *ent)
+{
+    sim_assert((ent->bucket >= 0) && (ent->bucket < CBQB_Count));
+    Bucket& bucket = buckets[ent->bucket];
+    if (ent->prev) {
+        ent->prev->next = ent->next;
+    } else {
+        bucket.head = ent->next;
+    }
+    if (ent->next) {
+        ent->next->prev = ent->prev;
+    } else {
+        bucket.tail = ent->prev;
+    }
+    if (!bucket.head)
+        clear_occupied(ent->bucket);
+    ent->prev = ent->next = NULL;
+}
+
+
+// The first non-empty slot at the given level, starting at "start_slot";
+// returns -1 if there's none.
+int
+CallbackQueue::first_slot(int level, int start_slot) const
+{
+    for (int word = start_slot / 64; word < WheelWords; ++word) {
+        u64 bits = occupied[level][word];
+        if (word == (start_slot / 64))
+            bits &= ~(SET_BIT_64(start_slot % 64) - 1);
+        if (bits)
+            return (word * 64) + LOWEST_BIT_64(bits);
+    }
+    return -1;
+}
+
+
+// The earliest non-empty bucket other than CBQB_Late, or -1 if there are
+// none; "start_time_ret" gets the earliest time it can hold (its only time,
+// for level 0).
+int
+CallbackQueue::first_bucket(i64 *start_time_ret) const
+{
+    for (int lvl = 0; lvl < WheelLevels; ++lvl) {
+        const int slot_shift = lvl * WheelSlotsLg;
+        const int window_shift = slot_shift + WheelSlotsLg;
+        const int cur_slot =
+            static_cast<int>((cur_time >> slot_shift) & (WheelSlots - 1));
+        // (Upper-level slots holding cur_time have already been cascaded)
+        const int slot = first_slot(lvl, (lvl == 0) ? cur_slot :
+                                    (cur_slot + 1));
+        if (slot >= 0) {
+            *start_time_ret = ((cur_time >> window_shift) << window_shift) +
+                (static_cast<i64>(slot) << slot_shift);
+            return (lvl * WheelSlots) + slot;
+        }
+    }
+    if (buckets[CBQB_Overflow].head) {
+        const int top_shift = WheelLevels * WheelSlotsLg;
+        *start_time_ret = ((cur_time >> top_shift) + 1) << top_shift;
+        return CBQB_Overflow;
+    }
+    return -1;
+}
+
+
+i64
+CallbackQueue::earliest_time() const
+{
+    if (buckets[CBQB_Late].head)
+        return buckets[CBQB_Late].head->time;
+    i64 start_time;
+    const int bucket_num = first_bucket(&start_time);
+    if (bucket_num < 0)
+        return I64_MAX;
+    if (bucket_num < WheelSlots)
+        return start_time;
+    i64 result = I64_MAX;
+    for (const CBQ_WheelEntry *ent = buckets[bucket_num].head; ent;
+         ent = ent->next)
+        result = MIN_SCALAR(result, ent->time);
+    return result;
+}
+
+
+// Redistribute the entries of an upper-level slot (or the overflow bucket)
+// relative to the current time.
+void
+CallbackQueue::cascade(int bucket_num)
+{
+    CBQ_WheelEntry *ent = buckets[bucket_num].head;
+    buckets[bucket_num].head = buckets[bucket_num].tail = NULL;
+    clear_occupied(bucket_num);
+    while (ent) {
+        CBQ_WheelEntry *next = ent->next;
+        sim_assert(ent->time >= cur_time);
+        link(ent);
+        ent = next;
+    }
+}
+
+
+// Move cur_time up to "new_time"; there must be no entries before then,
+// outside of CBQB_Late.  Each level whose window moves is therefore empty,
+// and is refilled from the matching slot of the level above, top-down.
+void
+CallbackQueue::advance_to(i64 new_time)
+{
+    sim_assert(new_time >= cur_time);
+    const i64 old_time = cur_time;
+    cur_time = new_time;
+    const int top_shift = WheelLevels * WheelSlotsLg;
+    if ((new_time >> top_shift) != (old_time >> top_shift))
+        cascade(CBQB_Overflow);
+    for (int lvl = WheelLevels - 1; lvl > 0; --lvl) {
+        const int slot_shift = lvl * WheelSlotsLg;
+        if ((new_time >> slot_shift) != (old_time >> slot_shift)) {
+            cascade((lvl * WheelSlots) + static_cast<int>
+                    ((new_time >> slot_shift) & (WheelSlots - 1)));
+        }
+    }
+}
+
+
+void
+CallbackQueue::service(i64 time_now, CBQ_Args *cb_args)
+{
+    for (;;) {
+        CBQ_WheelEntry *ent = buckets[CBQB_Late].head;
+        if (!ent) {
+            i64 start_time;
+            const int bucket_num = first_bucket(&start_time);
+            if ((bucket_num < 0) || (start_time > time_now))
+                break;
+            advance_to(start_time);
+            if (bucket_num >= WheelSlots)
+                continue;       // Cascaded; look again
+            ent = buckets[bucket_num].head;
+        }
+        unlink(ent);
+        ent->bucket = CBQB_Running;
+        // Warning: callback may invoke other CallbackQueue methods!
+        // (but API 'contract' disallows "service" or "ready" methods)
+        i64 resched_time = ent->cb->invoke(cb_args);
+        if (ent->cb && (resched_time >= 0)) {
+            // re-schedule this callback for later
+            ent->time = resched_time;
+            ent->order = next_order;
+            next_order++;
+            link(ent);
+        } else {
+            // destroy this callback (unless it canceled itself)
+            release(ent);
+        }
+    }
+    if (time_now > cur_time)
+        advance_to(time_now);
+    next_event_MUST_BE_FIRST = earliest_time();
+}
+
+
+bool
+CallbackQueue::cancel(CBQ_Callback *callback)
+{
+    CBQ_WheelEntry *ent = cb_to_ent.find(callback);
+    if (!ent) {
+        abort_printf("CallbackQueue::cancel: unknown callback %p\n",
+                     (void *) callback);
+    }
+    const bool owned = ent->owned;
+    cb_to_ent.erase(callback);
+    // Callback object unlinked at this point: caller is now responsible for it
+    ent->cb = NULL;
+    if (ent->bucket != CBQB_Running) {
+        unlink(ent);
+        release(ent);
+    }
+    // (else, it's canceling itself; service() will release the entry)
+    return owned;
+}
+
+
+void
+CallbackQueue::dump(void *FILE_out, const char *prefix) const
+{
+    FILE *out = static_cast<FILE *>(FILE_out);
+    vector<const CBQ_WheelEntry *> sorted;
+    for (int i = 0; i < CBQB_Count; ++i) {
+        for (const CBQ_WheelEntry *ent = buckets[i].head; ent;
+             ent = ent->next)
+            sorted.push_back(ent);
+    }
+    std::sort(sorted.begin(), sorted.end(), wheel_entry_before);
+    for (int i = 0; i < intsize(sorted); ++i) {
+        const CBQ_WheelEntry *ent = sorted[i];
+        fprintf(out, "%s%s\n", prefix, ent->fmt().c_str());
+    }
+}
+
+
+#else   // CALLBACKQ_USE_TIMING_WHEEL
+
+
 class CBQ_Entry {
     i64 time;
     unsigned order;     // Provides total ordering for requests with same times
@@ -163,6 +761,8 @@ public:
         return next_event_MUST_BE_FIRST <= time_now;
     }
 
+    i64 next_time() const { return next_event_MUST_BE_FIRST; }
+
     void service(i64 time_now, CBQ_Args *cb_args) {
         CBQ_EntryTimeComp comp_func;
         while (!time_heap.empty() &&
@@ -203,31 +803,12 @@ public:
 };
 
 
-// variant of standard "offsetof" macro which ignores C++ restrictions
-// data-types (C++ offsetof only works on POD-types, and CallbackQueue may
-// not be Plain Old Data due to its inclusion of STL containers)
-#define object_offsetof_dangerous(obj, field) \
-    (reinterpret_cast<const char *>(&((obj).field)) - \
-     reinterpret_cast<const char *>(&(obj)))
-
 CallbackQueue::CallbackQueue()
     : next_event_MUST_BE_FIRST(I64_MAX), next_order(0)
 { 
-    if (CALLBACKQ_USE_NEUROTICALLY_OPTIMIZED_READY) {
-        // If this fails to compile or when run, you can safely just switch
-        // off CALLBACKQ_USE_NEUROTICALLY_OPTIMIZED_READY in the header file
-        int special_offset =
-            object_offsetof_dangerous(*this,
-                                      next_event_MUST_BE_FIRST);
-        int special_size = sizeof(next_event_MUST_BE_FIRST);
-        if ((special_offset != 0) || (special_size != sizeof(i64))) {
-            abort_printf("CallbackQueue type failure: using neurotically-"
-                         "optimized ready() implementation, but field "
-                         "offset %d or size %d don't match required "
-                         "offset %d, size %d\n", special_offset, special_size,
-                         0, sizeof(i64));
-        }
-    }
+    check_ready_field(object_offsetof_dangerous(*this,
+                                                next_event_MUST_BE_FIRST),
+                      sizeof(next_event_MUST_BE_FIRST));
 }
 
 
@@ -296,6 +877,8 @@ CallbackQueue::global_order_fixup()
     }
 }
 
+#endif  // CALLBACKQ_USE_TIMING_WHEEL
+
 
 
 //
@@ -389,6 +972,12 @@ callbackq_service(CallbackQueue *cbq, i64 time_now, CBQ_Args *cb_args)
     cbq->service(time_now, cb_args);
 }
 
+i64
+callbackq_next_time(const CallbackQueue *cbq)
+{
+    return cbq->next_time();
+}
+
 #if !(CALLBACKQ_USE_NEUROTICALLY_OPTIMIZED_READY)
 int
 callbackq_ready(const CallbackQueue *cbq, i64 time_now)
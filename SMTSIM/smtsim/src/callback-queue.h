@@ -151,6 +151,10 @@ void callbackq_service(CallbackQueue *cbq, i64 time_now, CBQ_Args *cb_args);
         (((const i64 *)(cbq))[0] <= (time_now))
 #endif
 
+// The earliest time at which callbackq_ready() will be true, or I64_MAX if
+// nothing is scheduled.  (Canceled callbacks may still be counted here.)
+i64 callbackq_next_time(const CallbackQueue *cbq);
+
 // Print the current callback queue, for debugging and such
 void callbackq_dump(const CallbackQueue *cbq, void *FILE_out,
                     const char *prefix);
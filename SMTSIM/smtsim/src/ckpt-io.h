@@ -0,0 +1,102 @@
+// -*- C++ -*-
+//
+// Checkpoint stream helpers: raw binary field I/O for simulator checkpoint
+// files.  Values are written in host byte order and layout, so checkpoints
+// are only portable between simulator builds for the same host type.
+//
+
+#ifndef CKPT_IO_H
+#define CKPT_IO_H
+
+#ifndef __cplusplus
+#error "C++ only"
+#endif
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "sys-types.h"
+#include "utils.h"
+
+
+// Write/read one plain-old-data value
+template <typename PodType>
+inline void
+ckpt_put(std::ostream& out, const PodType& val)
+{
+    out.write(reinterpret_cast<const char *>(&val), sizeof(val));
+}
+
+template <typename PodType>
+inline void
+ckpt_get(std::istream& in, PodType& val, const char *what)
+{
+    if (!in.read(reinterpret_cast<char *>(&val), sizeof(val))) {
+        exit_printf("checkpoint read failed (truncated or corrupt) at %s\n",
+                    what);
+    }
+}
+
+
+inline void
+ckpt_put_bytes(std::ostream& out, const void *src, i64 len)
+{
+    out.write(static_cast<const char *>(src), len);
+}
+
+inline void
+ckpt_get_bytes(std::istream& in, void *dest, i64 len, const char *what)
+{
+    if (!in.read(static_cast<char *>(dest), len)) {
+        exit_printf("checkpoint read failed (truncated or corrupt) at %s\n",
+                    what);
+    }
+}
+
+
+inline void
+ckpt_put_str(std::ostream& out, const std::string& str)
+{
+    i64 len = str.size();
+    ckpt_put(out, len);
+    ckpt_put_bytes(out, str.data(), len);
+}
+
+inline void
+ckpt_get_str(std::istream& in, std::string& str, const char *what)
+{
+    i64 len;
+    ckpt_get(in, len, what);
+    if (len < 0) {
+        exit_printf("checkpoint read failed (bad string length %s) at %s\n",
+                    fmt_i64(len), what);
+    }
+    std::vector<char> buf(len + 1);
+    ckpt_get_bytes(in, &buf[0], len, what);
+    str.assign(&buf[0], len);
+}
+
+
+// Section tags: each section of a checkpoint starts with a fixed tag
+// string, checked on reading, to catch format mismatches early.
+inline void
+ckpt_put_tag(std::ostream& out, const char *tag)
+{
+    ckpt_put_str(out, tag);
+}
+
+inline void
+ckpt_expect_tag(std::istream& in, const char *tag)
+{
+    std::string found;
+    ckpt_get_str(in, found, tag);
+    if (found != tag) {
+        exit_printf("checkpoint format mismatch: expected section \"%s\", "
+                    "found \"%s\"\n", tag, found.c_str());
+    }
+}
+
+
+#endif  // CKPT_IO_H
@@ -281,6 +281,9 @@ public:
     bool holder_okay(const LongAddr& base_addr, int cache_id, 
                      bool dirty, bool writeable) const;
 
+    int warm_insert(const LongAddr& base_addr, int cache_id,
+                    bool want_excl);
+
     long entry_count() const { return long(addr_to_entry_.size()); }
 };
 
@@ -636,6 +639,42 @@ CoherenceMgr::evict_notify(const LongAddr& base_addr, int cache_id)
 }
 
 
+int
+CoherenceMgr::warm_insert(const LongAddr& base_addr, int cache_id,
+                          bool want_excl)
+{
+    CoherEntry *ent = map_find(addr_to_entry_, base_addr);
+    COHER_DB(1)("coher: warm_insert: base_addr %s cache_id %d want_excl %d:",
+                fmt_laddr(base_addr), cache_id, want_excl);
+    int result;
+
+    if (!ent) {
+        map_put_uniq(addr_to_entry_, base_addr,
+                     CoherEntry((want_excl) ? Coher_Exclusive : Coher_Shared,
+                                cache_id));
+        result = (want_excl) ? 2 : 1;
+    } else {
+        COHER_DB(1)(" %s", ent->fmt().c_str());
+        if (ent->is_busy()) {
+            result = 0;
+        } else if (ent->is_holder(cache_id)) {
+            if (want_excl && (ent->g_holders().size() == 1))
+                ent->assign(Coher_Exclusive, cache_id);
+            result = (ent->get_state() == Coher_Exclusive) ? 2 : 1;
+        } else if (ent->get_state() == Coher_Exclusive) {
+            // some other cache may be holding it writeable
+            result = 0;
+        } else {
+            ent->add_holder(cache_id);
+            result = 1;
+        }
+    }
+
+    COHER_DB(1)(" -> %d\n", result);
+    return result;
+}
+
+
 bool
 CoherenceMgr::holder_okay(const LongAddr& base_addr, int cache_id, 
                           bool dirty, bool writeable) const
@@ -768,6 +807,13 @@ cm_holder_okay(const CoherenceMgr *cm, LongAddr base_addr,
     return cm->holder_okay(base_addr, cache_id, dirty, writeable);
 }
 
+int
+cm_warm_insert(CoherenceMgr *cm, LongAddr base_addr, int cache_id,
+               int want_exclusive)
+{
+    return cm->warm_insert(base_addr, cache_id, want_exclusive);
+}
+
 void
 coherwaitinfo_destroy(CoherWaitInfo *cwi)
 {
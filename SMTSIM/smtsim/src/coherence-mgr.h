@@ -148,6 +148,16 @@ int cm_holder_okay(const CoherenceMgr *cm, LongAddr base_addr,
                    int cache_id, int dirty, int writeable);
 
 
+// Register a block being placed directly into a cache from a warm-state
+// checkpoint, outside of the usual cm_access() protocol.  Returns 2 if
+// "cache_id" now holds the block exclusively (only possible if
+// "want_exclusive" was set), 1 if it holds it shared, or 0 if the block
+// can't be given to it without coherence traffic (another cache holds it
+// exclusively, or it's busy); the caller should then not install it.
+int cm_warm_insert(CoherenceMgr *cm, LongAddr base_addr, int cache_id,
+                   int want_exclusive);
+
+
 #ifdef __cplusplus
 }
 #endif
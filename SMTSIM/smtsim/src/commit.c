@@ -50,6 +50,7 @@ Copyright (C) Jack Lo
 #include "prefetch-streambuf.h"
 #include "deadblock-pred.h"
 #include "adapt-mgr.h"
+#include "phase-tracker.h"
 
 
 void *FILE_DumpCommitFile = 0;
@@ -134,6 +135,27 @@ long_mem_detect(context * restrict ctx, activelist * restrict inst,
 }
 
 
+// Non-modifying: the earliest cycle at which long_mem_detect(ctx, inst, ...)
+// could match, if nothing else changes meanwhile; MAX_CYC if never.
+static i64
+long_mem_detect_time(const context * restrict ctx,
+                     const activelist * restrict inst)
+{
+    int long_mem_cyc = GlobalParams.long_mem_cyc;
+    if ((long_mem_cyc <= 0) || !ctx->as ||
+        (ctx->long_mem_stat != LongMem_None))
+        return MAX_CYC;
+    if (inst) {
+        if ((inst->status & MEMORY) && (inst->donecycle == MAX_CYC))
+            return inst->issuecycle + long_mem_cyc;
+    } else {
+        if (ctx->imiss_cache_entry && (ctx->fetchcycle == MAX_CYC))
+            return ctx->last_fetch_begin + long_mem_cyc;
+    }
+    return MAX_CYC;
+}
+
+
 typedef struct TimeOrder {
     i64 time;
     context *ctx;
@@ -242,6 +264,8 @@ commit_for_core(CoreResources *core)
             bbt_update(core->br_bias, top->pc, i, top->taken_branch);
         if (core->tfill)
             tfu_inst_commit(core->tfill, current, top);
+        if (core->phase_trk)
+            phasetrk_inst_commit(core->phase_trk, top->pc, top->br_flags != 0);
         if (current->long_mem_stat == LongMem_Completing) {
             DEBUGPRINTF("T%d long_mem_op committing.\n", current->id);
             current->long_mem_stat = LongMem_None;
@@ -403,6 +427,40 @@ commit(void)
 }
 
 
+// For idle-cycle skipping (see run.c): the earliest cycle at which commit
+// (or this core's trace fill unit) could do anything, given that the rest of
+// the machine is idle until then.  Returns "cyc" if there's work now.
+i64
+commit_idle_until(const CoreResources *core)
+{
+    const int at_commit = GlobalParams.long_mem_cyc &&
+        GlobalParams.long_mem_at_commit;
+    i64 until = (core->tfill) ? tfu_next_output_cyc(core->tfill) : MAX_CYC;
+    for (int i = 0; i < core->n_contexts; i++) {
+        const context * restrict ctx = core->contexts[i];
+        const activelist * restrict oldest_inst =
+            &ctx->alist[ctx->next_to_commit];
+        i64 detect_time = MAX_CYC;
+        if (oldest_inst->status & (SQUASHED | RETIREABLE))
+            return cyc;
+        if (oldest_inst->status & INVALID) {
+            if (ctx->draining || (ctx->halting == CtxHalt_FullDraining) ||
+                (ctx->halting == CtxHalt_AfterDraining))
+                return cyc;
+            if (at_commit)
+                detect_time = long_mem_detect_time(ctx, NULL);
+        } else if (at_commit) {
+            detect_time = long_mem_detect_time(ctx, oldest_inst);
+        }
+        if (detect_time <= cyc)
+            return cyc;
+        if (detect_time < until)
+            until = detect_time;
+    }
+    return until;
+}
+
+
 void 
 process_tcfill_queues(void)
 {
@@ -28,6 +28,7 @@ const char RCSid_1036522097[] =
 #include "sim-cfg.h"
 #include "prefetch-streambuf.h"
 #include "deadblock-pred.h"
+#include "phase-tracker.h"
 #include "mshr.h"
 
 
@@ -259,6 +260,21 @@ core_create(int core_id, const CoreParams *params)
         }
     }
 
+    n->phase_trk = NULL;
+    {
+        int enable;
+        e_snprintf(temp_path, sizeof(temp_path), "%s/PhaseTracker/enable",
+                   n->params.config_path);
+        enable = simcfg_get_bool(temp_path);
+        e_snprintf(temp_path, sizeof(temp_path), "%s/PhaseTracker",
+                   n->params.config_path);
+        e_snprintf(temp_id, sizeof(temp_id), "C%d", core_id);
+        if (enable && !(n->phase_trk = phasetrk_create(temp_id, temp_path))) {
+            err_printf("couldn't create core %d PhaseTracker\n", core_id);
+            goto fail;
+        }
+    }
+
     if (!(n->request_bus = n->params.request_bus) ||
         !(n->reply_bus = n->params.reply_bus)) {
         fprintf(stderr, "%s (%s:%i): missing inter-core bus\n", __func__,
@@ -332,6 +348,7 @@ core_destroy(CoreResources *core)
         mbp_destroy(core->multi_bp);
         dbp_destroy(core->i_dbp);
         dbp_destroy(core->d_dbp);
+        phasetrk_destroy(core->phase_trk);
         if (GlobalParams.mem.private_l2caches) {
             mshr_destroy(core->private_l2mshr);
             cache_destroy(core->l2cache);
@@ -235,6 +235,7 @@ struct CoreResources {
     struct MultiBPredict *multi_bp;
     struct DeadBlockPred *i_dbp;        // may be NULL
     struct DeadBlockPred *d_dbp;        // may be NULL
+    struct PhaseTracker *phase_trk;     // may be NULL
 
     // Links to possibly-shared structures
     CoreBus *request_bus;               // Uninspired interconnect model
@@ -99,4 +99,31 @@ decode()
 }
 
 
+// For idle-cycle skipping (see run.c): decode is idle when nothing can shift
+// between its stages or be injected into rename; returns "cyc" if not,
+// MAX_CYC otherwise.
+i64
+decode_idle_until(const CoreResources *core)
+{
+    const int decode1 = core->stage.decode1;
+    const int rename1 = core->stage.rename1;
+    for (int src_stage = rename1 - 1; src_stage >= decode1; src_stage--) {
+        if ((stageq_count(core->stage.s[src_stage + 1]) == 0) &&
+            (stageq_count(core->stage.s[src_stage]) != 0))
+            return cyc;
+    }
+    if ((stageq_count(core->stage.rename_inject) != 0) &&
+        (stageq_count(core->stage.s[rename1]) == 0))
+        return cyc;
+    return MAX_CYC;
+}
 
+
+// Account for "n_cycles" idle cycles of decode: the rename-latch arbitration
+// still alternates each cycle that the latch is free
+void
+decode_skip_idle(CoreResources *core, i64 n_cycles)
+{
+    if (!stageq_count(core->stage.s[core->stage.rename1]) && (n_cycles & 1))
+        core->rename_inject_won_last ^= 1;
+}
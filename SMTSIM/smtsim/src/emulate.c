@@ -76,6 +76,7 @@ which contains the following copyright:
 #include "main.h"               // For CHECKPOINT_STORES, GlobalWorkQueue
 #include "debug-coverage.h"
 #include "bbtracker.h"
+#include "func-warm.h"          // Opaque; cache/TLB warming is elsewhere
 // NO "context.h", NO "dyn-inst.h"
 
 #define PARCODE                 0
@@ -3677,6 +3678,7 @@ fast_forward_app(AppState * restrict as, i64 inst_count)
 {
     EmuInstState emu_state;
     Stash * restrict stash = as->stash;
+    FuncWarm *fwarm = fwarm_ff_create(as);      // NULL: no warming
     int insts_in_bb = 1;
     
     sim_assert(as->app_id >= 0);
@@ -3685,8 +3687,9 @@ fast_forward_app(AppState * restrict as, i64 inst_count)
         init_bb_tracker(BBTrackerParams.filename, BBTrackerParams.interval);
     
     for (i64 i = 0; i < inst_count; i++) {
+        const mem_addr pc = as->npc;
         const StashData * restrict stash_ent =
-            stash_decode_inst(stash, as->npc);
+            stash_decode_inst(stash, pc);
         if (SP_F(!stash_ent)) {
             const char *fname = "fast_forward_app";
             err_printf("%s: instruction decode failed, A%d "
@@ -3706,10 +3709,21 @@ fast_forward_app(AppState * restrict as, i64 inst_count)
             }
         }
         
-        emulate_inst(as, stash_ent, &emu_state, 0);
+        if (fwarm) {
+            const int mem_flags = stash_ent->mem_flags;
+            const int br_flags = stash_ent->br_flags;
+            emulate_inst(as, stash_ent, &emu_state, 0);
+            fwarm_note_inst(fwarm, pc, mem_flags, br_flags, &emu_state,
+                            as->npc);
+        } else {
+            emulate_inst(as, stash_ent, &emu_state, 0);
+        }
         if (as->exit.has_exit)
             break;
     }
+
+    if (fwarm)
+        fwarm_destroy(fwarm);
 }
 
 
@@ -60,7 +60,10 @@ int decode_inst(struct AppState * restrict as,
                 struct StashData * restrict st,
                 mem_addr pc);
 
-// Emulate the next "inst_count" instructions in "as".
+// Emulate the next "inst_count" instructions in "as".  With
+// "FastForwardWarming/enable", the instruction fetches, loads, stores and
+// branches also warm a core's caches, TLBs and branch predictors (see
+// fwarm_ff_create()).
 void fast_forward_app(struct AppState * restrict as, i64 inst_count);
 
 // Calculate the destination memory address of the next instruction of "as",
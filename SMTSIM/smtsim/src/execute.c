@@ -1412,3 +1412,34 @@ execute(void)
         execute_for_core(core);
     }
 }
+
+
+// For idle-cycle skipping (see run.c): the earliest cycle at which execute()
+// or fix_pcs() could do anything for this core, given that the rest of the
+// machine is idle until then.  Returns "cyc" if there's work now.
+i64
+execute_idle_until(const CoreResources *core)
+{
+    i64 until = MAX_CYC;
+    for (int i = 0; i < core->n_contexts; i++) {
+        const context * restrict ctx = core->contexts[i];
+        if (ctx->misfetch_discovered || ctx->mispredict_discovered ||
+            ctx->lock_failed || (ctx->halting == CtxHalt_FullSignaled) ||
+            (ctx->halting == CtxHalt_FastSignaled) ||
+            (ctx->halting == CtxHalt_AfterSignaled) ||
+            (ctx->long_mem_stat == LongMem_Detecting))
+            return cyc;
+    }
+    for (const activelist * restrict instrn = stageq_head(core->stage.exec);
+         instrn != NULL; instrn = instrn->next) {
+        // (see execute_for_core(): moves on when donecycle <= cyc + 1)
+        if (instrn->donecycle != MAX_CYC) {
+            i64 move_cyc = instrn->donecycle - 1;
+            if (move_cyc <= cyc)
+                return cyc;
+            if (move_cyc < until)
+                until = move_cyc;
+        }
+    }
+    return until;
+}
@@ -1273,3 +1273,73 @@ fetch(void)
         fetch_for_core(core);
     }
 }
+
+
+// For idle-cycle skipping (see run.c), a non-modifying version of the test
+// in get_next_thread(): is "ctx" prevented from fetching this cycle?
+// "mshr_stall_ret" is set iff it's stalled only for want of an I-MSHR.
+static int
+fetch_ctx_blocked(const CoreResources *core, const context *ctx,
+                  int *mshr_stall_ret)
+{
+    *mshr_stall_ret = 0;
+    if (!ctx->running || ctx->sync_lock_blocked ||
+        (ctx->fetchcycle > cyc) || ctx->draining)
+        return 1;
+    if (!ctx->tc.avail) {
+        LongAddr fetch_addr;
+        laddr_set(fetch_addr, ctx->as->npc, ctx->as->app_master_id);
+        if (!mshr_is_avail(core->inst_mshr, fetch_addr)) {
+            *mshr_stall_ret = 1;
+            return 1;
+        }
+    }
+    // (cache_probebank_avail() could still say no, but that's time-based)
+    return 0;
+}
+
+
+// The earliest cycle at which fetch could do anything for this core, given
+// that the rest of the machine is idle until then; "cyc" if it can now.
+i64
+fetch_idle_until(const CoreResources *core)
+{
+    i64 until = MAX_CYC;
+    for (int src_stage = core->stage.decode1 - 1; src_stage >= 0;
+         src_stage--) {
+        if ((stageq_count(core->stage.s[src_stage + 1]) == 0) &&
+            (stageq_count(core->stage.s[src_stage]) != 0))
+            return cyc;
+    }
+    if ((stageq_count(core->stage.s[0]) != 0) ||
+        (core->params.fetch.thread_count_limit <= 0))
+        return MAX_CYC;
+    for (int i = 0; i < core->n_contexts; i++) {
+        const context * restrict ctx = core->contexts[i];
+        int mshr_stall;
+        if (!fetch_ctx_blocked(core, ctx, &mshr_stall))
+            return cyc;
+        if (ctx->running && !ctx->sync_lock_blocked && !ctx->draining &&
+            (ctx->fetchcycle > cyc) && (ctx->fetchcycle < until))
+            until = ctx->fetchcycle;
+    }
+    return until;
+}
+
+
+// Account for "n_cycles" idle cycles of fetch: contexts waiting for an
+// I-MSHR count an MSHR conflict each cycle
+void
+fetch_skip_idle(CoreResources *core, i64 n_cycles)
+{
+    if ((stageq_count(core->stage.s[0]) != 0) ||
+        (core->params.fetch.thread_count_limit <= 0))
+        return;
+    for (int i = 0; i < core->n_contexts; i++) {
+        context * restrict ctx = core->contexts[i];
+        int mshr_stall;
+        fetch_ctx_blocked(core, ctx, &mshr_stall);
+        if (mshr_stall)
+            ctx->stats.i_mshr_conf += n_cycles;
+    }
+}
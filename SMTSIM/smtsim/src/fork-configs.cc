@@ -0,0 +1,274 @@
+//
+// Fork-after-warmup multi-configuration runs: one detailed simulation per
+// configuration, each starting from a copy-on-write fork of the same warm
+// process state
+//
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "fork-configs.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "sim-params.h"
+#include "cache-params.h"
+#include "cache-array.h"
+#include "cache.h"
+#include "core-resources.h"
+#include "app-state.h"
+#include "syscalls.h"
+#include "main.h"
+
+using std::set;
+using std::string;
+using std::vector;
+using namespace SimCfg;
+
+
+namespace {
+
+const char *ForkCfgPath = "ForkConfigs";
+
+struct ForkChild {
+    string name;
+    string out_name;
+    pid_t pid;
+    bool done;
+    int wait_stat;
+    ForkChild(const string& name_, const string& out_name_)
+        : name(name_), out_name(out_name_), pid(-1), done(false),
+          wait_stat(0) { }
+};
+
+bool SplitDone = false;
+
+
+// Apply one cache subtree ("size_kb" and/or "assoc") to a live cache
+void
+apply_cache_geom(const string& cfg_path, const string& label,
+                 CoreResources *core, CacheArray *cache)
+{
+    if (!cache) {
+        exit_printf("%s: no %s cache to reconfigure\n", cfg_path.c_str(),
+                    label.c_str());
+    }
+    const CacheGeometry *geom = cache_get_geom(cache, NULL, NULL);
+    CacheGeometry *new_geom = cachegeom_copy(geom);
+    if (have_conf(cfg_path + "/size_kb"))
+        new_geom->size_kb = conf_int(cfg_path + "/size_kb");
+    if (have_conf(cfg_path + "/assoc"))
+        new_geom->assoc = conf_int(cfg_path + "/assoc");
+    if ((new_geom->size_kb != geom->size_kb) ||
+        (new_geom->assoc != geom->assoc)) {
+        printf("--Fork config: %s -> %d KB, %d-way\n", label.c_str(),
+               new_geom->size_kb, new_geom->assoc);
+        cachesim_reconfigure(core, cache, new_geom);
+    }
+    cachegeom_destroy(new_geom);
+}
+
+
+// (in the child) reconfigure the warm caches per config entry "cfg_path"
+void
+apply_config(const string& cfg_path)
+{
+    set<string> cache_names;
+    conf_read_keys(cfg_path, &cache_names);
+    FOR_CONST_ITER(set<string>, cache_names, iter) {
+        const string& cname = *iter;
+        const string cache_cfg = cfg_path + "/" + cname;
+        if ((cname == "ICache") || (cname == "DCache") ||
+            ((cname == "L2Cache") && GlobalParams.mem.private_l2caches)) {
+            for (int core_id = 0; core_id < CoreCount; ++core_id) {
+                CoreResources *core = Cores[core_id];
+                CacheArray *cache = (cname == "ICache") ? core->icache :
+                    (cname == "DCache") ? core->dcache : core->l2cache;
+                apply_cache_geom(cache_cfg, string("core") +
+                                 fmt_i64(core_id) + "." + cname, core, cache);
+            }
+        } else if (cname == "L2Cache") {
+            apply_cache_geom(cache_cfg, cname, NULL, SharedL2Cache);
+        } else if (cname == "L3Cache") {
+            apply_cache_geom(cache_cfg, cname, NULL, SharedL3Cache);
+        } else {
+            exit_printf("%s: unknown cache \"%s\" (expected ICache, DCache, "
+                        "L2Cache, or L3Cache)\n", cfg_path.c_str(),
+                        cname.c_str());
+        }
+    }
+}
+
+
+// Wait for any one running child; returns its index
+int
+wait_any(vector<ForkChild>& children)
+{
+    int wait_stat;
+    pid_t pid;
+    do {
+        pid = waitpid(-1, &wait_stat, 0);
+    } while ((pid < 0) && (errno == EINTR));
+    if (pid < 0) {
+        exit_printf("%s: waitpid failed: %s\n", ForkCfgPath,
+                    strerror(errno));
+    }
+    for (int i = 0; i < intsize(children); ++i) {
+        ForkChild& child = children[i];
+        if (!child.done && (child.pid == pid)) {
+            child.done = true;
+            child.wait_stat = wait_stat;
+            return i;
+        }
+    }
+    abort_printf("%s: waitpid returned unknown pid %d\n", ForkCfgPath,
+                 int(pid));
+    return -1;
+}
+
+
+// Copy a child's output file to our stdout, and report how it exited;
+// returns true iff it exited normally with status 0
+bool
+collect_child(const ForkChild& child)
+{
+    printf("--Fork config %s (pid %d) output, from \"%s\":\n",
+           child.name.c_str(), int(child.pid), child.out_name.c_str());
+    FILE *in = fopen(child.out_name.c_str(), "r");
+    if (in) {
+        char buf[8192];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+            fwrite(buf, 1, n, stdout);
+        fclose(in);
+    } else {
+        printf("(couldn't open: %s)\n", strerror(errno));
+    }
+    bool ok = false;
+    if (WIFEXITED(child.wait_stat)) {
+        int status = WEXITSTATUS(child.wait_stat);
+        printf("--Fork config %s exited with status %d\n",
+               child.name.c_str(), status);
+        ok = (status == 0);
+    } else if (WIFSIGNALED(child.wait_stat)) {
+        printf("--Fork config %s killed by signal %d\n",
+               child.name.c_str(), WTERMSIG(child.wait_stat));
+    } else {
+        printf("--Fork config %s: unexpected wait status %#x\n",
+               child.name.c_str(), child.wait_stat);
+    }
+    fflush(0);
+    return ok;
+}
+
+}       // Anonymous namespace close
+
+
+void
+forkcfg_split_maybe(void)
+{
+    const string cp(ForkCfgPath);
+    if (SplitDone)
+        return;
+    SplitDone = true;
+    if (!have_conf(cp + "/enable") || !conf_bool(cp + "/enable"))
+        return;
+
+    // (these logs are already open, and each child would append its own
+    // lines to the same file)
+    if (conf_bool("AppStatsLog/enable") || GlobalLongMemLogger) {
+        exit_printf("%s can't be used with AppStatsLog or "
+                    "GlobalLongMemLog\n", cp.c_str());
+    }
+    const string out_prefix = conf_str(cp + "/out_prefix");
+    const int max_running = conf_int(cp + "/max_running");
+    if (max_running < 0) {
+        exit_printf("%s/max_running (%d) must be non-negative\n",
+                    cp.c_str(), max_running);
+    }
+    set<string> cfg_names;
+    conf_read_keys(cp + "/Configs", &cfg_names);
+    if (cfg_names.empty()) {
+        exit_printf("%s/Configs is empty: nothing to fork\n", cp.c_str());
+    }
+
+    vector<ForkChild> children;
+    FOR_CONST_ITER(set<string>, cfg_names, iter) {
+        children.push_back(ForkChild(*iter,
+                                     out_prefix + *iter + ".out"));
+    }
+
+    printf("--Splitting at cyc %s into %d configs:", fmt_now(),
+           intsize(children));
+    for (int i = 0; i < intsize(children); ++i)
+        printf(" %s", children[i].name.c_str());
+    printf("\n");
+
+    int running = 0;
+    for (int i = 0; i < intsize(children); ++i) {
+        ForkChild& child = children[i];
+        if ((max_running > 0) && (running >= max_running)) {
+            wait_any(children);
+            running--;
+        }
+        fflush(0);
+        pid_t pid = fork();
+        if (pid < 0) {
+            exit_printf("%s: couldn't fork for config %s: %s\n", cp.c_str(),
+                        child.name.c_str(), strerror(errno));
+        } else if (pid == 0) {
+            // child: continue simulating in the new configuration
+            if (!freopen(child.out_name.c_str(), "w", stdout)) {
+                exit_printf("%s: couldn't open \"%s\" for config %s: %s\n",
+                            cp.c_str(), child.out_name.c_str(),
+                            child.name.c_str(), strerror(errno));
+            }
+            printf("--Fork config %s, split at cyc %s\n",
+                   child.name.c_str(), fmt_now());
+            // (siblings run the same apps at the same time)
+            AppState *as;
+            appstate_global_iter_reset();
+            while ((as = appstate_global_iter_next()) != NULL) {
+                if (appstate_is_alive(as))
+                    syscalls_reopen_host_fds(as->syscall_state);
+            }
+            apply_config(cp + "/Configs/" + child.name);
+            // (the switch to this config's geometry -- its flushes, moves,
+            // and bank time -- is a one-time cost that a run started in it
+            // wouldn't pay, so it's left out of the measured stats)
+            zero_cstats();
+            zero_pstats();
+            zero_pipe_stats();
+            fflush(0);
+            return;
+        }
+        child.pid = pid;
+        running++;
+    }
+
+    // parent: no simulation from here on; just collect the results
+    while (running > 0) {
+        wait_any(children);
+        running--;
+    }
+    int n_failed = 0;
+    for (int i = 0; i < intsize(children); ++i) {
+        if (!collect_child(children[i]))
+            n_failed++;
+    }
+    printf("***** exiting (%d of %d fork configs failed) *****\n", n_failed,
+           intsize(children));
+    fflush(0);
+    exit((n_failed) ? 1 : 0);
+}
@@ -0,0 +1,39 @@
+//
+// Fork-after-warmup multi-configuration runs: one detailed simulation per
+// configuration, each starting from a copy-on-write fork of the same warm
+// process state
+//
+
+#ifndef FORK_CONFIGS_H
+#define FORK_CONFIGS_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Split the simulation, if "ForkConfigs/enable" is set.  This is called
+// once, when detailed simulation of the measured region is about to begin:
+// after the initial jobs have been fast-forwarded, and after "-wu" warmup
+// (if any) has finished and stats have been zeroed.
+//
+// One child process is forked per entry of "ForkConfigs/Configs"; each
+// child sends its stdout to "<out_prefix><name>.out", applies its entry's
+// cache geometry to the warm caches, zeroes the stats again (so that the
+// cost of the geometry change isn't measured), and returns to continue
+// simulating.
+// The parent never returns: it waits for the children (at most
+// "max_running" at a time, 0 for no limit), copies each one's output to its
+// own stdout, and exits with nonzero status if any child failed.
+//
+// Each entry may have "ICache", "DCache", "L2Cache", and "L3Cache"
+// subtrees, with optional "size_kb" and "assoc" values; the L1 (and private
+// L2) settings apply to every core.  Other files opened before the split
+// (e.g. AppStatsLog outputs) are shared by all children.
+void forkcfg_split_maybe(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FORK_CONFIGS_H
@@ -0,0 +1,335 @@
+//
+// Functional warming: fast-forward emulation which also keeps a core's
+// caches, TLBs and branch predictors warm, for sampled simulation
+//
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "func-warm.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "sim-params.h"
+#include "app-state.h"
+#include "emulate.h"
+#include "stash.h"
+#include "prog-mem.h"
+#include "cache.h"
+#include "tlb-array.h"
+#include "btb-array.h"
+#include "pht-predict.h"
+#include "core-resources.h"
+#include "context.h"
+#include "main.h"
+
+using std::string;
+using std::vector;
+using namespace SimCfg;
+
+
+namespace {
+
+const char *FFWarmPath = "FastForwardWarming";
+
+enum WarmRecKind { WR_Fetch, WR_Load, WR_Store, WR_Branch };
+
+// One buffered update
+struct WarmRec {
+    mem_addr addr;              // fetch/load/store address, or branch PC
+    mem_addr next_pc;           // WR_Branch only
+    int br_flags;               // WR_Branch only
+    u8 kind;                    // WarmRecKind
+    u8 taken;                   // WR_Branch only
+    u8 new_page;                // fetch/load/store: TLB page changed
+};
+
+struct FFWarmParams {
+    bool read;
+    bool enable;
+    int core_id;                // -1: see fwarm_core_for_app()
+    int batch_size;
+    FFWarmParams() : read(false), enable(false), core_id(-1),
+                     batch_size(0) { }
+};
+
+FFWarmParams FFWarm;
+
+
+const FFWarmParams&
+ffwarm_params(void)
+{
+    if (!FFWarm.read) {
+        const string cp(FFWarmPath);
+        FFWarm.read = true;
+        FFWarm.enable = conf_bool(cp + "/enable");
+        FFWarm.core_id = conf_int(cp + "/core");
+        FFWarm.batch_size = conf_int(cp + "/batch_size");
+        if ((FFWarm.core_id < -1) || (FFWarm.core_id >= CoreCount)) {
+            exit_printf("%s/core (%d) must be -1 or a core ID\n",
+                        cp.c_str(), FFWarm.core_id);
+        }
+        if (FFWarm.batch_size < 1) {
+            exit_printf("%s/batch_size (%d) must be positive\n",
+                        cp.c_str(), FFWarm.batch_size);
+        }
+    }
+    return FFWarm;
+}
+
+
+context *
+find_app_context(const AppState *as)
+{
+    for (int i = 0; i < CtxCount; ++i) {
+        if (Contexts[i]->as == as)
+            return Contexts[i];
+    }
+    return NULL;
+}
+
+}       // Anonymous namespace close
+
+
+struct FuncWarm {
+private:
+    CoreResources *core;
+    context *ctx;
+    int master_id;
+    int block_lg;
+    unsigned ghr;
+    int batch_size;
+    vector<WarmRec> batch;
+
+    // The most recent block and page of each stream, to skip repeats
+    mem_addr last_iblock, last_ipage;
+    mem_addr last_dblock, last_dpage;
+    bool last_d_write;
+    bool have_i, have_d;
+
+    void warm_btb(const WarmRec& rec);
+    void note_access(WarmRecKind kind, mem_addr addr);
+
+public:
+    FuncWarm(CoreResources *core_, AppState *as, int batch_size_);
+    ~FuncWarm();
+    void note_inst(mem_addr pc, int mem_flags, int br_flags,
+                   const EmuInstState& emu_state, mem_addr next_pc);
+    void flush();
+};
+
+
+FuncWarm::FuncWarm(CoreResources *core_, AppState *as, int batch_size_)
+    : core(core_), ctx(find_app_context(as)), master_id(as->app_master_id),
+      block_lg(GlobalParams.mem.cache_block_bytes_lg),
+      ghr((ctx) ? ctx->ghr : 0), batch_size(batch_size_),
+      last_iblock(0), last_ipage(0), last_dblock(0), last_dpage(0),
+      last_d_write(false), have_i(false), have_d(false)
+{
+    sim_assert(batch_size > 0);
+    batch.reserve(batch_size);
+}
+
+
+FuncWarm::~FuncWarm()
+{
+    flush();
+    if (ctx)
+        ctx->ghr = ghr;
+}
+
+
+// Mirrors the committed-path BTB access in fetch (see btblookup()): every
+// branch looks up, and taken ones are (re-)inserted with their target
+void
+FuncWarm::warm_btb(const WarmRec& rec)
+{
+    BTBLookupInfo l_info;
+    u64 btb_dest = 0;
+    l_info.dest = rec.next_pc;
+    l_info.taken = rec.taken;
+    l_info.is_jump = !(rec.br_flags & (SBF_Br_Cond | SBF_StaticTargDisp |
+                                       SBF_RS_Pop | SBF_RS_PopPush));
+    btb_lookup(core->btb, rec.addr, master_id, &l_info, &btb_dest);
+    if ((btb_dest != rec.next_pc) && rec.taken)
+        btb_update(core->btb, rec.addr, master_id, rec.next_pc);
+}
+
+
+void
+FuncWarm::note_access(WarmRecKind kind, mem_addr addr)
+{
+    const mem_addr block = addr >> block_lg;
+    WarmRec rec;
+    if (kind == WR_Fetch) {
+        if (have_i && (block == last_iblock))
+            return;
+        mem_addr page = tlb_calc_baseaddr(core->itlb, addr);
+        rec.new_page = !have_i || (page != last_ipage);
+        last_iblock = block;
+        last_ipage = page;
+        have_i = true;
+    } else {
+        bool is_write = (kind == WR_Store);
+        // (a store after loads still needs write permission)
+        if (have_d && (block == last_dblock) && (last_d_write || !is_write))
+            return;
+        mem_addr page = tlb_calc_baseaddr(core->dtlb, addr);
+        rec.new_page = !have_d || (page != last_dpage);
+        last_dblock = block;
+        last_dpage = page;
+        last_d_write = is_write;
+        have_d = true;
+    }
+    rec.addr = addr;
+    rec.next_pc = 0;
+    rec.br_flags = 0;
+    rec.kind = kind;
+    rec.taken = 0;
+    batch.push_back(rec);
+}
+
+
+void
+FuncWarm::note_inst(mem_addr pc, int mem_flags, int br_flags,
+                    const EmuInstState& emu_state, mem_addr next_pc)
+{
+    note_access(WR_Fetch, pc);
+    if (mem_flags & SMF_Write) {
+        note_access(WR_Store, emu_state.destmem);
+    } else if (mem_flags & SMF_Read) {
+        note_access(WR_Load, emu_state.srcmem);
+    }
+    if (br_flags != SBF_NotABranch) {
+        WarmRec rec;
+        rec.addr = pc;
+        rec.next_pc = next_pc;
+        rec.br_flags = br_flags;
+        rec.kind = WR_Branch;
+        rec.taken = emu_state.taken_branch;
+        rec.new_page = 0;
+        batch.push_back(rec);
+    }
+    if (intsize(batch) >= batch_size)
+        flush();
+}
+
+
+void
+FuncWarm::flush()
+{
+    const int n_recs = intsize(batch);
+    for (int i = 0; i < n_recs; ++i) {
+        const WarmRec& rec = batch[i];
+        LongAddr addr;
+        laddr_set(addr, rec.addr, master_id);
+        switch (rec.kind) {
+        case WR_Fetch:
+            if (rec.new_page)
+                tlb_lookup(core->itlb, cyc, rec.addr, master_id, 0, NULL);
+            cachesim_warm_access(core, addr, 1, 0);
+            break;
+        case WR_Load:
+        case WR_Store:
+            if (rec.new_page)
+                tlb_lookup(core->dtlb, cyc, rec.addr, master_id, 0, NULL);
+            cachesim_warm_access(core, addr, 0, rec.kind == WR_Store);
+            break;
+        case WR_Branch:
+            if (SBF_CondBranch(rec.br_flags)) {
+                pht_update(core->pht, rec.addr, rec.taken, ghr);
+                ghr = (ghr << 1) | rec.taken;
+            }
+            warm_btb(rec);
+            break;
+        default:
+            abort_printf("FuncWarm::flush: bad record kind %d\n",
+                         int(rec.kind));
+        }
+    }
+    batch.clear();
+}
+
+
+FuncWarm *
+fwarm_create(CoreResources *core, AppState *as, int batch_size)
+{
+    return new FuncWarm(core, as, batch_size);
+}
+
+
+void
+fwarm_destroy(FuncWarm *fw)
+{
+    delete fw;
+}
+
+
+void
+fwarm_note_inst(FuncWarm *fw, mem_addr pc, int mem_flags, int br_flags,
+                const EmuInstState *emu_state, mem_addr next_pc)
+{
+    fw->note_inst(pc, mem_flags, br_flags, *emu_state, next_pc);
+}
+
+
+void
+fwarm_fast_forward(CoreResources *core, AppState *as, i64 inst_count)
+{
+    EmuInstState emu_state;
+    Stash * restrict stash = as->stash;
+    FuncWarm fw(core, as, ffwarm_params().batch_size);
+
+    sim_assert(as->app_id >= 0);
+
+    for (i64 i = 0; i < inst_count; i++) {
+        const mem_addr pc = as->npc;
+        const StashData * restrict stash_ent = stash_decode_inst(stash, pc);
+        if (SP_F(!stash_ent)) {
+            err_printf("fwarm_fast_forward: instruction decode failed, A%d "
+                       "inst #%s pc 0x%s\n", as->app_id, fmt_i64(i),
+                       fmt_x64(pc));
+            fprintf(stderr, "ProgMem map:\n");
+            pmem_dump_map(as->pmem, stderr, "  ");
+            sim_abort();
+        }
+        const int mem_flags = stash_ent->mem_flags;
+        const int br_flags = stash_ent->br_flags;
+        emulate_inst(as, stash_ent, &emu_state, 0);
+        fw.note_inst(pc, mem_flags, br_flags, emu_state, as->npc);
+        if (as->exit.has_exit)
+            break;
+    }
+}
+
+
+CoreResources *
+fwarm_core_for_app(const AppState *as)
+{
+    const context *ctx = find_app_context(as);
+    return (ctx) ? ctx->core : Cores[0];
+}
+
+
+FuncWarm *
+fwarm_ff_create(AppState *as)
+{
+    const FFWarmParams& params = ffwarm_params();
+    if (!params.enable)
+        return NULL;
+    sim_assert(CoreCount > 0);
+    CoreResources *core = (params.core_id >= 0) ? Cores[params.core_id] :
+        fwarm_core_for_app(as);
+    return fwarm_create(core, as, params.batch_size);
+}
+
+
+int
+fwarm_ff_enabled(void)
+{
+    return ffwarm_params().enable;
+}
@@ -0,0 +1,64 @@
+//
+// Functional warming: fast-forward emulation which also keeps a core's
+// caches, TLBs and branch predictors warm, for sampled simulation
+//
+
+#ifndef FUNC_WARM_H
+#define FUNC_WARM_H
+
+// Defined elsewhere
+struct AppState;
+struct CoreResources;
+struct EmuInstState;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A FuncWarm collects the instruction fetches, loads, stores and branches
+// of one app as it's emulated, and applies them to the caches and TLBs of
+// "core" (see cachesim_warm_access()) and to its PHT and BTB.  There's no
+// timing: TLB misses are ready at once, and nothing is queued.
+//
+// To keep the emulation loop fast, the updates are buffered and applied in
+// batches of up to "batch_size" (in program order), and runs of accesses to
+// the same cache block by the same stream are recorded just once, since the
+// repeats would only hit in the L1.  (The structures' hit counts are
+// therefore lower than they'd otherwise be; contents and replacement state
+// are unaffected.)  If "as" is on a context, that context's global history
+// is used for the PHT, and is left as it would be after the emulated
+// instructions when the FuncWarm is destroyed.
+typedef struct FuncWarm FuncWarm;
+
+FuncWarm *fwarm_create(struct CoreResources *core, struct AppState *as,
+                       int batch_size);
+// (applies any updates still buffered)
+void fwarm_destroy(FuncWarm *fw);
+
+// Note one emulated instruction at "pc", with the given StashData
+// "mem_flags" and "br_flags" (read before emulation), "emu_state" as
+// emulate_inst() left it, and "next_pc" where execution went next.
+void fwarm_note_inst(FuncWarm *fw, mem_addr pc, int mem_flags, int br_flags,
+                     const struct EmuInstState *emu_state, mem_addr next_pc);
+
+// Emulate the next "inst_count" instructions of "as", as fast_forward_app()
+// does, warming "core" as above.  Stops early if the app exits.
+void fwarm_fast_forward(struct CoreResources *core, struct AppState *as,
+                        i64 inst_count);
+
+// The core whose structures should be warmed for "as": that of the context
+// it's on, if any, otherwise core 0.
+struct CoreResources *fwarm_core_for_app(const struct AppState *as);
+
+// Warming during ordinary fast-forwarding ("FastForwardWarming/enable"):
+// if enabled, returns a FuncWarm for fast_forward_app() to feed, targeting
+// the configured core (or that from fwarm_core_for_app()); otherwise NULL.
+FuncWarm *fwarm_ff_create(struct AppState *as);
+int fwarm_ff_enabled(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FUNC_WARM_H
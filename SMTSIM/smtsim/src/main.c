@@ -78,6 +78,9 @@ which contains the following copyright:
 #include "work-queue.h"
 #include "bbtracker.h"
 #include "adapt-mgr.h"
+#include "cache-adapt-mgr.h"
+#include "app-ckpt.h"
+#include "warm-ckpt.h"
 
 int warmup = 0;
 i64 warmuptime;
@@ -332,6 +335,16 @@ usage(void)
 " -cmp -- set thread->core mapping policy to CMP (one thread per core)\n"
 " -contexts <N> -- simulate N contexts\n"
 " -cores <N> -- simulate N cores\n"
+" -ckpt-save <file> -- after fast-forwarding the initial jobs, save their\n"
+"        architectural state to <file> (gzip'd) and their memory to\n"
+"        <file>.mem, then exit\n"
+" -ckpt-restore <file> -- restore jobs' state from <file> instead of\n"
+"        fast-forwarding them; memory is mapped from <file>.mem on demand\n"
+" -warm-save <file> -- when detailed simulation would begin (after\n"
+"        fast-forwarding, and after -wu warmup if any), save the caches,\n"
+"        TLBs, and branch predictors to <file> (gzip'd), then exit\n"
+" -warm-restore <file> -- load caches, TLBs, and branch predictors from\n"
+"        <file> after fast-forwarding; caches may differ in geometry\n"
 "\n"
 "For options that output to files, using the file name \"-\" sends the\n"
 "output to stdout.\n"
@@ -352,6 +365,10 @@ main(int argc, char *argv[], char *mainenv[])
     const char *nice_override = NULL;
     const char *contexts_override = NULL;
     const char *cores_override = NULL;
+    const char *ckpt_save = NULL;
+    const char *ckpt_restore = NULL;
+    const char *warm_save = NULL;
+    const char *warm_restore = NULL;
 
     do_startup(argc, argv);
 
@@ -422,6 +439,22 @@ main(int argc, char *argv[], char *mainenv[])
                        ((i + 1) < argc)) {
                 cores_override = argv[i + 1];
                 i += 2;
+            } else if ((strcmp("-ckpt-save", argv[i]) == 0) &&
+                       ((i + 1) < argc)) {
+                ckpt_save = argv[i + 1];
+                i += 2;
+            } else if ((strcmp("-ckpt-restore", argv[i]) == 0) &&
+                       ((i + 1) < argc)) {
+                ckpt_restore = argv[i + 1];
+                i += 2;
+            } else if ((strcmp("-warm-save", argv[i]) == 0) &&
+                       ((i + 1) < argc)) {
+                warm_save = argv[i + 1];
+                i += 2;
+            } else if ((strcmp("-warm-restore", argv[i]) == 0) &&
+                       ((i + 1) < argc)) {
+                warm_restore = argv[i + 1];
+                i += 2;
             } else if (argv[i][0] == '-') {
                 fprintf(stderr, "%s: unrecognized/missing argument: %s\n",
                         get_argv0(), argv[i]);
@@ -519,6 +552,16 @@ main(int argc, char *argv[], char *mainenv[])
                     get_argv0(), __FILE__, __LINE__);
             exit(1);
         }
+        GlobalCacheAdaptMgr = cacheadapt_create(GlobalEventQueue);
+
+        if (ckpt_restore)
+            appckpt_restore_open(ckpt_restore);
+        if (ckpt_save)
+            appckpt_save_open(ckpt_save);
+        if (warm_restore)
+            warmckpt_restore_open(warm_restore);
+        if (warm_save)
+            warmckpt_save_open(warm_save);
 
         for (int app_arg = i; app_arg < argc; app_arg++)
             simcfg_gen_argfile_job(argv[app_arg]);
@@ -100,16 +100,20 @@ void long_mem_detect(struct context * restrict ctx,
                      struct activelist * restrict inst, int at_commit);
 extern void commit(void);
 extern void process_tcfill_queues(void);
+i64 commit_idle_until(const struct CoreResources *core);
 extern void reap_squashed_insts(struct context * restrict ctx);
 extern i64 DebugCommitNum;
 extern void *FILE_DumpCommitFile;
 /*decode.c*/
 void decode(void);
+i64 decode_idle_until(const struct CoreResources *core);
+void decode_skip_idle(struct CoreResources *core, i64 n_cycles);
 /*execute.c*/
 extern void initsched(void);
 extern void fix_pcs(void);
 extern void synchexecute(struct activelist *);
 extern void execute(void);
+i64 execute_idle_until(const struct CoreResources *core);
 void cleanup_commit_group(struct context *ctx, int misspec_leader_id);
 void commit_group_printstats(void);
 u64 recover_old_regval(const struct context *ctx, int inst_id, int reg_num,
@@ -128,6 +132,8 @@ extern void resim_branch(struct context * restrict ctx,
                          struct activelist * restrict inst);
 extern void calculate_priority(void);
 extern void fetch(void);
+i64 fetch_idle_until(const struct CoreResources *core);
+void fetch_skip_idle(struct CoreResources *core, i64 n_cycles);
 
 /* main.c */
 extern void time_stats(void);
@@ -181,12 +187,18 @@ extern void synch_mem_resolve(struct CoreResources * restrict core,
 extern void mem_resolve(struct CoreResources * restrict core,
                         struct activelist *, i64);
 extern void queue(void);
+i64 queue_idle_until(const struct CoreResources *core);
+void queue_skip_idle(struct CoreResources *core, i64 n_cycles);
 /*regread.c*/
 extern void regread(void);
+i64 regread_idle_until(const struct CoreResources *core);
 /*regrename.c*/
 void regrename(void);
+i64 regrename_idle_until(const struct CoreResources *core);
+void regrename_skip_idle(struct CoreResources *core, i64 n_cycles);
 /*regwrite.c*/
 extern void regwrite(void);
+i64 regwrite_idle_until(const struct CoreResources *core);
 /* run.c */
 extern int run(void);
 void print_sim_stats(int final_stats);
@@ -118,6 +118,9 @@ public:
         for (int col = 0; col < n_cols; col++)
             set_col(col, 2);    // 2: weakly taken
     }
+
+    u32 get_bits() const { return cols; }
+    void set_bits(u32 bits) { cols = bits; }
 };
 
 
@@ -189,6 +192,18 @@ public:
             os.misses++;
     }
 
+    void read_rows(u32 *dest) const {
+        for (u32 i = 0; i < params.n_rows; i++)
+            dest[i] = rows[i].get_bits();
+    }
+
+    void write_rows(const u32 *src, u32 src_rows) {
+        sim_assert(src_rows > 0);
+        sim_assert((src_rows & (src_rows - 1)) == 0);
+        for (u32 i = 0; i < params.n_rows; i++)
+            rows[i].set_bits(src[i & (src_rows - 1)]);
+    }
+
     void print_stats(void *c_FILE_out, const char *prefix) const {
         MultiBPredict::print_stats(c_FILE_out, prefix);
         FILE *f = static_cast<FILE *>(c_FILE_out);
@@ -270,3 +285,21 @@ mbp_print_stats(const MultiBPredict *mbp, void *c_FILE_out,
 {
     mbp->print_stats(c_FILE_out, prefix);
 }
+
+void
+mbp_get_params(const MultiBPredict *mbp, MultiBPredictParams *params_ret)
+{
+    *params_ret = mbp->get_params();
+}
+
+void
+mbp_read_rows(const MultiBPredict *mbp, u32 *dest)
+{
+    mbp->read_rows(dest);
+}
+
+void
+mbp_write_rows(MultiBPredict *mbp, const u32 *src, u32 src_rows)
+{
+    mbp->write_rows(src, src_rows);
+}
@@ -41,6 +41,17 @@ void mbp_update(MultiBPredict *mbp, mem_addr addr, u64 ghr,
 void mbp_print_stats(const MultiBPredict *mbp, void *c_FILE_out,
                      const char *prefix);
 
+// Warm-state checkpoint support: the predictor state is a table of
+// params.n_rows rows, each packing predict_width 2-bit counters (the first
+// in the low bits).  mbp_read_rows() copies the table to "dest";
+// mbp_write_rows() loads "src_rows" rows (a power of 2) saved from a
+// predictor with the same predict_width, repeating the saved table to fill
+// a larger one, or using just its start for a smaller one.
+void mbp_get_params(const MultiBPredict *mbp,
+                    MultiBPredictParams *params_ret);
+void mbp_read_rows(const MultiBPredict *mbp, u32 *dest);
+void mbp_write_rows(MultiBPredict *mbp, const u32 *src, u32 src_rows);
+
 #ifdef __cplusplus
 }
 #endif
@@ -62,6 +73,9 @@ public:
     virtual void update(mem_addr addr, u64 ghr, int outcome_num,
                         bool outcome, bool was_correct) = 0;
     virtual void print_stats(void *c_FILE_out, const char *prefix) const = 0;
+    virtual void read_rows(u32 *dest) const = 0;
+    virtual void write_rows(const u32 *src, u32 src_rows) = 0;
+    const MultiBPredictParams& get_params() const { return params; }
 };
 
 #endif  // __cplusplus
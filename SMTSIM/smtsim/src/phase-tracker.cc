@@ -0,0 +1,288 @@
+//
+// Online program-phase classifier, using compact basic-block vector
+// signatures gathered from committed instructions
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "phase-tracker.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "callback-queue.h"
+#include "main.h"               // for fmt_now()
+
+
+using namespace SimCfg;
+using std::string;
+using std::vector;
+
+
+namespace {
+
+struct PhaseEntry {
+    int phase_id;
+    vector<int> sig;
+    i64 last_use;               // interval # of last match
+    i64 intervals;              // # of intervals classified into this phase
+};
+
+}       // Anonymous namespace close
+
+
+struct PhaseTracker {
+    string id;
+    string cfg_path;
+
+    i64 interval;               // committed insts per interval
+    int n_buckets;
+    int sig_max;                // max value of a signature entry
+    int table_entries;
+    double match_thresh;        // fraction of maximum possible distance
+
+    vector<i64> accum;          // [n_buckets]
+    i64 insts_this_interval;
+    int insts_this_bb;
+
+    vector<PhaseEntry> table;
+    int next_phase_id;
+    int cur_phase;
+
+    vector<CBQ_Callback *> change_cbs;
+
+    struct {
+        i64 intervals;
+        i64 phase_changes;
+        i64 new_phases;
+        i64 table_evicts;
+    } st;
+
+    PhaseTracker(const string& id_, const string& cfg_path_);
+
+    void make_sig(vector<int>& sig_ret) const;
+    int sig_dist(const vector<int>& a, const vector<int>& b) const;
+    void interval_done();
+
+    void inst_commit(mem_addr pc, int is_branch) {
+        insts_this_bb++;
+        if (is_branch) {
+            int bucket = int(((pc >> 2) ^ (pc >> 12)) % u32(n_buckets));
+            accum[bucket] += insts_this_bb;
+            insts_this_bb = 0;
+        }
+        if (SP_F(++insts_this_interval >= interval))
+            interval_done();
+    }
+
+    void add_change_cb(CBQ_Callback *cb);
+    void remove_change_cb(CBQ_Callback *cb);
+    void print_stats(FILE *out, const char *pref) const;
+};
+
+
+PhaseTracker::PhaseTracker(const string& id_, const string& cfg_path_)
+    : id(id_), cfg_path(cfg_path_),
+      insts_this_interval(0), insts_this_bb(0), next_phase_id(0),
+      cur_phase(-1)
+{
+    const string& cp = cfg_path;
+    interval = conf_i64(cp + "/interval");
+    n_buckets = conf_int(cp + "/n_buckets");
+    int sig_bits = conf_int(cp + "/sig_bits");
+    table_entries = conf_int(cp + "/table_entries");
+    match_thresh = conf_double(cp + "/match_thresh");
+    if (interval < 1) {
+        exit_printf("%s/interval must be positive\n", cp.c_str());
+    }
+    if (n_buckets < 1) {
+        exit_printf("%s/n_buckets must be positive\n", cp.c_str());
+    }
+    if ((sig_bits < 1) || (sig_bits > 16)) {
+        exit_printf("%s/sig_bits (%d) out of range\n", cp.c_str(), sig_bits);
+    }
+    if (table_entries < 1) {
+        exit_printf("%s/table_entries must be positive\n", cp.c_str());
+    }
+    if ((match_thresh < 0) || (match_thresh > 1)) {
+        exit_printf("%s/match_thresh (%g) out of range [0,1]\n", cp.c_str(),
+                    match_thresh);
+    }
+    sig_max = (1 << sig_bits) - 1;
+    accum.resize(n_buckets, 0);
+    table.reserve(table_entries);
+    memset(&st, 0, sizeof(st));
+}
+
+
+// Quantize the accumulators into a signature whose entries sum to about
+// sig_max; this keeps distances comparable across intervals which ended
+// mid-basic-block.
+void
+PhaseTracker::make_sig(vector<int>& sig_ret) const
+{
+    i64 total = 0;
+    for (int i = 0; i < n_buckets; ++i)
+        total += accum[i];
+    sig_ret.resize(n_buckets);
+    for (int i = 0; i < n_buckets; ++i) {
+        sig_ret[i] = (total > 0) ?
+            int((accum[i] * sig_max + total / 2) / total) : 0;
+    }
+}
+
+
+int
+PhaseTracker::sig_dist(const vector<int>& a, const vector<int>& b) const
+{
+    int result = 0;
+    for (int i = 0; i < n_buckets; ++i)
+        result += abs(a[i] - b[i]);
+    return result;
+}
+
+
+void
+PhaseTracker::interval_done()
+{
+    vector<int> sig;
+    make_sig(sig);
+    st.intervals++;
+
+    // Distance between two normalized signatures is at most 2*sig_max
+    int best_idx = -1, best_dist = 0;
+    for (int i = 0; i < (int) table.size(); ++i) {
+        int dist = sig_dist(sig, table[i].sig);
+        if ((best_idx < 0) || (dist < best_dist)) {
+            best_idx = i;
+            best_dist = dist;
+        }
+    }
+
+    bool is_new = (best_idx < 0) ||
+        (best_dist > match_thresh * 2 * sig_max);
+    if (is_new) {
+        if ((int) table.size() < table_entries) {
+            best_idx = int(table.size());
+            table.push_back(PhaseEntry());
+        } else {
+            best_idx = 0;
+            for (int i = 1; i < (int) table.size(); ++i)
+                if (table[i].last_use < table[best_idx].last_use)
+                    best_idx = i;
+            st.table_evicts++;
+        }
+        table[best_idx].phase_id = next_phase_id++;
+        table[best_idx].intervals = 0;
+        st.new_phases++;
+    }
+    PhaseEntry& ent = table[best_idx];
+    ent.sig.swap(sig);          // track slow drift within a phase
+    ent.last_use = st.intervals;
+    ent.intervals++;
+
+    int old_phase = cur_phase;
+    cur_phase = ent.phase_id;
+    insts_this_interval = 0;
+    std::fill(accum.begin(), accum.end(), 0);
+
+    if (cur_phase != old_phase) {
+        st.phase_changes++;
+        DEBUGPRINTF("PhaseTracker %s: phase %d -> %d%s at %s\n", id.c_str(),
+                    old_phase, cur_phase, (is_new) ? " (new)" : "",
+                    fmt_now());
+        if (!change_cbs.empty()) {
+            PhaseChangeArgs args(this, old_phase, cur_phase, is_new);
+            // (copy: callbacks may unregister themselves)
+            vector<CBQ_Callback *> cbs(change_cbs);
+            for (int i = 0; i < (int) cbs.size(); ++i)
+                callback_invoke(cbs[i], &args);
+        }
+    }
+}
+
+
+void
+PhaseTracker::add_change_cb(CBQ_Callback *cb)
+{
+    sim_assert(std::find(change_cbs.begin(), change_cbs.end(), cb) ==
+               change_cbs.end());
+    change_cbs.push_back(cb);
+}
+
+
+void
+PhaseTracker::remove_change_cb(CBQ_Callback *cb)
+{
+    vector<CBQ_Callback *>::iterator found =
+        std::find(change_cbs.begin(), change_cbs.end(), cb);
+    sim_assert(found != change_cbs.end());
+    change_cbs.erase(found);
+}
+
+
+void
+PhaseTracker::print_stats(FILE *out, const char *pref) const
+{
+    fprintf(out, "%sintervals: %s\n", pref, fmt_i64(st.intervals));
+    fprintf(out, "%sphase_changes: %s\n", pref, fmt_i64(st.phase_changes));
+    fprintf(out, "%snew_phases: %s\n", pref, fmt_i64(st.new_phases));
+    fprintf(out, "%stable_evicts: %s\n", pref, fmt_i64(st.table_evicts));
+    fprintf(out, "%scur_phase: %d\n", pref, cur_phase);
+    fprintf(out, "%sphase_intervals:", pref);
+    for (int i = 0; i < (int) table.size(); ++i)
+        fprintf(out, " %d:%s", table[i].phase_id,
+                fmt_i64(table[i].intervals));
+    fprintf(out, "\n");
+}
+
+
+PhaseTracker *
+phasetrk_create(const char *id, const char *config_path)
+{
+    return new PhaseTracker(string(id), string(config_path));
+}
+
+void
+phasetrk_destroy(PhaseTracker *pt)
+{
+    delete pt;
+}
+
+void
+phasetrk_inst_commit(PhaseTracker *pt, mem_addr pc, int is_branch)
+{
+    pt->inst_commit(pc, is_branch);
+}
+
+int
+phasetrk_cur_phase(const PhaseTracker *pt)
+{
+    return pt->cur_phase;
+}
+
+void
+phasetrk_add_change_cb(PhaseTracker *pt, CBQ_Callback *cb)
+{
+    pt->add_change_cb(cb);
+}
+
+void
+phasetrk_remove_change_cb(PhaseTracker *pt, CBQ_Callback *cb)
+{
+    pt->remove_change_cb(cb);
+}
+
+void
+phasetrk_print_stats(const PhaseTracker *pt, void *c_FILE_out,
+                     const char *prefix)
+{
+    pt->print_stats(static_cast<FILE *>(c_FILE_out), prefix);
+}
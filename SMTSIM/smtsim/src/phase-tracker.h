@@ -0,0 +1,76 @@
+// -*- C++ -*-
+//
+// Online program-phase classifier, using compact basic-block vector
+// signatures gathered from committed instructions
+//
+
+#ifndef PHASE_TRACKER_H
+#define PHASE_TRACKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Relevant paper:
+//
+// Phase Tracking and Prediction; Timothy Sherwood, Suleyman Sair, Brad
+// Calder; ISCA 2003
+//
+// Each committed branch adds the number of instructions in the basic block
+// it ends to one of a small table of accumulators, selected by a hash of the
+// branch PC.  At the end of each interval, the accumulators are normalized
+// and quantized into a signature, which is matched against a table of
+// previously-seen phase signatures by Manhattan distance.
+
+
+// Defined elsewhere
+struct CBQ_Callback;
+
+
+typedef struct PhaseTracker PhaseTracker;
+
+
+PhaseTracker *phasetrk_create(const char *id, const char *config_path);
+void phasetrk_destroy(PhaseTracker *pt);
+
+// Notify: an instruction at the given PC committed
+void phasetrk_inst_commit(PhaseTracker *pt, mem_addr pc, int is_branch);
+
+// Phase ID of the most recently completed interval (-1: none yet).  IDs are
+// small non-negative integers, assigned in order of first appearance.
+int phasetrk_cur_phase(const PhaseTracker *pt);
+
+// Register/unregister a callback, invoked (with a PhaseChangeArgs argument)
+// at the end of each interval whose phase differs from the one before.  The
+// callback object is NOT owned by the PhaseTracker; its return value is
+// ignored.
+void phasetrk_add_change_cb(PhaseTracker *pt, struct CBQ_Callback *cb);
+void phasetrk_remove_change_cb(PhaseTracker *pt, struct CBQ_Callback *cb);
+
+void phasetrk_print_stats(const PhaseTracker *pt, void *c_FILE_out,
+                          const char *prefix);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#ifdef __cplusplus
+#include "callback-queue.h"
+
+struct PhaseChangeArgs : public CBQ_Args {
+    PhaseTracker *tracker;
+    int old_phase;              // -1 if none
+    int new_phase;
+    bool new_phase_is_new;      // true iff new_phase first seen just now
+    PhaseChangeArgs(PhaseTracker *tracker_, int old_phase_, int new_phase_,
+                    bool new_phase_is_new_)
+        : tracker(tracker_), old_phase(old_phase_), new_phase(new_phase_),
+          new_phase_is_new(new_phase_is_new_) { }
+};
+#endif  // __cplusplus
+
+
+#endif  // PHASE_TRACKER_H
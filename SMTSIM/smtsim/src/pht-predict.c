@@ -160,3 +160,32 @@ pht_get_stats(const PHTPredict *pht, PHTStats *dest)
 {
     memcpy(dest, &pht->stats, sizeof(*dest));
 }
+
+
+long
+pht_get_size(const PHTPredict *pht)
+{
+    return pht->n_entries;
+}
+
+
+void
+pht_read_counters(const PHTPredict *pht, int *dest)
+{
+    memcpy(dest, pht->entries, pht->n_entries * sizeof(pht->entries[0]));
+}
+
+
+void
+pht_write_counters(PHTPredict *pht, const int *src, long src_entries)
+{
+    long i;
+    sim_assert(src_entries > 0);
+    sim_assert((src_entries & (src_entries - 1)) == 0);
+
+    for (i = 0; i < pht->n_entries; i++) {
+        int val = src[i & (src_entries - 1)];
+        sim_assert((val >= 0) && (val <= 3));
+        pht->entries[i] = val;
+    }
+}
@@ -39,6 +39,18 @@ void pht_update(PHTPredict *pht, u64 addr, int taken, unsigned ghr);
 
 void pht_get_stats(const PHTPredict *pht, PHTStats *dest);
 
+/*
+ * Warm-state checkpoint support: pht_get_size() returns the number of
+ * counters, pht_read_counters() copies them all to "dest", and
+ * pht_write_counters() loads a table of "src_entries" counters (a power of
+ * 2) saved from a possibly different-sized PHT.  A larger PHT gets the
+ * saved table repeated, which is what its extra index bits would have
+ * aliased to; a smaller one gets the start of it.
+ */
+long pht_get_size(const PHTPredict *pht);
+void pht_read_counters(const PHTPredict *pht, int *dest);
+void pht_write_counters(PHTPredict *pht, const int *src, long src_entries);
+
 
 #ifdef __cplusplus
 }
@@ -104,6 +104,10 @@ private:
 
 public:
     ProgMemSegment(RegionAlloc *ra__, i64 size__, bool is_private__);
+    // Initial contents from a file, via ralloc_map_file(); g_baseptr() is
+    // NULL if that failed
+    ProgMemSegment(RegionAlloc *ra__, i64 size__, bool is_private__,
+                   int fd, i64 file_offset);
     ~ProgMemSegment();
 
     // false <=> segment is private with nonzero ref count
@@ -143,6 +147,17 @@ ProgMemSegment::ProgMemSegment(RegionAlloc *ra__, i64 size__,
 }
 
 
+ProgMemSegment::ProgMemSegment(RegionAlloc *ra__, i64 size__,
+                               bool is_private__, int fd, i64 file_offset)
+    : region_alloc_(ra__), ref_count_(0), size_(size__), max_size_(I64_MAX),
+      is_private_(is_private__), base_ptr_(NULL)
+{
+    sim_assert(size_ > 0);
+    base_ptr_ = static_cast<unsigned char *>
+        (ralloc_map_file(region_alloc_, fd, file_offset, size_));
+}
+
+
 ProgMemSegment::~ProgMemSegment() {
     if (base_ptr_)
         ralloc_dealloc(region_alloc_, base_ptr_);
@@ -252,6 +267,9 @@ public:
 
     int map_new(i64 size, mem_addr base_va, 
                 unsigned access_flags, unsigned create_flags);
+    int map_file(i64 size, mem_addr base_va, 
+                 unsigned access_flags, unsigned create_flags,
+                 int fd, i64 file_offset);
     int map_seg(ProgMemSegment *seg, mem_addr base_va,
                 unsigned access_flags,
                 unsigned create_flags);
@@ -441,6 +459,34 @@ ProgMem::map_new(i64 size, mem_addr base_va,
 }
 
 
+int
+ProgMem::map_file(i64 size, mem_addr base_va, 
+                  unsigned access_flags, unsigned create_flags,
+                  int fd, i64 file_offset)
+{
+    bool is_private = (create_flags & PMCF_AutoGrowDown);
+    PMDEBUG(1)("pmem_map_file: pmem %s size %s base_va %s "
+               "access_flags 0x%x create_flags 0x%x fd %d offset %s: ",
+               pmem_name_.c_str(),
+               fmt_i64(size), fmt_x64(base_va), access_flags, create_flags,
+               fd, fmt_i64(file_offset));
+    if ((size <= 0) || (sizet_overflow(size)))
+        return -1;
+    ProgMemSegment *seg = new ProgMemSegment(ra_, size, is_private, fd,
+                                             file_offset);
+    if (!seg->g_baseptr()) {
+        PMDEBUG(1)("couldn't map file\n");
+        delete seg;
+        return -1;
+    }
+    PMDEBUG(1)("(seg at %s) \n", fmt_x64(u64_from_ptr(seg)));
+    int stat = map_seg(seg, base_va, access_flags, create_flags);
+    if (stat)
+        delete seg;
+    return stat;
+}
+
+
 int 
 ProgMem::map_seg(ProgMemSegment *seg, mem_addr base_va, unsigned access_flags,
                  unsigned create_flags)
@@ -914,6 +960,15 @@ pmem_map_new(ProgMem *pmem, i64 size, mem_addr base_va,
     return pmem->map_new(size, base_va, access_flags, create_flags);
 }
 
+int
+pmem_map_file(ProgMem *pmem, i64 size, mem_addr base_va, 
+              unsigned access_flags, unsigned create_flags,
+              int fd, i64 file_offset)
+{
+    return pmem->map_file(size, base_va, access_flags, create_flags,
+                          fd, file_offset);
+}
+
 int 
 pmem_map_seg(ProgMem *pmem, ProgMemSegment *seg, mem_addr base_va,
              unsigned access_flags,
@@ -1118,3 +1173,9 @@ pms_resize(ProgMemSegment *seg, i64 new_size)
 {
     return seg->resize(new_size, false);
 }
+
+const void *
+pms_contents(const ProgMemSegment *seg)
+{
+    return seg->g_baseptr();
+}
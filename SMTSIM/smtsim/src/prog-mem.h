@@ -71,6 +71,14 @@ void pmem_destroy(ProgMem *pmem);
 int pmem_map_new(ProgMem *pmem, i64 size, mem_addr base_va, 
                  unsigned access_flags, unsigned create_flags);
 
+// Like pmem_map_new(), but with the initial contents taken from the file
+// open on "fd" at "file_offset", through ralloc_map_file(): where possible,
+// the file is mapped copy-on-write and pages are read in on first touch.
+// See ralloc_map_file() for the file layout needed for that.
+int pmem_map_file(ProgMem *pmem, i64 size, mem_addr base_va, 
+                  unsigned access_flags, unsigned create_flags,
+                  int fd, i64 file_offset);
+
 int pmem_map_seg(ProgMem *pmem, ProgMemSegment *seg, mem_addr base_va,
                  unsigned access_flags,
                  unsigned create_flags);
@@ -143,6 +151,11 @@ void pms_set_maxsize(ProgMemSegment *set, i64 max_size);
 // Resize a segment, from the upper end.  Returns nonzero on failure.
 int pms_resize(ProgMemSegment *seg, i64 new_size);
 
+// Read-only view of a segment's entire contents (pms_size() bytes), e.g. for
+// saving checkpoints without copying.  No access checks are made; it's
+// good until the segment is next resized.
+const void *pms_contents(const ProgMemSegment *seg);
+
 
 #ifdef __cplusplus
 }
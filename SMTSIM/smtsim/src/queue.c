@@ -1005,3 +1005,66 @@ queue(void)
         queue_for_core(core);
     }
 }
+
+
+// For idle-cycle skipping (see run.c): the earliest cycle at which an
+// instruction in this core's queues could become ready to issue, given that
+// the rest of the machine is idle until then; "cyc" if one's ready now.
+// (Blocked instructions only wake up via other activity.)
+i64
+queue_idle_until(const CoreResources *core)
+{
+    const StageQueue *queues[] = { &core->stage.intq, &core->stage.floatq };
+    i64 until = MAX_CYC;
+    for (int q = 0; q < NELEM(queues); q++) {
+        for (const activelist * restrict inst = stageq_head(*queues[q]);
+             inst != NULL; inst = inst->next) {
+            if (!(inst->status & BLOCKED)) {
+                // (see queue_for_core(): ready iff readycycle <= rr_done_cyc)
+                i64 ready_cyc = inst->readycycle - Q_RR_CYC(core);
+                if (ready_cyc <= cyc)
+                    return cyc;
+                if (ready_cyc < until)
+                    until = ready_cyc;
+            }
+        }
+    }
+    return until;
+}
+
+
+// Account for "n_cycles" cycles in which queue_for_core() would have found
+// nothing ready to issue (see queue_idle_until()).  Stores left in the queue
+// also mark the store-conflict hash each cycle, but only the current cycle's
+// marks matter, so that's skipped.
+void
+queue_skip_idle(CoreResources *core, i64 n_cycles)
+{
+    int *iqueue_sel = (int *)emalloc_zero(CtxCount*sizeof(int));
+    int *fqueue_sel = (int *)emalloc_zero(CtxCount*sizeof(int));
+
+    // Without out-of-order issue, only the queue heads get looked at
+    for (const activelist * restrict inst = stageq_head(core->stage.intq);
+         inst != NULL; inst = inst->next) {
+        iqueue_sel[inst->thread] = 1;
+        if (!core->params.queue.int_ooo_issue)
+            break;
+    }
+    for (const activelist * restrict inst = stageq_head(core->stage.floatq);
+         inst != NULL; inst = inst->next) {
+        fqueue_sel[inst->thread] = 1;
+        if (!core->params.queue.float_ooo_issue)
+            break;
+    }
+
+    for (int i = 0; i < CtxCount; i++) {
+        context * restrict ctx = Contexts[i];
+        if (iqueue_sel[i] && ctx->as != NULL)
+            ctx->as->extra->iq_acc += n_cycles;
+        if (fqueue_sel[i] && ctx->as != NULL)
+            ctx->as->extra->fq_acc += n_cycles;
+    }
+
+    free(iqueue_sel);
+    free(fqueue_sel);
+}
@@ -15,13 +15,14 @@ const char RCSid_1047457375[] =
 
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <map>
 #include <vector>
 
-#include "region-alloc.h"
 #include "sys-types.h"          // for types used in utils.h declarations
+#include "region-alloc.h"
 #include "utils.h"              // for e.g. exit_printf()
 #include "sim-assert.h"         // for e.g. sim_assert(), sim_abort()
 
@@ -70,6 +71,17 @@ namespace {
 
 size_t PageSize = 0;
 
+void
+init_pagesize()
+{
+    if (!PageSize) {
+        PageSize = getpagesize();
+        if (PageSize <= 0) {
+            abort_printf("RegionAlloc: couldn't get page size!\n");
+        }
+    }
+}
+
 inline size_t
 roundup_pagesize(size_t size)
 {
@@ -176,6 +188,68 @@ mmap_resize(void *mem, size_t old_size, size_t new_size)
     return result;
 }
 
+// Move the pages mapped at mem[0...size-1] to new_mem[0...size-1], replacing
+// whatever was mapped there, without touching their contents.  "mem" must be
+// a single mapping.  Returns false on failure, leaving both unchanged.
+bool
+mmap_move(void *mem, size_t size, void *new_mem)
+{
+    bool result;
+#if HAVE_MREMAP
+    void *moved = mremap(mem, size, size, MREMAP_MAYMOVE | MREMAP_FIXED,
+                         new_mem);
+    result = (moved != MAP_FAILED);
+    sim_assert(!result || (moved == new_mem));
+#else
+    abort_printf("mmap_move called without mremap support!\n");
+    result = false;
+#endif
+    MDEBUG(2)("MDEBUG: mmap_move(%p, %lu, %p) -> %d\n", mem,
+              (unsigned long) size, new_mem, int(result));
+    return result;
+}
+
+// mmap "r_size" bytes (a page multiple) of the file open on "fd" from
+// "offset", copy-on-write.  Pages past the end of a file mapping fault with
+// SIGBUS, so this only maps when "offset" is page-aligned and the file
+// covers every page; the caller is responsible for zero-padding its data out
+// to the page boundary.  Returns NULL if it can't, or if mmap fails.
+void *
+mmap_file_private(int fd, off_t offset, size_t r_size)
+{
+    struct stat st;
+    if ((offset % PageSize) || fstat(fd, &st) ||
+        (st.st_size < offset) ||
+        (size_t(st.st_size) - offset < r_size))
+        return NULL;
+    void *result = wrap_mmap(0, r_size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE, fd, offset);
+    MDEBUG(2)("MDEBUG: mmap_file_private(%d, %lu, %lu) -> %p\n", fd,
+              (unsigned long) offset, (unsigned long) r_size, result);
+    return result;
+}
+
+// Read exactly "size" bytes from "fd" at "offset"; false on error or EOF
+bool
+read_file_range(int fd, off_t offset, void *dest, size_t size)
+{
+    char *cdest = static_cast<char *>(dest);
+    while (size > 0) {
+        ssize_t got = pread(fd, cdest, size, offset);
+        if (got < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (got == 0)
+            return false;
+        cdest += got;
+        offset += got;
+        size -= got;
+    }
+    return true;
+}
+
 }
 
 
@@ -196,6 +270,17 @@ protected:
     virtual void *do_resize(void *mem, size_t old_size, 
                             size_t new_size) { sim_abort(); return NULL; }
 
+    // Fallback for allocators that can't map files: read the whole thing
+    // into newly-allocated memory.
+    virtual void *do_map_file(int fd, off_t offset, size_t size) {
+        void *result = do_alloc(size);
+        if (result && !read_file_range(fd, offset, result, size)) {
+            do_dealloc(result, size);
+            result = NULL;
+        }
+        return result;
+    }
+
     // Zero out new memory, if zero_fill_new_mem is set.
     void base_zero_new(void *mem, size_t old_size, size_t new_size) {
         // note: mem_sizes() may not be updated yet; we don't auto-invoke
@@ -292,6 +377,18 @@ public:
         return result;
     }
 
+    void *map_file(int fd, off_t offset, size_t size) {
+        sim_assert(size > 0);
+        void *result = do_map_file(fd, offset, size);
+        if (result) {
+            sim_assert(mem_sizes.count(result) == 0);
+            mem_sizes[result] = size;
+        }
+        MDEBUG(1)("MDEBUG: map_file(%d, %lu, %lu) -> %p\n", fd,
+                  (unsigned long) offset, (unsigned long) size, result);
+        return result;
+    }
+
     void dealloc(void *mem) {
         MDEBUG(1)("MDEBUG: dealloc(%p)\n", mem);
         if (mem) {
@@ -361,6 +458,11 @@ public:
 
 // Use POSIX mmap, and a single map per region
 class RA_MmapSingle : public RegionAlloc {
+protected:
+    // Regions from map_file() which still start with copy-on-write file
+    // pages: the (page-rounded) length of that file-backed prefix
+    VoidSizeMap file_lens;
+
 public:
     RA_MmapSingle(bool zero_fill_new_mem_)
         : RegionAlloc(zero_fill_new_mem_) { }
@@ -372,8 +474,18 @@ public:
     }
 
     void do_dealloc(void *mem, size_t size) {
+        file_lens.erase(mem);
         mmap_free(mem, size);
     }
+
+    void *do_map_file(int fd, off_t offset, size_t size) {
+        size_t r_size = roundup_pagesize(size);
+        void *result = mmap_file_private(fd, offset, r_size);
+        if (!result)
+            return RegionAlloc::do_map_file(fd, offset, size);
+        file_lens[result] = r_size;
+        return result;
+    }
 };
 
 
@@ -386,11 +498,52 @@ public:
 
     bool have_resize() const { return true; }
 
+    // A region from map_file() may be a file mapping followed by an
+    // anonymous one, which mremap() can't grow as a unit.  Instead, move
+    // the pieces into a new anonymous region, so that file pages which
+    // haven't been touched yet still aren't read.
+    void *resize_file_mapped(void *mem, size_t r_old_size, size_t r_new_size,
+                             VoidSizeMap::iterator file_ent) {
+        size_t file_len = file_ent->second;
+        if (r_new_size <= r_old_size) {
+            if (r_new_size < r_old_size) {
+                mmap_free(void_boffset(mem, r_new_size),
+                          r_old_size - r_new_size);
+            }
+            file_ent->second = RA_MIN(file_len, r_new_size);
+            return mem;
+        }
+        void *result = mmap_alloc(0, r_new_size);
+        if (!result)
+            return NULL;
+        if (!mmap_move(mem, file_len, result)) {
+            mmap_free(result, r_new_size);
+            return NULL;
+        }
+        if (r_old_size > file_len) {
+            void *tail = void_boffset(mem, file_len);
+            void *new_tail = void_boffset(result, file_len);
+            size_t tail_len = r_old_size - file_len;
+            if (!mmap_move(tail, tail_len, new_tail)) {
+                // (the tail may have been split into several mappings)
+                memcpy(new_tail, tail, tail_len);
+                mmap_free(tail, tail_len);
+            }
+        }
+        file_lens.erase(file_ent);
+        file_lens[result] = file_len;
+        return result;
+    }
+
     void *do_resize(void *mem, size_t old_size, size_t new_size) {
         size_t r_old_size = roundup_pagesize(old_size);
         size_t r_new_size = roundup_pagesize(new_size);
         void *result = mem;
-        if (r_old_size != r_new_size) {
+        VoidSizeMap::iterator file_ent = file_lens.find(mem);
+        if (file_ent != file_lens.end()) {
+            result = resize_file_mapped(mem, r_old_size, r_new_size,
+                                        file_ent);
+        } else if (r_old_size != r_new_size) {
             result = mmap_resize(mem, r_old_size, r_new_size);
         }
         if (result && (new_size > old_size)) {
@@ -512,6 +665,18 @@ public:
         destroy_subregions(srv);
     }
 
+    // A file mapping is just the first sub-region; growing appends
+    // anonymous ones after it as usual, leaving untouched file pages unread
+    // (unless the whole region has to be recopied).
+    void *do_map_file(int fd, off_t offset, size_t size) {
+        size_t r_size = roundup_pagesize(size);
+        void *result = mmap_file_private(fd, offset, r_size);
+        if (!result)
+            return RegionAlloc::do_map_file(fd, offset, size);
+        subregion_addfirst(result, r_size);
+        return result;
+    }
+
     bool have_resize() const { return true; }
 
     void *do_resize(void *mem, size_t old_size, size_t new_size) {
@@ -575,12 +740,7 @@ ralloc_create(int zero_fill_new_mem)
 {
     RegionAlloc *result;
 
-    if (!PageSize) {
-        PageSize = getpagesize();
-        if (PageSize <= 0) {
-            abort_printf("RegionAlloc: couldn't get page size!\n");
-        }
-    }
+    init_pagesize();
 
     if (!ALLOW_MMAP) {
         // Fall back to ANSI C malloc() and friends
@@ -620,12 +780,27 @@ ralloc_resize(RegionAlloc *ra, void *mem, size_t new_size)
     return ra->resize(mem, new_size);
 }
 
+void *
+ralloc_map_file(RegionAlloc *ra, int fd, i64 offset, size_t size)
+{
+    if ((offset < 0) || (off_t(offset) != offset))
+        return NULL;
+    return ra->map_file(fd, off_t(offset), size);
+}
+
 void 
 ralloc_dealloc(RegionAlloc *ra, void *mem)
 {
     ra->dealloc(mem);
 }
 
+size_t
+ralloc_page_size(void)
+{
+    init_pagesize();
+    return PageSize;
+}
+
 
 //
 // Error-catching wrappers for the wrappers (whee!)
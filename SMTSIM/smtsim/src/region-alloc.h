@@ -51,6 +51,20 @@ void ralloc_dealloc(RegionAlloc *ra, void *mem);
 void *ralloc_alloc_e(RegionAlloc *ra, size_t size);
 void *ralloc_resize_e(RegionAlloc *ra, void *mem, size_t new_size);
 
+// Allocate a region of "size" bytes, initialized from the file open on "fd"
+// starting at byte "offset".  When the allocator is mmap-based and "offset"
+// is a multiple of ralloc_page_size(), the file is mapped copy-on-write
+// (MAP_PRIVATE), so pages are only read in as they're first touched, and
+// writes never reach the file.  The file must then extend through the end
+// of the last page, with zeroes past "size".  Otherwise, it's read in up
+// front.  The result is resized and dealloc'd like any other region.
+// Returns NULL on failure (including a short read).  (uses i64 from
+// sys-types.h)
+void *ralloc_map_file(RegionAlloc *ra, int fd, i64 offset, size_t size);
+
+// The VM page size used for region alignment
+size_t ralloc_page_size(void);
+
 
 #ifdef __cplusplus
 }
@@ -68,3 +68,18 @@ regread(void)
         }
     }
 }
+
+
+// For idle-cycle skipping (see run.c): regread is idle while its stages are
+// empty; returns "cyc" if not, MAX_CYC otherwise.
+i64
+regread_idle_until(const CoreResources *core)
+{
+    const int rread1 = core->stage.rread1;
+    const int rreadN = rread1 + core->params.regread.n_stages - 1;
+    for (int stage = rread1; stage <= rreadN; stage++) {
+        if (stageq_count(core->stage.s[stage]) != 0)
+            return cyc;
+    }
+    return MAX_CYC;
+}
@@ -30,11 +30,13 @@
 #include "app-state.h"
 #include "stash.h"
 #include "adapt-mgr.h"
+#include "utils.h"
 
 
 // Log which apps have been blocked this cycle by an instruction queue conflict
+// (or for "n_cycles" cycles, when skipping idle ones)
 static void
-log_apps_qconf_cyc(const StageQueue * restrict stalled)
+log_apps_qconf_cyc(const StageQueue * restrict stalled, i64 n_cycles)
 {
     const int n_insts = stageq_count(*stalled);
     int app_ids[n_insts];
@@ -53,7 +55,7 @@ log_apps_qconf_cyc(const StageQueue * restrict stalled)
             }
             if (scan == app_ids_seen) {
                 // Haven't seen this one yet
-                inst->as->extra->instq_conf_cyc++;
+                inst->as->extra->instq_conf_cyc += n_cycles;
                 sim_assert(app_ids_seen < n_insts);
                 app_ids[app_ids_seen] = this_app_id;
                 app_ids_seen++;
@@ -77,6 +79,40 @@ log_apps_qconf_cyc(const StageQueue * restrict stalled)
 
 
 
+// Add the current occupancy of the core's queues and registers to the
+// running totals, once per cycle (for "n_cycles" cycles)
+static void
+update_occupancy_stats(CoreResources *core, i64 n_cycles)
+{
+    int i;
+
+    // Update Context Occupancy stats
+    for (i = 0; i < core->n_contexts; i++)
+    {
+        context * restrict ctx = core->contexts[i];
+        ctx->stats.robsizetotal += n_cycles * core->contexts[i]->rob_used;
+        if (ctx->as != NULL){
+            AppStateExtras * restrict extra = ctx->as->extra;
+            extra->rob_occ += n_cycles * core->contexts[i]->rob_used;
+            extra->iq_occ += n_cycles * extra->iqsize_this_cyc;
+            extra->fq_occ += n_cycles * extra->fqsize_this_cyc;
+            extra->ireg_occ += n_cycles * extra->iregs_this_cyc;
+            extra->freg_occ += n_cycles * extra->fregs_this_cyc;
+            extra->lsq_occ += n_cycles * extra->lsqsize_this_cyc;
+        }
+    }
+    // Update core ireg occupancy stats
+    core->q_stats.iregsizetotal += n_cycles * core->i_registers_used;
+    // Update core freg occupancy stats
+    core->q_stats.fregsizetotal += n_cycles * core->f_registers_used;
+    // Update core lsq occupancy stats
+    core->q_stats.lsqsizetotal += n_cycles * core->lsq_used;
+
+    core->q_stats.iqsizetotal += n_cycles * stageq_count(core->stage.intq);
+    core->q_stats.fqsizetotal += n_cycles * stageq_count(core->stage.floatq);
+}
+
+
 /* Here, instructions get stalled if there is no room in the instruction
  * queues, or if there is not space in the load-store queue, or if there are no
  * renaming registers available.  Load Store Queue is not accurately modeled.
@@ -97,7 +133,6 @@ regrename_for_core(CoreResources *core)
     int rename_n = core->stage.rename1 + core->params.rename.n_stages - 1;
     
     StageQueue * restrict rename_src = &core->stage.s[rename_n];
-    int i;
     
     // Move instructions from renameN into IQ / FQ, if space available
     while (stageq_count(*rename_src) > 0) {
@@ -199,7 +234,7 @@ regrename_for_core(CoreResources *core)
                     core->i_registers_used -= instrn->iregs_used;
                     core->f_registers_used -= instrn->fregs_used;
                     instrn->iregs_used = instrn->fregs_used = 0;
-                    log_apps_qconf_cyc(rename_src);
+                    log_apps_qconf_cyc(rename_src, 1);
                     break;
                 } /* space available */
                 else {
@@ -227,7 +262,7 @@ regrename_for_core(CoreResources *core)
                     core->i_registers_used -= instrn->iregs_used;
                     core->f_registers_used -= instrn->fregs_used;
                     instrn->iregs_used = instrn->fregs_used = 0;
-                    log_apps_qconf_cyc(rename_src);
+                    log_apps_qconf_cyc(rename_src, 1);
                     break;
                 } /* space available */
                 instrn->robentry = 1;
@@ -254,7 +289,7 @@ regrename_for_core(CoreResources *core)
                     core->i_registers_used -= instrn->iregs_used;
                     core->f_registers_used -= instrn->fregs_used;
                     instrn->iregs_used = instrn->fregs_used = 0;
-                    log_apps_qconf_cyc(rename_src);
+                    log_apps_qconf_cyc(rename_src, 1);
                     break;
                 } /* space available */
                 else {
@@ -282,7 +317,7 @@ regrename_for_core(CoreResources *core)
                     core->i_registers_used -= instrn->iregs_used;
                     core->f_registers_used -= instrn->fregs_used;
                     instrn->iregs_used = instrn->fregs_used = 0;
-                    log_apps_qconf_cyc(rename_src);
+                    log_apps_qconf_cyc(rename_src, 1);
                     break;
                 } 
                 /* space available */
@@ -306,29 +341,7 @@ regrename_for_core(CoreResources *core)
         instrn->renamecycle = cyc;
     }
 
-    // Update Context Occupancy stats
-    for (i = 0; i < core->n_contexts; i++)
-    {
-        context * restrict ctx = core->contexts[i];
-        ctx->stats.robsizetotal += core->contexts[i]->rob_used;
-        if (ctx->as != NULL){
-            ctx->as->extra->rob_occ += core->contexts[i]->rob_used;
-            ctx->as->extra->iq_occ += ctx->as->extra->iqsize_this_cyc;
-            ctx->as->extra->fq_occ += ctx->as->extra->fqsize_this_cyc;
-            ctx->as->extra->ireg_occ += ctx->as->extra->iregs_this_cyc;
-            ctx->as->extra->freg_occ += ctx->as->extra->fregs_this_cyc;
-            ctx->as->extra->lsq_occ += ctx->as->extra->lsqsize_this_cyc;
-        }
-    }
-    // Update core ireg occupancy stats
-    core->q_stats.iregsizetotal += core->i_registers_used;
-    // Update core freg occupancy stats
-    core->q_stats.fregsizetotal += core->f_registers_used;
-    // Update core lsq occupancy stats
-    core->q_stats.lsqsizetotal += core->lsq_used;
-
-    core->q_stats.iqsizetotal += stageq_count(core->stage.intq);
-    core->q_stats.fqsizetotal += stageq_count(core->stage.floatq);
+    update_occupancy_stats(core, 1);
 
     // Shift instructions from rename1...N-1 to the next stage
     // (rename2...N) if clear
@@ -345,6 +358,119 @@ regrename_for_core(CoreResources *core)
 }
 
 
+// Why an instruction can't leave rename (see rename_stall())
+typedef enum {
+    RenStall_None, RenStall_ROB, RenStall_LSQ, RenStall_IReg, RenStall_FReg,
+    RenStall_FQ, RenStall_IQ
+} RenameStall;
+
+
+// Non-modifying: which of regrename_for_core()'s tests would stop "instrn",
+// at the head of the final rename stage, from leaving rename this cycle?
+// (This must be kept in step with regrename_for_core().)
+static RenameStall
+rename_stall(const CoreResources *core, const activelist *instrn)
+{
+    context * restrict current = Contexts[instrn->thread];
+
+    if (is_shared(ROB) ? (space_available(ROB, current) < 1) :
+        (current->rob_used >= current->params.reorder_buffer_size))
+        return RenStall_ROB;
+    if (instrn->mem_flags &&
+        (is_shared(LSQ) ? (space_available(LSQ, current) < 1) :
+         (core->lsq_used >= core->params.loadstore_queue_size)))
+        return RenStall_LSQ;
+    if (!IS_ZERO_REG(instrn->dest)) {
+        if (!IS_FP_REG(instrn->dest)) {
+            if (is_shared(IREG) ? (space_available(IREG, current) < 1) :
+                (core->i_registers_used >= 
+                 core->params.rename.int_rename_regs))
+                return RenStall_IReg;
+        } else {
+            if (is_shared(FREG) ? (space_available(FREG, current) < 1) :
+                (core->f_registers_used >=
+                 core->params.rename.float_rename_regs))
+                return RenStall_FReg;
+        }
+    }
+    if (instrn->fu == FP) {
+        if (is_shared(FQ) ? (space_available(FQ, current) < 1) :
+            (stageq_count(core->stage.floatq) >=
+             core->params.queue.float_queue_size))
+            return RenStall_FQ;
+    } else {
+        if (is_shared(IQ) ? (space_available(IQ, current) < 1) :
+            (stageq_count(core->stage.intq) >=
+             core->params.queue.int_queue_size))
+            return RenStall_IQ;
+    }
+    return RenStall_None;
+}
+
+
+// For idle-cycle skipping (see run.c): rename is idle when nothing can shift
+// between its stages, and any instruction in the final stage is stalled.
+// Returns "cyc" if not, MAX_CYC otherwise.
+i64
+regrename_idle_until(const CoreResources *core)
+{
+    const int rename1 = core->stage.rename1;
+    const int rename_n = rename1 + core->params.rename.n_stages - 1;
+    const activelist * restrict head = stageq_head(core->stage.s[rename_n]);
+
+    if (head && ((head->status & (INVALID | SQUASHED)) ||
+                 (rename_stall(core, head) == RenStall_None)))
+        return cyc;
+    for (int src_stage = rename_n - 1; src_stage >= rename1; src_stage--) {
+        if ((stageq_count(core->stage.s[src_stage + 1]) == 0) &&
+            (stageq_count(core->stage.s[src_stage]) != 0))
+            return cyc;
+    }
+    return MAX_CYC;
+}
+
+
+// Account for "n_cycles" idle cycles of rename (see regrename_idle_until()):
+// the stall counts, and the occupancy totals
+void
+regrename_skip_idle(CoreResources *core, i64 n_cycles)
+{
+    const int rename_n = core->stage.rename1 + core->params.rename.n_stages
+        - 1;
+    const StageQueue * restrict rename_src = &core->stage.s[rename_n];
+    const activelist * restrict head = stageq_head(*rename_src);
+
+    if (head) {
+        switch (rename_stall(core, head)) {
+        case RenStall_ROB:
+            Contexts[head->thread]->stats.robconf_cyc += n_cycles;
+            break;
+        case RenStall_LSQ:
+            core->q_stats.lsqconf_cyc += n_cycles;
+            break;
+        case RenStall_IReg:
+            core->q_stats.iregconf_cyc += n_cycles;
+            break;
+        case RenStall_FReg:
+            core->q_stats.fregconf_cyc += n_cycles;
+            break;
+        case RenStall_FQ:
+            core->q_stats.fqconf_cyc += n_cycles;
+            log_apps_qconf_cyc(rename_src, n_cycles);
+            break;
+        case RenStall_IQ:
+            core->q_stats.iqconf_cyc += n_cycles;
+            log_apps_qconf_cyc(rename_src, n_cycles);
+            break;
+        default:
+            abort_printf("regrename_skip_idle: C%d not stalled\n",
+                         core->core_id);
+        }
+    }
+    update_occupancy_stats(core, n_cycles);
+}
+
+
 void
 regrename(void)
 {
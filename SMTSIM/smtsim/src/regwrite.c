@@ -116,3 +116,18 @@ regwrite(void)
         }
     }
 }
+
+
+// For idle-cycle skipping (see run.c): regwrite is idle while its stages are
+// empty; returns "cyc" if not, MAX_CYC otherwise.
+i64
+regwrite_idle_until(const CoreResources *core)
+{
+    const int rwrite1 = core->stage.rwrite1;
+    const int rwriteN = rwrite1 + core->params.regwrite.n_stages - 1;
+    for (int stage = rwrite1; stage <= rwriteN; stage++) {
+        if (stageq_count(core->stage.s[stage]) != 0)
+            return cyc;
+    }
+    return MAX_CYC;
+}
@@ -44,6 +44,11 @@
 #include "work-queue.h"
 #include "debug-coverage.h"
 #include "adapt-mgr.h"
+#include "cache-adapt-mgr.h"
+#include "fork-configs.h"
+#include "simpoint.h"
+#include "app-ckpt.h"
+#include "warm-ckpt.h"
 
 i64 cyc;
 i64 allinstructions;
@@ -57,13 +62,6 @@ static i64 DebugExitCycle = -1;
 static int DebugProgress = 0;
 static int DebugShowStages = 0;
 
-i64 commit_instr = 0;
-i64 curr_commit_instr = 0;
-i64 prev_commit_instr = 0;
-i64 prev_cyc = 0;
-i64 cyc_interval = 0;
-double current_ipc = 0;
-
 /*
  *  run() is the controller for virtually all simulation.
  *
@@ -73,6 +71,7 @@ double current_ipc = 0;
 
 
 static void appstate_instcount_check(void);
+static void skip_idle_cycles(void);
 
 
 static void
@@ -176,6 +175,18 @@ int run(void)
     jtimer_startstop(SimTimer, 1);
 
     workq_sim_prestart_jobs(GlobalWorkQueue);
+    warmckpt_restore_apply();
+    if (appckpt_saving()) {
+        appckpt_save_close();
+        warmckpt_save_and_exit_maybe();
+        sim_exit_ok("checkpoint saved");
+    }
+    simpoint_run_maybe();
+    smarts_run_maybe();
+    if (!warmup) {
+        warmckpt_save_and_exit_maybe();
+        forkcfg_split_maybe();
+    }
 
     while(1)
     {
@@ -208,21 +219,6 @@ int run(void)
             callbackq_dump(GlobalEventQueue, stdout, "  GEQ: ");
         callbackq_service(GlobalEventQueue, cyc, NULL);
 
-        //Code for generating periodic stats
-        appstate_global_iter_reset();
-        AppState *as;
-        while ((as = appstate_global_iter_next()) != NULL){
-            if ((cyc > 0) && (cyc % 10000 == 0) && (cyc <= 10000000)){
-                curr_commit_instr = as->extra->total_commits;
-                commit_instr = curr_commit_instr - prev_commit_instr;
-                cyc_interval = cyc - prev_cyc;
-                current_ipc = (double) commit_instr/cyc_interval;
-                printf("Committed Instructions: %s Cycles: %s IPC: %f \n", fmt_i64(commit_instr), fmt_i64(cyc_interval), current_ipc);
-                prev_cyc = cyc;
-                prev_commit_instr = curr_commit_instr;
-            }
-        }
-
         cyc++;
 
 #ifdef DEBUG
@@ -290,15 +286,80 @@ int run(void)
           zero_pstats();
           zero_pipe_stats();
           warmup = 0;
+          warmckpt_save_and_exit_maybe();
+          forkcfg_split_maybe();
           continue;
         }
         sim_exit_ok("allinstructions");
       }
 #endif
+
+        if (GlobalParams.idle_cycle_skip)
+            skip_idle_cycles();
     }
 }
 
 
+// Idle-cycle skipping: when no pipeline stage on any core can do anything
+// until some later cycle -- say, every context is waiting on a long cache
+// miss -- jump "cyc" straight there, rather than simulating each cycle in
+// turn.  Each stage's *_idle_until() gives the earliest cycle at which it
+// might act for a core (<= cyc meaning "now"), given that everything else
+// stays put until then; anything which would change that goes through the
+// cache or global event queues, which give their own next times.  The
+// per-cycle stats the stalled stages would have gathered meanwhile
+// (occupancy totals, stall counts) are added by their *_skip_idle(), so the
+// results are unchanged.
+static void
+skip_idle_cycles(void)
+{
+    static i64 (* const stage_idle_until[])(const CoreResources *) = {
+        commit_idle_until, regwrite_idle_until, execute_idle_until,
+        regread_idle_until, queue_idle_until, regrename_idle_until,
+        decode_idle_until, fetch_idle_until };
+    i64 wake = MIN_SCALAR(cachesim_next_event_time(),
+                          callbackq_next_time(GlobalEventQueue));
+
+    for (int core_id = 0; (core_id < CoreCount) && (wake > cyc); core_id++) {
+        for (int st = 0; (st < NELEM(stage_idle_until)) && (wake > cyc);
+             st++) {
+            i64 stage_wake = stage_idle_until[st](Cores[core_id]);
+            wake = MIN_SCALAR(wake, stage_wake);
+        }
+    }
+    // (MAX_CYC: nothing will ever happen; leave that to run its course)
+    if ((wake <= cyc) || (wake == MAX_CYC))
+        return;
+
+#ifdef DEBUG
+    // Don't jump past any cycle that the DEBUG checks in run() look for
+    if (debug)
+        return;
+    if ((DebugCycle > cyc) && (DebugCycle <= wake))
+        wake = DebugCycle - 1;
+    if ((DebugExitCycle > cyc) && (DebugExitCycle <= wake))
+        wake = DebugExitCycle - 1;
+    if (DebugProgress) {
+        i64 next_progress = (cyc / 1000000 + 1) * 1000000;
+        if (next_progress <= wake)
+            wake = next_progress - 1;
+    }
+    if (wake <= cyc)
+        return;
+#endif
+
+    const i64 n_cycles = wake - cyc;
+    for (int core_id = 0; core_id < CoreCount; core_id++) {
+        CoreResources *core = Cores[core_id];
+        regrename_skip_idle(core, n_cycles);
+        queue_skip_idle(core, n_cycles);
+        decode_skip_idle(core, n_cycles);
+        fetch_skip_idle(core, n_cycles);
+    }
+    cyc = wake;
+}
+
+
 
 // Count the number of instructions which have been discarded (skipped, not
 // allocated alist entries) by in-flight instructions.
@@ -610,6 +671,10 @@ print_sim_stats(int final_stats)
         longmem_flush(GlobalLongMemLogger);
 
     print_adaptmgr_stats();
+    if (GlobalCacheAdaptMgr) {
+        printf("GlobalCacheAdaptMgr stats:\n");
+        cacheadapt_printstats(GlobalCacheAdaptMgr, stdout, "  ");
+    }
     
     if (final_stats) {
         sim_assert(!printed_final);
@@ -630,10 +695,13 @@ sim_exit_ok(const char *short_msg)
     fflush(0);
     printf("***** exiting (%s) *****\n", short_msg);
     print_sim_stats(1);
+    simpoint_child_exiting();
     fflush(0);
 
     // Destroy adapt manager
     adaptmgr_destroy(GlobalAdaptMgr);
+    cacheadapt_destroy(GlobalCacheAdaptMgr);
+    GlobalCacheAdaptMgr = NULL;
     
     // workq_destroy() destroys appstates and such as well
     workq_simulator_exiting(GlobalWorkQueue);
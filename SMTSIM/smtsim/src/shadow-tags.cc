@@ -0,0 +1,113 @@
+//
+// Set-sampled shadow tag directory ("UMON"): estimates the miss rate a
+// cache would see at other associativities, from LRU stack-position hit
+// counts on a small sample of sets
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "utils.h"
+#include "sim-cfg.h"
+#include "shadow-tags.h"
+
+
+using namespace SimCfg;
+using std::string;
+using std::vector;
+
+
+ShadowTagMon::ShadowTagMon(const string& cfg_path, int main_lines)
+{
+    max_assoc = conf_int(cfg_path + "/max_assoc");
+    int sample_sets = conf_int(cfg_path + "/sample_sets");
+    int main_lines_lg = log2_exact(main_lines);
+    int sample_sets_lg = log2_exact(sample_sets);
+    if (max_assoc < 1) {
+        exit_printf("%s/max_assoc (%d) must be positive\n", cfg_path.c_str(),
+                    max_assoc);
+    }
+    if (main_lines_lg < 0) {
+        exit_printf("%s: cache line count (%d) not a power of 2\n",
+                    cfg_path.c_str(), main_lines);
+    }
+    if (sample_sets_lg < 0) {
+        exit_printf("%s/sample_sets (%d) not a power of 2\n",
+                    cfg_path.c_str(), sample_sets);
+    }
+    if (sample_sets_lg > main_lines_lg)
+        sample_sets_lg = main_lines_lg;
+
+    main_line_mask = (1L << main_lines_lg) - 1;
+    sample_lg = main_lines_lg - sample_sets_lg;
+    sample_mask = (1L << sample_lg) - 1;
+    n_sets = 1 << sample_sets_lg;
+
+    tags.resize(n_sets * max_assoc);
+    pos_hits.resize(max_assoc);
+    reset();
+}
+
+
+void
+ShadowTagMon::reset()
+{
+    for (int i = 0; i < (int) tags.size(); ++i) {
+        tags[i].block_num = 0;
+        tags[i].master_id = -1;
+    }
+    reset_stats();
+}
+
+
+void
+ShadowTagMon::reset_stats()
+{
+    for (int i = 0; i < max_assoc; ++i)
+        pos_hits[i] = 0;
+    accesses = 0;
+}
+
+
+void
+ShadowTagMon::access_sampled(long set_num, mem_addr block_num, int master_id)
+{
+    sim_assert((set_num >= 0) && (set_num < n_sets));
+    ShadowTag *set = &tags[set_num * max_assoc];
+    int pos;
+    for (pos = 0; pos < max_assoc; ++pos) {
+        if ((set[pos].master_id == master_id) &&
+            (set[pos].block_num == block_num))
+            break;
+    }
+    accesses++;
+    if (pos < max_assoc) {
+        pos_hits[pos]++;
+    } else {
+        pos = max_assoc - 1;    // miss: LRU entry is replaced
+    }
+    // Move to MRU
+    for (; pos > 0; --pos)
+        set[pos] = set[pos - 1];
+    set[0].block_num = block_num;
+    set[0].master_id = master_id;
+}
+
+
+i64
+ShadowTagMon::get_miss_curve(vector<i64>& est_misses_ret) const
+{
+    i64 scale = i64(1) << sample_lg;
+    i64 misses = accesses;
+    est_misses_ret.resize(max_assoc);
+    for (int assoc = 1; assoc <= max_assoc; ++assoc) {
+        misses -= pos_hits[assoc - 1];
+        est_misses_ret[assoc - 1] = misses * scale;
+    }
+    return accesses * scale;
+}
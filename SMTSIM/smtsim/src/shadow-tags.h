@@ -0,0 +1,70 @@
+// -*- C++ -*-
+//
+// Set-sampled shadow tag directory ("UMON"): estimates the miss rate a
+// cache would see at other associativities, from LRU stack-position hit
+// counts on a small sample of sets
+//
+
+#ifndef SHADOW_TAGS_H
+#define SHADOW_TAGS_H
+
+#include <string>
+#include <vector>
+
+
+// Relevant paper:
+//
+// Utility-Based Cache Partitioning: A Low-Overhead, High-Performance,
+// Runtime Mechanism to Partition Shared Caches; Moinuddin K. Qureshi, Yale
+// N. Patt; MICRO 2006
+//
+// Each sampled set keeps true-LRU tags for up to "max_assoc" ways; a hit at
+// stack position p would have hit in any cache of associativity > p, so the
+// misses at associativity a are the accesses minus the hits at positions
+// [0, a).  Counts are scaled up by the sampling ratio.
+
+
+class ShadowTagMon {
+public:
+    // "main_lines" is the number of sets in the monitored cache; every
+    // (main_lines / sample_sets)-th one is shadowed.  Reads "max_assoc" and
+    // "sample_sets" from config subtree "cfg_path".
+    ShadowTagMon(const std::string& cfg_path, int main_lines);
+
+    int g_max_assoc() const { return max_assoc; }
+
+    // Note an access to the given block (address >> block_bytes_lg)
+    void access(mem_addr block_num, int master_id) {
+        long main_line = long(block_num & main_line_mask);
+        if (!(main_line & sample_mask))
+            access_sampled(main_line >> sample_lg, block_num, master_id);
+    }
+
+    void reset();               // flush tags and zero stats
+    void reset_stats();
+
+    // Writes est_misses_ret[a - 1] = estimated misses at associativity a,
+    // for a in [1, max_assoc]; returns the estimated access count.
+    i64 get_miss_curve(std::vector<i64>& est_misses_ret) const;
+
+private:
+    struct ShadowTag {
+        mem_addr block_num;
+        int master_id;          // -1: invalid
+    };
+
+    int max_assoc;
+    long main_line_mask;
+    int sample_lg;              // log2(main_lines / sample_sets)
+    long sample_mask;
+    int n_sets;
+
+    std::vector<ShadowTag> tags;        // [n_sets][max_assoc], MRU first
+    std::vector<i64> pos_hits;          // [max_assoc]
+    i64 accesses;
+
+    void access_sampled(long set_num, mem_addr block_num, int master_id);
+};
+
+
+#endif  // SHADOW_TAGS_H
@@ -865,6 +865,7 @@ simcfg_sim_params(struct SimParams *dest)
     dest->disable_coredump = t_get_bool("disable_coredump");
     dest->reap_alist_at_squash = t_get_bool("reap_alist_at_squash");
     dest->abort_on_alist_full = t_get_bool("abort_on_alist_full");
+    dest->idle_cycle_skip = t_get_bool("idle_cycle_skip");
 
     dest->long_mem_cyc = t_get_nnint("/Hacking/long_mem_cyc");
     dest->long_mem_at_commit = t_get_bool("/Hacking/long_mem_at_commit");
@@ -33,6 +33,7 @@ typedef struct SimParams {
     int disable_coredump;
     int reap_alist_at_squash;
     int abort_on_alist_full;
+    int idle_cycle_skip;
 
     int long_mem_cyc;
     int long_mem_at_commit;
@@ -0,0 +1,814 @@
+//
+// Sampled simulation: SimPoint representative-interval runs (detailed
+// simulation of just the intervals a SimPoint analysis chose, with results
+// combined by weight), and SMARTS systematic sampling (short detailed
+// samples at regular intervals, with functional warming in between)
+//
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "simpoint.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "sim-params.h"
+#include "app-state.h"
+#include "emulate.h"
+#include "func-warm.h"
+#include "online-stats.h"
+#include "bbtracker.h"
+#include "warm-ckpt.h"
+#include "cache-array.h"
+#include "cache.h"
+#include "core-resources.h"
+#include "context.h"
+#include "main.h"
+#include "syscalls.h"
+
+using std::istringstream;
+using std::map;
+using std::string;
+using std::vector;
+using namespace SimCfg;
+
+
+namespace {
+
+const char *SimPointPath = "SimPoint";
+const char *SmartsPath = "Smarts";
+
+enum SPCache { SPC_ICache, SPC_DCache, SPC_L2Cache, SPC_L3Cache, SPC_last };
+const char *SPCache_names[] = { "ICache", "DCache", "L2Cache", "L3Cache",
+                                NULL };
+
+// What one child measured over its interval
+struct IntervalStats {
+    i64 insts, cycles;
+    i64 hits[SPC_last], misses[SPC_last];
+    bool have_energy;
+    double energy_nj;           // all caches, dynamic + leakage
+    IntervalStats() : insts(0), cycles(0), have_energy(false),
+                      energy_nj(0) {
+        for (int i = 0; i < SPC_last; ++i)
+            hits[i] = misses[i] = 0;
+    }
+    double ipc() const { return (cycles > 0) ? double(insts) / cycles : 0; }
+    double miss_pct(int which) const {
+        i64 lookups = hits[which] + misses[which];
+        return (lookups > 0) ? (100.0 * misses[which] / lookups) : 0;
+    }
+};
+
+// One forked child.  For SMARTS samples, "sp_id" is the sample number and
+// "interval_idx" the instruction it starts at.
+struct SampleChild {
+    i64 sp_id;
+    i64 interval_idx;
+    double weight;
+    string out_name;
+    string sum_name;
+    pid_t pid;                  // -1: never started
+    bool done;
+    int wait_stat;
+    IntervalStats stats;
+    bool have_stats;
+    SampleChild(i64 sp_id_, i64 interval_idx_, double weight_)
+        : sp_id(sp_id_), interval_idx(interval_idx_), weight(weight_),
+          pid(-1), done(false), wait_stat(0), have_stats(false) { }
+    bool operator < (const SampleChild& other) const {
+        return interval_idx < other.interval_idx;
+    }
+};
+
+// SimPoint output file contents: value strings by simpoint ID
+typedef map<i64, string> IdValMap;
+
+bool SplitDone = false;
+bool SmartsDone = false;
+string ChildSumName;            // Non-empty <=> we're a sampling child
+
+
+// Read a SimPoint output file: one "<value> <id>" pair per line
+void
+read_sp_file(const string& filename, IdValMap& vals_ret)
+{
+    std::ifstream in(filename.c_str());
+    if (!in) {
+        exit_printf("%s: couldn't open \"%s\"\n", SimPointPath,
+                    filename.c_str());
+    }
+    vals_ret.clear();
+    string line;
+    int line_num = 0;
+    while (std::getline(in, line)) {
+        line_num++;
+        istringstream fields(line);
+        string val, extra;
+        i64 sp_id;
+        if (!(fields >> val))
+            continue;
+        if (!(fields >> sp_id) || (fields >> extra)) {
+            exit_printf("%s:%d: expected \"<value> <id>\"\n",
+                        filename.c_str(), line_num);
+        }
+        if (!vals_ret.insert(std::make_pair(sp_id, val)).second) {
+            exit_printf("%s:%d: duplicate simpoint ID %s\n",
+                        filename.c_str(), line_num, fmt_i64(sp_id));
+        }
+    }
+}
+
+
+// The chosen intervals and their weights, in program order
+void
+read_simpoints(const string& sp_name, const string& weights_name,
+               vector<SampleChild>& children_ret)
+{
+    IdValMap intervals, weights;
+    read_sp_file(sp_name, intervals);
+    read_sp_file(weights_name, weights);
+    if (intervals.empty()) {
+        exit_printf("%s: no simpoints in \"%s\"\n", SimPointPath,
+                    sp_name.c_str());
+    }
+    children_ret.clear();
+    FOR_CONST_ITER(IdValMap, intervals, iter) {
+        i64 sp_id = iter->first;
+        const string *weight_str = map_find(weights, sp_id);
+        if (!weight_str) {
+            exit_printf("%s: simpoint %s has no weight in \"%s\"\n",
+                        SimPointPath, fmt_i64(sp_id), weights_name.c_str());
+        }
+        char *end;
+        i64 interval_idx = strtoll(iter->second.c_str(), &end, 10);
+        if (*end || (interval_idx < 0)) {
+            exit_printf("%s: bad interval \"%s\" for simpoint %s\n",
+                        sp_name.c_str(), iter->second.c_str(),
+                        fmt_i64(sp_id));
+        }
+        double weight = strtod(weight_str->c_str(), &end);
+        if (*end || !(weight >= 0)) {
+            exit_printf("%s: bad weight \"%s\" for simpoint %s\n",
+                        weights_name.c_str(), weight_str->c_str(),
+                        fmt_i64(sp_id));
+        }
+        children_ret.push_back(SampleChild(sp_id, interval_idx, weight));
+    }
+    std::sort(children_ret.begin(), children_ret.end());
+    for (int i = 1; i < intsize(children_ret); ++i) {
+        if (children_ret[i].interval_idx ==
+            children_ret[i - 1].interval_idx) {
+            exit_printf("%s: simpoints %s and %s share interval %s\n",
+                        sp_name.c_str(), fmt_i64(children_ret[i - 1].sp_id),
+                        fmt_i64(children_ret[i].sp_id),
+                        fmt_i64(children_ret[i].interval_idx));
+        }
+    }
+}
+
+
+AppState *
+find_only_app(const char *mode_name)
+{
+    if (appstate_count() != 1) {
+        exit_printf("%s: needs exactly one app after fast-forwarding; "
+                    "there are %d\n", mode_name, appstate_count());
+    }
+    appstate_global_iter_reset();
+    AppState *as = appstate_global_iter_next();
+    sim_assert(as != NULL);
+    return as;
+}
+
+
+void
+add_cache_stats(IntervalStats& st, SPCache which, const CacheArray *cache)
+{
+    CacheStats cs;
+    CacheEnergyStats es;
+    cache_get_stats(cache, &cs);
+    st.hits[which] += cs.hits;
+    st.misses[which] += cs.misses;
+    if (cache_get_energy(cache, cyc, &es)) {
+        st.have_energy = true;
+        st.energy_nj += es.dyn_nj + es.leak_nj;
+    }
+}
+
+
+// (in the child) stats since they were last zeroed
+void
+collect_stats(IntervalStats& st)
+{
+    for (int i = 0; i < CtxCount; ++i)
+        st.insts += Contexts[i]->stats.instrs;
+    st.cycles = cyc - warmupcyc;
+    for (int i = 0; i < CoreCount; ++i) {
+        const CoreResources *core = Cores[i];
+        add_cache_stats(st, SPC_ICache, core->icache);
+        add_cache_stats(st, SPC_DCache, core->dcache);
+        if (GlobalParams.mem.private_l2caches)
+            add_cache_stats(st, SPC_L2Cache, core->l2cache);
+    }
+    if (!GlobalParams.mem.private_l2caches)
+        add_cache_stats(st, SPC_L2Cache, SharedL2Cache);
+    if (GlobalParams.mem.use_l3cache)
+        add_cache_stats(st, SPC_L3Cache, SharedL3Cache);
+}
+
+
+void
+write_summary(const string& filename, const IntervalStats& st)
+{
+    FILE *out = fopen(filename.c_str(), "w");
+    if (!out) {
+        exit_printf("sampling: couldn't open \"%s\" for writing: %s\n",
+                    filename.c_str(), strerror(errno));
+    }
+    fprintf(out, "insts %s\n", fmt_i64(st.insts));
+    fprintf(out, "cycles %s\n", fmt_i64(st.cycles));
+    for (int i = 0; i < SPC_last; ++i) {
+        fprintf(out, "%s %s %s\n", SPCache_names[i], fmt_i64(st.hits[i]),
+                fmt_i64(st.misses[i]));
+    }
+    if (st.have_energy)
+        fprintf(out, "energy_nj %.17g\n", st.energy_nj);
+    if (fclose(out)) {
+        exit_printf("sampling: write to \"%s\" failed: %s\n",
+                    filename.c_str(), strerror(errno));
+    }
+}
+
+
+bool
+read_summary(const string& filename, IntervalStats& st_ret)
+{
+    std::ifstream in(filename.c_str());
+    if (!in)
+        return false;
+    IntervalStats st;
+    string key;
+    int n_cache_lines = 0;
+    bool got_insts = false, got_cycles = false;
+    while (in >> key) {
+        if (key == "insts") {
+            got_insts = !!(in >> st.insts);
+        } else if (key == "cycles") {
+            got_cycles = !!(in >> st.cycles);
+        } else if (key == "energy_nj") {
+            st.have_energy = !!(in >> st.energy_nj);
+        } else {
+            int which = 0;
+            while (SPCache_names[which] && (key != SPCache_names[which]))
+                which++;
+            if (!SPCache_names[which] ||
+                !(in >> st.hits[which] >> st.misses[which]))
+                return false;
+            n_cache_lines++;
+        }
+    }
+    if (!got_insts || !got_cycles || (n_cache_lines != SPC_last))
+        return false;
+    st_ret = st;
+    return true;
+}
+
+
+// (in the child) set up to simulate "interval" instructions, after
+// "warm_insts" of detailed warmup
+void
+start_child(const SampleChild& child, i64 warm_insts, i64 interval)
+{
+    if (!freopen(child.out_name.c_str(), "w", stdout)) {
+        exit_printf("couldn't open \"%s\" for sampling child %s: %s\n",
+                    child.out_name.c_str(), fmt_i64(child.sp_id),
+                    strerror(errno));
+    }
+    ChildSumName = child.sum_name;
+    // run() takes it from here: the same countdowns as "-wu" warmup
+    // followed by the measured region
+    GlobalParams.thread_length = interval;
+    GlobalParams.allinstructions = interval;
+    zero_cstats();
+    zero_pstats();
+    zero_pipe_stats();
+    if (warm_insts > 0) {
+        warmup = 1;
+        allinstructions = warm_insts;
+    } else {
+        warmup = 0;
+        allinstructions = interval;
+    }
+    fflush(0);
+}
+
+
+// Wait for any one running child; returns its index.  If "block" is
+// false, returns -1 at once if none has finished.
+int
+wait_any(vector<SampleChild>& children, bool block)
+{
+    int wait_stat;
+    pid_t pid;
+    do {
+        pid = waitpid(-1, &wait_stat, (block) ? 0 : WNOHANG);
+    } while ((pid < 0) && (errno == EINTR));
+    if (pid < 0) {
+        exit_printf("sampling: waitpid failed: %s\n", strerror(errno));
+    }
+    if (pid == 0)
+        return -1;
+    for (int i = 0; i < intsize(children); ++i) {
+        SampleChild& child = children[i];
+        if (!child.done && (child.pid == pid)) {
+            child.done = true;
+            child.wait_stat = wait_stat;
+            return i;
+        }
+    }
+    abort_printf("sampling: waitpid returned unknown pid %d\n", int(pid));
+    return -1;
+}
+
+
+void
+report_interval(const SampleChild& child)
+{
+    const IntervalStats& st = child.stats;
+    printf("--SimPoint %s: interval %s weight %.6g: %s insts %s cyc "
+           "IPC %.4f", fmt_i64(child.sp_id), fmt_i64(child.interval_idx),
+           child.weight, fmt_i64(st.insts), fmt_i64(st.cycles), st.ipc());
+    for (int i = 0; i < SPC_last; ++i) {
+        if (st.hits[i] + st.misses[i] > 0)
+            printf(" %s miss %.2f%%", SPCache_names[i], st.miss_pct(i));
+    }
+    if (st.have_energy)
+        printf(" energy %.1f nJ", st.energy_nj);
+    printf("\n");
+}
+
+
+// Combine the per-interval results by weight.  Intervals all cover the same
+// number of instructions (save perhaps the last one in the program), so
+// each one's per-instruction rates are weighted: CPI, misses and lookups
+// per instruction, and energy per instruction.
+void
+report_weighted(const vector<SampleChild>& children, i64 interval)
+{
+    double sum_w = 0, cpi = 0, epi = 0;
+    double mpi[SPC_last], lpi[SPC_last];
+    bool have_energy = true;
+    i64 detailed_insts = 0;
+    for (int i = 0; i < SPC_last; ++i)
+        mpi[i] = lpi[i] = 0;
+    for (int c = 0; c < intsize(children); ++c) {
+        const SampleChild& child = children[c];
+        const IntervalStats& st = child.stats;
+        if (!child.have_stats || (st.insts <= 0))
+            continue;
+        const double w = child.weight;
+        sum_w += w;
+        cpi += w * st.cycles / st.insts;
+        for (int i = 0; i < SPC_last; ++i) {
+            mpi[i] += w * st.misses[i] / st.insts;
+            lpi[i] += w * (st.hits[i] + st.misses[i]) / st.insts;
+        }
+        if (st.have_energy)
+            epi += w * st.energy_nj / st.insts;
+        else
+            have_energy = false;
+        detailed_insts += st.insts;
+    }
+    if (sum_w <= 0) {
+        printf("--SimPoint: no intervals completed; nothing to report\n");
+        return;
+    }
+    cpi /= sum_w;
+    epi /= sum_w;
+    printf("--SimPoint weighted: %s insts simulated in detail, "
+           "weight covered %.6g\n", fmt_i64(detailed_insts), sum_w);
+    printf("--SimPoint weighted: CPI %.4f IPC %.4f\n", cpi,
+           (cpi > 0) ? (1.0 / cpi) : 0.0);
+    for (int i = 0; i < SPC_last; ++i) {
+        if (lpi[i] > 0) {
+            printf("--SimPoint weighted: %s miss rate %.2f%% "
+                   "(%.3f misses/kinst)\n", SPCache_names[i],
+                   100.0 * mpi[i] / lpi[i], 1000.0 * mpi[i] / sum_w);
+        }
+    }
+    if (have_energy) {
+        printf("--SimPoint weighted: cache energy %.4f nJ/inst "
+               "(%.1f nJ per %s-inst interval)\n", epi, epi * interval,
+               fmt_i64(interval));
+    }
+}
+
+// SMARTS estimates: per-sample rates, to be averaged with confidence
+// intervals
+struct SmartsEstimates {
+    BasicStat_Double cpi, epi;          // cycles, nJ per inst
+    BasicStat_Double mpki[SPC_last];    // misses per 1000 insts
+    bool have_energy;                   // every sample had energy stats
+    SmartsEstimates() : have_energy(true) { }
+    void add(const IntervalStats& st) {
+        sim_assert(st.insts > 0);
+        cpi.add_sample(double(st.cycles) / st.insts);
+        if (st.have_energy)
+            epi.add_sample(st.energy_nj / st.insts);
+        else
+            have_energy = false;
+        for (int i = 0; i < SPC_last; ++i)
+            mpki[i].add_sample(1000.0 * st.misses[i] / st.insts);
+    }
+};
+
+
+// Half-width of the confidence interval for the mean of "stat", at "z"
+// standard errors; NaN with fewer than two samples
+double
+ci_half_width(const BasicStat_Double& stat, double z)
+{
+    double var = stat.g_variance(true);
+    if (sim_isnan(var))
+        return SimNAN;
+    return z * sqrt(MAX_SCALAR(var, 0.0) / stat.g_count());
+}
+
+
+// Is the confidence interval within "target" (relative) of the mean?
+bool
+within_error(const BasicStat_Double& stat, double z, double target)
+{
+    double half = ci_half_width(stat, z);
+    return !sim_isnan(half) && (half <= target * fabs(stat.g_mean()));
+}
+
+
+// How many samples it would take to get "stat" within "target", assuming
+// its variation stays the same (0 if unknown)
+i64
+samples_needed(const BasicStat_Double& stat, double z, double target)
+{
+    double mean = stat.g_mean(), var = stat.g_variance(true);
+    if (sim_isnan(var) || (mean == 0) || (target <= 0))
+        return 0;
+    double cv = sqrt(MAX_SCALAR(var, 0.0)) / fabs(mean);
+    return i64(ceil((z * cv / target) * (z * cv / target)));
+}
+
+
+// Reap finished SMARTS samples and fold in their results: all that have
+// already finished, after waiting for at least one if "block" is set.
+// Returns the number which failed.
+int
+smarts_reap(vector<SampleChild>& running, SmartsEstimates& est, bool block)
+{
+    int n_failed = 0, idx;
+    while (!running.empty() && ((idx = wait_any(running, block)) >= 0)) {
+        const SampleChild& child = running[idx];
+        IntervalStats st;
+        bool ok = WIFEXITED(child.wait_stat) &&
+            (WEXITSTATUS(child.wait_stat) == 0) &&
+            read_summary(child.sum_name, st) && (st.insts > 0);
+        unlink(child.sum_name.c_str());
+        if (ok) {
+            est.add(st);
+        } else {
+            printf("--SMARTS sample %s (inst %s) failed (wait status "
+                   "%#x); output: \"%s\"\n", fmt_i64(child.sp_id),
+                   fmt_i64(child.interval_idx), child.wait_stat,
+                   child.out_name.c_str());
+            n_failed++;
+        }
+        running.erase(running.begin() + idx);
+        block = false;
+    }
+    return n_failed;
+}
+
+
+void
+report_estimate(const char *what, const BasicStat_Double& stat, double z,
+                const char *units)
+{
+    double mean = stat.g_mean(), half = ci_half_width(stat, z);
+    printf("--SMARTS: %s %.4f", what, mean);
+    if (!sim_isnan(half)) {
+        printf(" +/- %.4f", half);
+        if (mean != 0)
+            printf(" (%.2f%%)", 100.0 * half / fabs(mean));
+    }
+    printf("%s\n", units);
+}
+
+
+void
+report_smarts(const SmartsEstimates& est, double z, double target)
+{
+    const i64 n = est.cpi.g_count();
+    if (n == 0) {
+        printf("--SMARTS: no samples completed; nothing to report\n");
+        return;
+    }
+    report_estimate("CPI", est.cpi, z, "");
+    printf("--SMARTS: IPC %.4f\n",
+           (est.cpi.g_mean() > 0) ? (1.0 / est.cpi.g_mean()) : 0.0);
+    if (est.have_energy)
+        report_estimate("cache energy", est.epi, z, " nJ/inst");
+    for (int i = 0; i < SPC_last; ++i) {
+        if (est.mpki[i].g_max() > 0) {
+            string what = string(SPCache_names[i]) + " misses/kinst";
+            report_estimate(what.c_str(), est.mpki[i], z, "");
+        }
+    }
+    i64 need = samples_needed(est.cpi, z, target);
+    if (est.have_energy)
+        need = MAX_SCALAR(need, samples_needed(est.epi, z, target));
+    printf("--SMARTS: %s samples, confidence at %.3g standard errors; "
+           "+/-%.3g%% would take about %s\n", fmt_i64(n), z,
+           100.0 * target, (need > 0) ? fmt_i64(need) : "(unknown)");
+}
+
+}       // Anonymous namespace close
+
+
+void
+simpoint_run_maybe(void)
+{
+    const string cp(SimPointPath);
+    if (SplitDone)
+        return;
+    SplitDone = true;
+    if (!have_conf(cp + "/enable") || !conf_bool(cp + "/enable"))
+        return;
+
+    if (BBTrackerParams.create_bbv_file) {
+        exit_printf("%s can't be used while generating BBVs "
+                    "(BasicBlockTracker/create_bbv_file)\n", cp.c_str());
+    }
+    if (have_conf("ForkConfigs/enable") && conf_bool("ForkConfigs/enable")) {
+        exit_printf("%s and ForkConfigs can't be used together\n",
+                    cp.c_str());
+    }
+    if (warmckpt_saving()) {
+        exit_printf("%s can't be used with -warm-save\n", cp.c_str());
+    }
+    const i64 interval = conf_i64(cp + "/interval");
+    if (interval <= 0) {
+        exit_printf("%s/interval (%s) must be positive\n", cp.c_str(),
+                    fmt_i64(interval));
+    }
+    const string out_prefix = conf_str(cp + "/out_prefix");
+    const int max_running = conf_int(cp + "/max_running");
+    if (max_running < 0) {
+        exit_printf("%s/max_running (%d) must be non-negative\n",
+                    cp.c_str(), max_running);
+    }
+    vector<SampleChild> children;
+    read_simpoints(conf_str(cp + "/simpoints_file"),
+                   conf_str(cp + "/weights_file"), children);
+    for (int i = 0; i < intsize(children); ++i) {
+        SampleChild& child = children[i];
+        child.out_name = out_prefix + fmt_i64(child.sp_id) + ".out";
+        child.sum_name = out_prefix + fmt_i64(child.sp_id) + ".sum";
+    }
+
+    AppState *as = find_only_app(SimPointPath);
+    const i64 warm_insts = (warmup) ? warmuptime : 0;
+    printf("--SimPoint: %d intervals of %s insts (%s warmup), A%d starting "
+           "at inst %s\n", intsize(children), fmt_i64(interval),
+           fmt_i64(warm_insts), as->app_id,
+           fmt_i64(as->stats.total_insts));
+
+    int running = 0;
+    for (int i = 0; i < intsize(children); ++i) {
+        SampleChild& child = children[i];
+        const i64 start = child.interval_idx * interval;
+        if (start < as->stats.total_insts) {
+            exit_printf("%s: simpoint %s (interval %s) starts at inst %s, "
+                        "but A%d is already at inst %s\n", cp.c_str(),
+                        fmt_i64(child.sp_id), fmt_i64(child.interval_idx),
+                        fmt_i64(start), as->app_id,
+                        fmt_i64(as->stats.total_insts));
+        }
+        const i64 fork_at = MAX_SCALAR(start - warm_insts,
+                                       as->stats.total_insts);
+        if (fork_at > as->stats.total_insts) {
+            printf("--SimPoint: fast-forwarding A%d to inst %s\n",
+                   as->app_id, fmt_i64(fork_at));
+            fflush(0);
+            fast_forward_app(as, fork_at - as->stats.total_insts);
+        }
+        if (as->exit.has_exit) {
+            printf("--SimPoint: A%d exited at inst %s; skipping simpoint %s "
+                   "and any later ones\n", as->app_id,
+                   fmt_i64(as->stats.total_insts), fmt_i64(child.sp_id));
+            break;
+        }
+        if ((max_running > 0) && (running >= max_running)) {
+            wait_any(children, true);
+            running--;
+        }
+        fflush(0);
+        pid_t pid = fork();
+        if (pid < 0) {
+            exit_printf("%s: couldn't fork for simpoint %s: %s\n", cp.c_str(),
+                        fmt_i64(child.sp_id), strerror(errno));
+        } else if (pid == 0) {
+            // (the parent goes on fast-forwarding this app, and earlier
+            // children may still be running it)
+            syscalls_reopen_host_fds(as->syscall_state);
+            start_child(child, start - fork_at, interval);
+            printf("--SimPoint %s: interval %s (weight %.6g), %s insts of "
+                   "warmup then %s measured\n", fmt_i64(child.sp_id),
+                   fmt_i64(child.interval_idx), child.weight,
+                   fmt_i64(start - fork_at), fmt_i64(interval));
+            return;
+        }
+        child.pid = pid;
+        running++;
+    }
+
+    // parent: no simulation from here on; just collect the results
+    while (running > 0) {
+        wait_any(children, true);
+        running--;
+    }
+    int n_failed = 0, n_started = 0;
+    for (int i = 0; i < intsize(children); ++i) {
+        SampleChild& child = children[i];
+        if (child.pid < 0)
+            continue;
+        n_started++;
+        bool ok = WIFEXITED(child.wait_stat) &&
+            (WEXITSTATUS(child.wait_stat) == 0);
+        child.have_stats = ok && read_summary(child.sum_name, child.stats);
+        if (child.have_stats) {
+            report_interval(child);
+        } else {
+            printf("--SimPoint %s failed (wait status %#x); see \"%s\"\n",
+                   fmt_i64(child.sp_id), child.wait_stat,
+                   child.out_name.c_str());
+            n_failed++;
+        }
+    }
+    report_weighted(children, interval);
+    printf("***** exiting (%d of %d simpoints failed, %d skipped) *****\n",
+           n_failed, n_started, intsize(children) - n_started);
+    fflush(0);
+    exit((n_failed) ? 1 : 0);
+}
+
+
+void
+smarts_run_maybe(void)
+{
+    const string cp(SmartsPath);
+    if (SmartsDone)
+        return;
+    SmartsDone = true;
+    if (!have_conf(cp + "/enable") || !conf_bool(cp + "/enable"))
+        return;
+
+    if (BBTrackerParams.create_bbv_file) {
+        exit_printf("%s can't be used while generating BBVs "
+                    "(BasicBlockTracker/create_bbv_file)\n", cp.c_str());
+    }
+    if (have_conf("ForkConfigs/enable") && conf_bool("ForkConfigs/enable")) {
+        exit_printf("%s and ForkConfigs can't be used together\n",
+                    cp.c_str());
+    }
+    if (have_conf(string(SimPointPath) + "/enable") &&
+        conf_bool(string(SimPointPath) + "/enable")) {
+        exit_printf("%s and %s can't be used together\n", cp.c_str(),
+                    SimPointPath);
+    }
+    if (warmckpt_saving()) {
+        exit_printf("%s can't be used with -warm-save\n", cp.c_str());
+    }
+    if (warmup) {
+        exit_printf("%s: use %s/detailed_warmup instead of -wu\n",
+                    cp.c_str(), cp.c_str());
+    }
+    const i64 period = conf_i64(cp + "/period");
+    const i64 warm_insts = conf_i64(cp + "/detailed_warmup");
+    const i64 measure = conf_i64(cp + "/measure");
+    if ((measure <= 0) || (warm_insts < 0) ||
+        (period < warm_insts + measure)) {
+        exit_printf("%s: need measure (%s) > 0, detailed_warmup (%s) >= 0, "
+                    "and period (%s) covering both\n", cp.c_str(),
+                    fmt_i64(measure), fmt_i64(warm_insts), fmt_i64(period));
+    }
+    const double z = conf_double(cp + "/z_score");
+    const double target = conf_double(cp + "/target_error");
+    const int min_samples = conf_int(cp + "/min_samples");
+    const i64 max_samples = conf_i64(cp + "/max_samples");
+    if (!(z > 0) || !(target > 0) || (min_samples < 2) ||
+        (max_samples < 0)) {
+        exit_printf("%s: need z_score > 0, target_error > 0, "
+                    "min_samples >= 2, and max_samples >= 0\n", cp.c_str());
+    }
+    const string out_prefix = conf_str(cp + "/out_prefix");
+    const bool keep_outputs = conf_bool(cp + "/keep_outputs");
+    const int max_running = conf_int(cp + "/max_running");
+    if (max_running < 0) {
+        exit_printf("%s/max_running (%d) must be non-negative\n",
+                    cp.c_str(), max_running);
+    }
+
+    AppState *as = find_only_app(SmartsPath);
+    CoreResources *core = fwarm_core_for_app(as);
+    const i64 start_inst = as->stats.total_insts;
+    printf("--SMARTS: sampling A%d from inst %s, every %s insts: %s insts "
+           "detailed warmup then %s measured, until +/-%.3g%% at %.3g "
+           "standard errors\n", as->app_id, fmt_i64(start_inst),
+           fmt_i64(period), fmt_i64(warm_insts), fmt_i64(measure),
+           100.0 * target, z);
+
+    SmartsEstimates est;
+    vector<SampleChild> running;
+    i64 n_started = 0;
+    int n_failed = 0;
+    bool converged = false;
+    while ((max_samples == 0) || (n_started < max_samples)) {
+        // functional warming up to the next sample
+        fwarm_fast_forward(core, as, period - warm_insts - measure);
+        if (as->exit.has_exit) {
+            printf("--SMARTS: A%d exited at inst %s\n", as->app_id,
+                   fmt_i64(as->stats.total_insts));
+            break;
+        }
+        n_failed += smarts_reap(running, est, false);
+        if ((max_running > 0) && (intsize(running) >= max_running))
+            n_failed += smarts_reap(running, est, true);
+        converged = (est.cpi.g_count() >= min_samples) &&
+            within_error(est.cpi, z, target) &&
+            (!est.have_energy || within_error(est.epi, z, target));
+        if (converged)
+            break;
+
+        SampleChild child(n_started, as->stats.total_insts, 1.0);
+        child.out_name = (keep_outputs) ?
+            (out_prefix + fmt_i64(child.sp_id) + ".out") : "/dev/null";
+        child.sum_name = out_prefix + fmt_i64(child.sp_id) + ".sum";
+        fflush(0);
+        pid_t pid = fork();
+        if (pid < 0) {
+            exit_printf("%s: couldn't fork for sample %s: %s\n", cp.c_str(),
+                        fmt_i64(child.sp_id), strerror(errno));
+        } else if (pid == 0) {
+            // (the parent goes on emulating this app's file I/O too)
+            syscalls_reopen_host_fds(as->syscall_state);
+            start_child(child, warm_insts, measure);
+            printf("--SMARTS sample %s: A%d inst %s, %s insts of warmup "
+                   "then %s measured\n", fmt_i64(child.sp_id), as->app_id,
+                   fmt_i64(child.interval_idx), fmt_i64(warm_insts),
+                   fmt_i64(measure));
+            return;
+        }
+        child.pid = pid;
+        running.push_back(child);
+        n_started++;
+
+        // the parent warms through the sample too, then carries on
+        fwarm_fast_forward(core, as, warm_insts + measure);
+    }
+
+    while (!running.empty())
+        n_failed += smarts_reap(running, est, true);
+    printf("--SMARTS: %s insts functionally warmed, %s samples started\n",
+           fmt_i64(as->stats.total_insts - start_inst), fmt_i64(n_started));
+    report_smarts(est, z, target);
+    printf("***** exiting (%s; %d of %s samples failed) *****\n",
+           (converged) ? "error target met" : "error target NOT met",
+           n_failed, fmt_i64(n_started));
+    fflush(0);
+    exit((n_failed) ? 1 : 0);
+}
+
+
+void
+simpoint_child_exiting(void)
+{
+    if (ChildSumName.empty())
+        return;
+    IntervalStats st;
+    collect_stats(st);
+    write_summary(ChildSumName, st);
+}
@@ -0,0 +1,68 @@
+//
+// Sampled simulation: SimPoint representative-interval runs, and SMARTS
+// systematic sampling with functional warming
+//
+
+#ifndef SIMPOINT_H
+#define SIMPOINT_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Run in SimPoint mode, if "SimPoint/enable" is set.  This is called once,
+// after the initial job has been fast-forwarded (or restored from a
+// checkpoint), before detailed simulation begins.
+//
+// "simpoints_file" and "weights_file" are SimPoint's output for the BBVs of
+// this workload (see BasicBlockTracker): lines of "<interval> <id>" and
+// "<weight> <id>", where interval K covers instructions [K*interval,
+// (K+1)*interval) from the start of the program.  The parent process
+// fast-forwards the job through the chosen intervals in order, forking one
+// child at the start of each (at most "max_running" at a time, 0 for no
+// limit); if there's a "-wu" warmup, the fork happens that many
+// instructions early, and the child warms up in detail before measuring.
+// Each child sends its stdout to "<out_prefix><id>.out", simulates one
+// interval's worth of instructions, and exits, leaving a summary for the
+// parent.  The parent never returns: it prints each interval's IPC, cache
+// miss rates and cache energy, then the weighted whole-program estimates,
+// and exits with nonzero status if any child failed.
+//
+// This requires a single job, and the intervals must come from the same
+// workload and inputs (none may start before the job's fast-forward point).
+void simpoint_run_maybe(void);
+
+// Run in SMARTS mode, if "Smarts/enable" is set; called just after
+// simpoint_run_maybe().
+//
+// The single job is sampled every "period" instructions.  Between samples,
+// the parent functionally warms the job's core (see fwarm_fast_forward()).
+// At each sample it forks a child which simulates "detailed_warmup"
+// instructions in detail, then measures the next "measure" instructions,
+// and exits, leaving a summary; the parent warms on through those same
+// instructions.  Each finished sample's CPI, cache energy per instruction,
+// and cache misses per instruction are folded into running means.  Once
+// there are at least "min_samples", and the confidence intervals on CPI
+// and energy ("z_score" standard errors wide) are within "target_error" of
+// their means, no more samples are started; the estimates then cover the
+// part of the program sampled so far.  Sampling also stops after
+// "max_samples" (0 for no limit), or when the job exits.  The parent never
+// returns: it prints the means with their confidence intervals, and exits
+// with nonzero status if any sample failed.
+//
+// At most "max_running" samples run at once (0 for no limit).  Each
+// child's stdout goes to "<out_prefix><sample #>.out" if "keep_outputs" is
+// set, and is discarded otherwise.
+void smarts_run_maybe(void);
+
+// In a SimPoint or SMARTS child, write the interval summary for the
+// parent.  Called as the simulator exits, after the final stats are
+// printed; a no-op otherwise.
+void simpoint_child_exiting(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIMPOINT_H
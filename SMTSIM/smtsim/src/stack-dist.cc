@@ -0,0 +1,283 @@
+//
+// Single-pass LRU stack-distance profiler: miss-rate curves for every
+// power-of-two cache size, at each power-of-two associativity and fully
+// associative, from one cache's access stream
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "hash-map.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-cfg.h"
+#include "stack-dist.h"
+
+
+using namespace SimCfg;
+using std::string;
+using std::vector;
+
+
+namespace {
+
+// Smallest Fenwick tree kept across compactions
+const long MinFenwickCap = 1 << 16;
+
+}       // Anonymous namespace close
+
+
+#if HAVE_HASHMAP
+struct StackDistProfiler::LastUseMap
+    : public hash_map<LongAddr, long, StlHashMethod<LongAddr> > { };
+#else
+struct StackDistProfiler::LastUseMap
+    : public std::map<LongAddr, long> { };
+#endif
+
+
+StackDistProfiler::StackDistProfiler(const string& cfg_path, int block_bytes)
+    : last_use(new LastUseMap())
+{
+    min_kb = conf_int(cfg_path + "/min_kb");
+    int max_kb = conf_int(cfg_path + "/max_kb");
+    max_assoc = conf_int(cfg_path + "/max_assoc");
+    int min_kb_lg = log2_exact(min_kb);
+    int max_kb_lg = log2_exact(max_kb);
+    max_assoc_lg = log2_exact(max_assoc);
+    block_bytes_lg = log2_exact(block_bytes);
+    if ((min_kb_lg < 0) || (max_kb_lg < 0) || (max_kb_lg < min_kb_lg)) {
+        exit_printf("%s: min_kb/max_kb (%d/%d) must be powers of 2, "
+                    "min <= max\n", cfg_path.c_str(), min_kb, max_kb);
+    }
+    if (max_assoc_lg < 0) {
+        exit_printf("%s/max_assoc (%d) not a power of 2\n", cfg_path.c_str(),
+                    max_assoc);
+    }
+    sim_assert(block_bytes_lg >= 0);
+    n_sizes = max_kb_lg - min_kb_lg + 1;
+
+    // Sets needed: from the smallest size at max_assoc, up to the largest
+    // size direct-mapped
+    int kb_to_blocks_lg = 10 - block_bytes_lg;
+    min_sets_lg = MAX_SCALAR(min_kb_lg + kb_to_blocks_lg - max_assoc_lg, 0);
+    int max_sets_lg = max_kb_lg + kb_to_blocks_lg;
+    if (max_sets_lg < 0) {
+        exit_printf("%s/max_kb (%d) smaller than one block\n",
+                    cfg_path.c_str(), max_kb);
+    }
+    stacks.resize(max_sets_lg - min_sets_lg + 1);
+    for (int i = 0; i < int(stacks.size()); ++i) {
+        SetStacks& ss = stacks[i];
+        long n_sets = 1L << (min_sets_lg + i);
+        ss.set_mask = n_sets - 1;
+        ss.tags.resize(n_sets * max_assoc);
+        ss.pos_hits.resize(max_assoc);
+    }
+    fa_first_hit.resize(n_sizes);
+    reset();
+}
+
+
+StackDistProfiler::~StackDistProfiler()
+{
+    delete last_use;
+}
+
+
+void
+StackDistProfiler::reset()
+{
+    for (int i = 0; i < int(stacks.size()); ++i) {
+        vector<StackTag>& tags = stacks[i].tags;
+        for (int t = 0; t < int(tags.size()); ++t) {
+            tags[t].block_num = 0;
+            tags[t].master_id = -1;
+        }
+    }
+    last_use->clear();
+    fen_cap = MinFenwickCap;
+    fen.assign(fen_cap + 1, 0);
+    next_time = 1;
+    reset_stats();
+}
+
+
+void
+StackDistProfiler::reset_stats()
+{
+    for (int i = 0; i < int(stacks.size()); ++i) {
+        vector<i64>& pos_hits = stacks[i].pos_hits;
+        std::fill(pos_hits.begin(), pos_hits.end(), 0);
+    }
+    std::fill(fa_first_hit.begin(), fa_first_hit.end(), 0);
+    accesses = 0;
+}
+
+
+void
+StackDistProfiler::fen_add(long time, int delta)
+{
+    sim_assert((time >= 1) && (time <= fen_cap));
+    for (; time <= fen_cap; time += time & -time)
+        fen[time] += delta;
+}
+
+
+long
+StackDistProfiler::fen_sum(long time) const
+{
+    long sum = 0;
+    for (; time > 0; time -= time & -time)
+        sum += fen[time];
+    return sum;
+}
+
+
+// Renumber the marked times 1..n in order, and rebuild the tree with room
+// to grow
+void
+StackDistProfiler::fen_compact()
+{
+    long n_live = long(last_use->size());
+    // (times are unique, so bucketing by time sorts them)
+    vector<LastUseMap::iterator> by_time(next_time);
+    vector<bool> time_used(next_time, false);
+    FOR_ITER(LastUseMap, *last_use, iter) {
+        by_time[iter->second] = iter;
+        time_used[iter->second] = true;
+    }
+    fen_cap = MAX_SCALAR(2 * n_live, MinFenwickCap);
+    fen.assign(fen_cap + 1, 0);
+    long t = 0;
+    for (long old_t = 1; old_t < next_time; ++old_t) {
+        if (!time_used[old_t])
+            continue;
+        ++t;
+        by_time[old_t]->second = t;
+        fen[t] = 1;
+    }
+    sim_assert(t == n_live);
+    // Linear-time build: each node passes its total up to its parent
+    for (long node = 1; node <= fen_cap; ++node) {
+        long parent = node + (node & -node);
+        if (parent <= fen_cap)
+            fen[parent] += fen[node];
+    }
+    next_time = n_live + 1;
+}
+
+
+void
+StackDistProfiler::access_fa(const LongAddr& key)
+{
+    if (next_time > fen_cap)
+        fen_compact();
+    std::pair<LastUseMap::iterator, bool> ins =
+        last_use->insert(std::make_pair(key, next_time));
+    if (!ins.second) {
+        long prev_time = ins.first->second;
+        long dist = long(last_use->size()) - fen_sum(prev_time);
+        fen_add(prev_time, -1);
+        ins.first->second = next_time;
+        // Smallest size (in blocks) holding more than "dist" blocks
+        long size_blocks = long(min_kb) << (10 - block_bytes_lg);
+        for (int size_idx = 0; size_idx < n_sizes; ++size_idx) {
+            if (dist < size_blocks) {
+                fa_first_hit[size_idx]++;
+                break;
+            }
+            size_blocks *= 2;
+        }
+    }
+    fen_add(next_time, 1);
+    next_time++;
+}
+
+
+void
+StackDistProfiler::access_sets(SetStacks& ss, mem_addr block_num,
+                               int master_id)
+{
+    StackTag *set = &ss.tags[long(block_num & ss.set_mask) * max_assoc];
+    int pos;
+    for (pos = 0; pos < max_assoc; ++pos) {
+        if ((set[pos].master_id == master_id) &&
+            (set[pos].block_num == block_num))
+            break;
+    }
+    if (pos < max_assoc) {
+        ss.pos_hits[pos]++;
+    } else {
+        pos = max_assoc - 1;
+    }
+    for (; pos > 0; --pos)
+        set[pos] = set[pos - 1];
+    set[0].block_num = block_num;
+    set[0].master_id = master_id;
+}
+
+
+void
+StackDistProfiler::access(mem_addr block_num, int master_id)
+{
+    accesses++;
+    access_fa(LongAddr(block_num, master_id));
+    for (int i = 0; i < int(stacks.size()); ++i)
+        access_sets(stacks[i], block_num, master_id);
+}
+
+
+i64
+StackDistProfiler::misses(int size_idx, int assoc) const
+{
+    sim_assert((size_idx >= 0) && (size_idx < n_sizes));
+    i64 result = accesses;
+    if (assoc == 0) {
+        for (int i = 0; i <= size_idx; ++i)
+            result -= fa_first_hit[i];
+    } else {
+        int assoc_lg = log2_exact(assoc);
+        sim_assert((assoc_lg >= 0) && (assoc <= max_assoc));
+        int sets_lg = log2_exact(min_kb) + size_idx + 10 - block_bytes_lg -
+            assoc_lg;
+        if (sets_lg < 0)
+            return -1;
+        sim_assert(sets_lg >= min_sets_lg);
+        const SetStacks& ss = stacks[sets_lg - min_sets_lg];
+        for (int pos = 0; pos < assoc; ++pos)
+            result -= ss.pos_hits[pos];
+    }
+    return result;
+}
+
+
+void
+StackDistProfiler::print(const char *pref, const char *name) const
+{
+    printf("%s%s: stack-dist accesses: %s\n", pref, name,
+           fmt_i64(accesses));
+    for (int assoc_lg = 0; assoc_lg <= max_assoc_lg + 1; ++assoc_lg) {
+        int assoc = (assoc_lg <= max_assoc_lg) ? (1 << assoc_lg) : 0;
+        if (assoc)
+            printf("%s%s: stack-dist miss rate, %d-way:", pref, name, assoc);
+        else
+            printf("%s%s: stack-dist miss rate, full:", pref, name);
+        for (int size_idx = 0; size_idx < n_sizes; ++size_idx) {
+            i64 m = misses(size_idx, assoc);
+            if (m < 0)
+                continue;
+            printf(" %dK:%.4f", g_size_kb(size_idx), (accesses > 0) ?
+                   (double(m) / accesses) : 0.0);
+        }
+        printf("\n");
+    }
+}
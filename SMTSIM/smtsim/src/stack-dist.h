@@ -0,0 +1,106 @@
+// -*- C++ -*-
+//
+// Single-pass LRU stack-distance profiler: miss-rate curves for every
+// power-of-two cache size, at each power-of-two associativity and fully
+// associative, from one cache's access stream
+//
+
+#ifndef STACK_DIST_H
+#define STACK_DIST_H
+
+#include <string>
+#include <vector>
+
+
+// Relevant papers:
+//
+// Evaluation Techniques for Storage Hierarchies; R. L. Mattson, J. Gecsei,
+// D. R. Slutz, I. L. Traiger; IBM Systems Journal 9(2), 1970
+//
+// Efficient Methods for Calculating the Success Function of Fixed Space
+// Replacement Policies; Frank Olken; LBL Tech. Report 12370, 1981
+//
+// LRU has the inclusion property: an access with stack distance d (distinct
+// blocks touched since the last access to the same block) hits in any LRU
+// cache holding more than d blocks.  Fully-associative distances are found
+// in O(log n) per access with a Fenwick tree over access times, in which
+// each block marks only its most recent access; the distance is then the
+// number of marks after the block's previous access.  The tree is compacted
+// (times renumbered) when it fills up.
+//
+// For set-associative caches, a size and associativity fix the set count,
+// and per-set stack distances (only those below "max_assoc" matter) then
+// give the misses at every associativity for that set count.  So, one
+// bounded per-set LRU stack is kept for each set count the size range
+// needs.
+
+
+class StackDistProfiler {
+public:
+    // Reads "min_kb", "max_kb", and "max_assoc" (all powers of 2) from
+    // config subtree "cfg_path".
+    StackDistProfiler(const std::string& cfg_path, int block_bytes);
+    ~StackDistProfiler();
+
+    // Note an access to the given block (address >> block_bytes_lg)
+    void access(mem_addr block_num, int master_id);
+
+    void reset();               // flush all state and zero stats
+    void reset_stats();
+
+    int g_n_sizes() const { return n_sizes; }
+    int g_size_kb(int size_idx) const { return min_kb << size_idx; }
+    int g_max_assoc() const { return max_assoc; }
+    i64 g_accesses() const { return accesses; }
+
+    // Misses for a cache of size g_size_kb(size_idx) and associativity
+    // "assoc" (a power of 2 <= max_assoc, or 0 for fully-associative).
+    // Returns -1 if the cache would have fewer than "assoc" blocks.
+    i64 misses(int size_idx, int assoc) const;
+
+    void print(const char *pref, const char *name) const;
+
+private:
+    struct StackTag {
+        mem_addr block_num;
+        int master_id;          // -1: invalid
+    };
+    struct LastUseMap;          // (hash map; defined in stack-dist.cc)
+
+    // A set-associative stack group: bounded LRU stacks for one set count
+    struct SetStacks {
+        long set_mask;
+        std::vector<StackTag> tags;     // [n_sets][max_assoc], MRU first
+        std::vector<i64> pos_hits;      // [max_assoc]
+    };
+
+    int block_bytes_lg;
+    int min_kb;
+    int n_sizes;
+    int max_assoc;
+    int max_assoc_lg;
+    int min_sets_lg;            // set count of stacks[0]
+    std::vector<SetStacks> stacks;
+
+    // Fully-associative state
+    LastUseMap *last_use;       // block -> time of last access
+    std::vector<int> fen;       // Fenwick tree over times [1, fen_cap]
+    long fen_cap;
+    long next_time;
+    std::vector<i64> fa_first_hit;      // [n_sizes]: smallest size hit
+
+    i64 accesses;
+
+    void access_fa(const LongAddr& key);
+    void access_sets(SetStacks& ss, mem_addr block_num, int master_id);
+    void fen_add(long time, int delta);
+    long fen_sum(long time) const;      // marks at times [1, time]
+    void fen_compact();
+
+    // Disallow copying
+    StackDistProfiler(const StackDistProfiler&);
+    StackDistProfiler& operator = (const StackDistProfiler&);
+};
+
+
+#endif  // STACK_DIST_H
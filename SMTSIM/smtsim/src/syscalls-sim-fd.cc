@@ -29,6 +29,7 @@ const char RCSid_1258860312[] =
 #include "utils-cc.h"
 #include "hash-map.h"
 #include "debug-coverage.h"
+#include "ckpt-io.h"
 
 #include "syscalls-private.h"
 
@@ -810,6 +811,127 @@ SimulatedFD::sim_getdirentries(ProgMem *pmem, mem_addr buf_va, i64 buf_bytes,
 }
 
 
+// Internal helper: read back host_fd_'s re-openable status flags, and its
+// file offset.  Returns false on failure, with errno set.
+bool
+SimulatedFD::get_host_pos(int *host_flags_ret, i64 *offset_ret) const
+{
+    int host_flags = fcntl(host_fd_, F_GETFL);
+    off_t offset = lseek(host_fd_, 0, SEEK_CUR);
+    if ((host_flags < 0) || (offset < 0))
+        return false;
+    *host_flags_ret = host_flags & (O_ACCMODE | O_APPEND | O_NONBLOCK);
+    *offset_ret = offset;
+    return true;
+}
+
+
+// Internal helper: open "path" with "host_flags" as our own host_fd_,
+// positioned at "offset".  On failure, returns false with errno set, and
+// leaves host_fd_ alone.
+bool
+SimulatedFD::open_host_at(const char *path, int host_flags, i64 offset)
+{
+    int new_fd = open(path, host_flags);
+    if (new_fd < 0)
+        return false;
+    if (lseek(new_fd, offset, SEEK_SET) != offset) {
+        int save_errno = errno;
+        close(new_fd);
+        errno = save_errno;
+        return false;
+    }
+    host_fd_ = new_fd;
+    host_fd_owned_ = true;
+    return true;
+}
+
+
+void
+SimulatedFD::ckpt_save(std::ostream& out) const
+{
+    sim_assert(this->is_open());
+    if (doing_dir_io()) {
+        exit_printf("can't checkpoint simulated FD %d (\"%s\"): directory "
+                    "stream in use\n", alpha_fd_, host_path_.c_str());
+    }
+    ckpt_put(out, host_fd_owned_);
+    if (!host_fd_owned_)
+        return;
+
+    int host_flags = 0;
+    i64 offset = 0;
+    if (!get_host_pos(&host_flags, &offset)) {
+        exit_printf("can't checkpoint simulated FD %d (\"%s\"): %s\n",
+                    alpha_fd_, host_path_.c_str(), strerror(errno));
+    }
+    ckpt_put_str(out, host_path_);
+    ckpt_put(out, host_flags);
+    ckpt_put(out, offset);
+    ckpt_put(out, alpha_fd_flags_);
+    ckpt_put(out, alpha_file_flags_);
+    ckpt_put(out, alpha_async_pid_);
+}
+
+
+bool
+SimulatedFD::ckpt_restore(std::istream& in)
+{
+    sim_assert(!this->is_open());
+    bool was_owned;
+    ckpt_get(in, was_owned, "SimulatedFD owned");
+    if (!was_owned)
+        return false;
+
+    int host_flags;
+    i64 offset;
+    ckpt_get_str(in, host_path_, "SimulatedFD path");
+    ckpt_get(in, host_flags, "SimulatedFD flags");
+    ckpt_get(in, offset, "SimulatedFD offset");
+    ckpt_get(in, alpha_fd_flags_, "SimulatedFD fd_flags");
+    ckpt_get(in, alpha_file_flags_, "SimulatedFD file_flags");
+    ckpt_get(in, alpha_async_pid_, "SimulatedFD async_pid");
+
+    errno_ = 0;
+    if (!open_host_at(host_path_.c_str(), host_flags, offset)) {
+        exit_printf("checkpoint restore: can't re-open \"%s\" at offset "
+                    "%s: %s\n", host_path_.c_str(), fmt_i64(offset),
+                    strerror(errno));
+    }
+    return true;
+}
+
+
+void
+SimulatedFD::reopen_host_fd()
+{
+    sim_assert(this->is_open());
+    struct stat host_stat;
+    if (doing_dir_io() || (fstat(host_fd_, &host_stat) < 0) ||
+        !S_ISREG(host_stat.st_mode))
+        return;
+    int host_flags = 0;
+    i64 offset = 0;
+    if (!get_host_pos(&host_flags, &offset)) {
+        exit_printf("can't re-open simulated FD %d (\"%s\"): %s\n",
+                    alpha_fd_, host_path_.c_str(), strerror(errno));
+    }
+    // (host_path_ for simulated stdio is just a label; the FILE * stays
+    // open on the old descriptor, so that's left for its owner to close)
+    const int old_fd = host_fd_;
+    const bool old_owned = host_fd_owned_;
+    const string path = (old_owned) ? host_path_ :
+        (string("/dev/fd/") + fmt_i64(old_fd));
+    if (!open_host_at(path.c_str(), host_flags, offset)) {
+        exit_printf("can't re-open simulated FD %d (\"%s\") at offset %s: "
+                    "%s\n", alpha_fd_, path.c_str(), fmt_i64(offset),
+                    strerror(errno));
+    }
+    if (old_owned)
+        close(old_fd);
+}
+
+
 bool
 SimulatedFD::sim_select_readfd() const
 {
@@ -17,6 +17,7 @@
 #include "utils-cc.h"
 #include "callback-queue.h"
 
+#include <iosfwd>
 #include <set>
 #include <string>
 
@@ -81,6 +82,8 @@ class SimulatedFD {
 
     bool doing_dir_io() const { return c_DIR_dir_ != NULL; }
     void dir_teardown();
+    bool get_host_pos(int *host_flags_ret, i64 *offset_ret) const;
+    bool open_host_at(const char *path, int host_flags, i64 offset);
     std::string describe_syscall_loc() const;
 
 public:
@@ -145,6 +148,25 @@ public:
     bool sim_select_writefd() const;
     bool sim_select_exceptfd() const;
 
+    // Checkpoint support.  ckpt_save() records how to re-open this
+    // descriptor: its host path, access mode, file offset, and fcntl flags.
+    // ckpt_restore(), on a new (not yet opened) SimulatedFD, reads such a
+    // record and re-opens the file (without O_CREAT/O_TRUNC) at the saved
+    // offset, returning true.  Descriptors set up via open_cfile_*() (e.g.
+    // simulated stdio) are recorded as such, and not re-opened; for those,
+    // ckpt_restore() returns false, leaving this SimulatedFD closed.
+    // Directory streams can't be checkpointed.
+    void ckpt_save(std::ostream& out) const;
+    bool ckpt_restore(std::istream& in);
+
+    // Give this descriptor a host open-file of its own, re-opening its file
+    // (without O_CREAT/O_TRUNC) at the current offset, as ckpt_restore()
+    // would.  For use in a fork()ed child, which would otherwise share file
+    // offsets with its parent and siblings.  Simulated stdio is re-opened
+    // through /dev/fd; descriptors on non-regular files (ttys, pipes,
+    // /dev/null) and directory streams are left as they are.
+    void reopen_host_fd();
+
     // Not implemented (yet, since they've not been used in simulated apps):
     //   dup
     //   dup2
@@ -65,6 +65,7 @@
 #include "callback-queue.h"
 #include "syscalls-sim-fd.h"
 #include "debug-coverage.h"
+#include "ckpt-io.h"
 
 #include "syscalls-private.h"
 #include "syscalls-private-nums.h"
@@ -215,6 +216,8 @@ class SimulatedIDPool {
 public:
     SimulatedIDPool(u64 base_value);
     u64 host_to_alpha(u64 host_id);
+    void ckpt_save(std::ostream& out) const;
+    void ckpt_restore(std::istream& in);
 };
 
 
@@ -241,6 +244,36 @@ SimulatedIDPool::host_to_alpha(u64 host_id)
 }
 
 
+void
+SimulatedIDPool::ckpt_save(std::ostream& out) const
+{
+    ckpt_put(out, next_alloc_id_);
+    ckpt_put(out, i64(host_to_alpha_.size()));
+    FOR_CONST_ITER(IDMap, host_to_alpha_, iter) {
+        ckpt_put(out, iter->first);
+        ckpt_put(out, iter->second);
+    }
+}
+
+
+void
+SimulatedIDPool::ckpt_restore(std::istream& in)
+{
+    i64 count;
+    ckpt_get(in, next_alloc_id_, "SimulatedIDPool next_id");
+    ckpt_get(in, count, "SimulatedIDPool count");
+    host_to_alpha_.clear();
+    alpha_to_host_.clear();
+    for (i64 i = 0; i < count; i++) {
+        u64 host_id, alpha_id;
+        ckpt_get(in, host_id, "SimulatedIDPool host_id");
+        ckpt_get(in, alpha_id, "SimulatedIDPool alpha_id");
+        map_put_uniq(host_to_alpha_, host_id, alpha_id);
+        map_put_uniq(alpha_to_host_, alpha_id, host_id);
+    }
+}
+
+
 }       // Anonymous namespace close
 
 
@@ -2818,3 +2851,92 @@ syscalls_destroy(SyscallState *sst)
 {
     delete sst;
 }
+
+
+void
+syscalls_reopen_host_fds(SyscallState *sst)
+{
+    FOR_ITER(SyscallState::SimulatedFDMap, sst->valid_fds, iter) {
+        iter->second->reopen_host_fd();
+    }
+}
+
+
+void
+syscalls_ckpt_save(const SyscallState *sst, std::ostream& out)
+{
+    if (sst->recording_delta_log || sst->playing_delta_log) {
+        exit_printf("can't checkpoint syscall state while a delta log is "
+                    "being recorded or played\n");
+    }
+    ckpt_put_tag(out, "SyscallState");
+    ckpt_put(out, sst->local_clock);
+    ckpt_put_str(out, sst->local_path);
+    ckpt_put(out, sst->alpha_uid);
+    ckpt_put(out, sst->alpha_gid);
+    ckpt_put(out, sst->alpha_pid);
+    sst->alpha_inode_nums.ckpt_save(out);
+    sst->alpha_dev_ids.ckpt_save(out);
+    ckpt_put_bytes(out, &sst->old_sig, sizeof(sst->old_sig));
+    ckpt_put(out, mmap_end);
+
+    ckpt_put(out, i64(sst->valid_fds.size()));
+    FOR_CONST_ITER(SyscallState::SimulatedFDMap, sst->valid_fds, iter) {
+        ckpt_put(out, iter->first);
+        iter->second->ckpt_save(out);
+    }
+}
+
+
+void
+syscalls_ckpt_restore(SyscallState *sst, std::istream& in)
+{
+    typedef SyscallState::SimulatedFDMap SimulatedFDMap;
+    ckpt_expect_tag(in, "SyscallState");
+    ckpt_get(in, sst->local_clock, "SyscallState local_clock");
+    ckpt_get_str(in, sst->local_path, "SyscallState local_path");
+    ckpt_get(in, sst->alpha_uid, "SyscallState uid");
+    ckpt_get(in, sst->alpha_gid, "SyscallState gid");
+    ckpt_get(in, sst->alpha_pid, "SyscallState pid");
+    sst->alpha_inode_nums.ckpt_restore(in);
+    sst->alpha_dev_ids.ckpt_restore(in);
+    ckpt_get_bytes(in, &sst->old_sig, sizeof(sst->old_sig),
+                   "SyscallState old_sig");
+    {
+        // (mmap_end is shared by all apps; don't move it backwards)
+        u64 saved_mmap_end;
+        ckpt_get(in, saved_mmap_end, "SyscallState mmap_end");
+        if (saved_mmap_end > mmap_end)
+            mmap_end = saved_mmap_end;
+    }
+
+    // Rebuild the FD table: re-open saved host files, and keep the
+    // simulated-stdio FDs this SyscallState was created with, for those
+    // numbers the checkpoint still had open.
+    SimulatedFDMap old_fds;
+    old_fds.swap(sst->valid_fds);
+    i64 n_fds;
+    ckpt_get(in, n_fds, "SyscallState fd count");
+    for (i64 i = 0; i < n_fds; i++) {
+        int alpha_fd;
+        ckpt_get(in, alpha_fd, "SyscallState fd number");
+        scoped_ptr<SimulatedFD>
+            new_fd(new SimulatedFD(sst, sst->fmt_here_cb.get()));
+        if (new_fd->ckpt_restore(in)) {
+            new_fd->set_alpha_fd(alpha_fd);
+            map_put_uniq(sst->valid_fds, alpha_fd,
+                         scoped_ptr_release(new_fd));
+        } else {
+            SimulatedFDMap::iterator found = old_fds.find(alpha_fd);
+            if (found == old_fds.end()) {
+                exit_printf("checkpoint restore: simulated FD %d was a "
+                            "stream FD, but has no counterpart here\n",
+                            alpha_fd);
+            }
+            map_put_uniq(sst->valid_fds, alpha_fd, found->second);
+            old_fds.erase(found);
+        }
+    }
+    FOR_ITER(SimulatedFDMap, old_fds, iter)
+        delete iter->second;
+}
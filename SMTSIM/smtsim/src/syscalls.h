@@ -32,6 +32,12 @@ void syscalls_destroy(SyscallState *sst);
 
 int syscalls_dosyscall(struct AppState *astate, i64 local_clock);
 
+// For use in a fork()ed child: give each of this app's simulated file
+// descriptors its own host open-file, at the same offset, so that the
+// child's reads, writes and seeks don't move its parent's (or siblings')
+// file positions.  See SimulatedFD::reopen_host_fd().
+void syscalls_reopen_host_fds(SyscallState *sst);
+
 extern int SysTrace;
 
 
@@ -39,4 +45,16 @@ extern int SysTrace;
 }
 #endif
 
+
+#ifdef __cplusplus
+#include <iosfwd>
+
+// Checkpoint support: save or restore a SyscallState's emulated-OS state
+// (simulated clock, IDs, signal state, and the FD table; see
+// SimulatedFD::ckpt_save() for what's kept per descriptor).  Restoring
+// replaces the state of a SyscallState created for the same app.
+void syscalls_ckpt_save(const SyscallState *sst, std::ostream& out);
+void syscalls_ckpt_restore(SyscallState *sst, std::istream& in);
+#endif  // __cplusplus
+
 #endif  // SYSCALLS_H
@@ -244,6 +244,31 @@ tlb_get_tags(const TLBArray *tlb, int master_id, int *n_tags_ret)
 }
 
 
+LongAddr *
+tlb_get_tags_lru(const TLBArray *tlb, int *n_tags_ret)
+{
+    LongAddr *matches = NULL;
+    int *order = emalloc(tlb->n_entries * sizeof(order[0]));
+    int n_matches = 0;
+
+    aarray_recency_order(tlb->cam, 0, order);
+    for (int rank = tlb->n_entries - 1; rank >= 0; rank--) {
+        AssocArrayKey ent_key;
+        if (aarray_readkey(tlb->cam, 0, order[rank], &ent_key)) {
+            if (!matches)
+                matches = emalloc(tlb->n_entries * sizeof(*matches));
+            laddr_set(matches[n_matches],
+                      ent_key.lookup << tlb->page_bytes_lg, ent_key.match);
+            ++n_matches;
+        }
+    }
+
+    free(order);
+    *n_tags_ret = n_matches;
+    return matches;
+}
+
+
 // internal helper, since iterating over array is a pain
 // warning: plays games with const-ness of "tlb", it's guaranteed not to be
 // modified iff "flush_matches" is false
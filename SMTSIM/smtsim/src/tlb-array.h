@@ -46,6 +46,12 @@ u64 tlb_calc_baseaddr(const TLBArray *tlb, u64 addr);
 LongAddr *tlb_get_tags(const TLBArray *tlb, int master_id,
                        int *n_tags_ret);
 
+// Like tlb_get_tags(..., -1, ...), but ordered from least- to
+// most-recently used, for warm-state checkpoints: re-inserting them in order
+// with tlb_inject() reproduces the LRU state, or keeps the most-recent ones
+// in a smaller TLB.
+LongAddr *tlb_get_tags_lru(const TLBArray *tlb, int *n_tags_ret);
+
 // count the entries matching master_id
 int tlb_get_population(const TLBArray *tlb, int master_id);
 
@@ -274,6 +274,25 @@ public:
     }
 
     inline void fill(const TraceCacheBlock& new_block) {
+        place(new_block);
+        TDPRINTF("TC fill: %s\n", tcb_format(&new_block));
+    }
+
+    // Warm-state fill: like fill(), but without stats, and refusing blocks
+    // too big for this cache
+    bool warm_fill(const TraceCacheBlock& new_block) {
+        if ((new_block.inst_count > params.block_insts) ||
+            (new_block.pred_count > params.pred_per_block))
+            return false;
+        TraceCacheStats save_stats = stats;
+        place(new_block);
+        stats = save_stats;
+        return true;
+    }
+
+    void get_blocks_lru(vector<const TraceCacheBlock *>& dest) const;
+
+    inline void place(const TraceCacheBlock& new_block) {
         TraceCacheLookupInfo li;
         sim_assert(new_block.thread_id != -1);
         sim_assert(new_block.inst_count > 0);
@@ -285,7 +304,6 @@ public:
         TCEntry& ent = entries[entry_num];
         ent.reset();
         block_assign(ent.block, new_block);
-        TDPRINTF("TC fill: %s\n", tcb_format(&ent.block));
     }
 
     inline void inval(const TraceCacheLookupInfo& lookup_info) {
@@ -377,6 +395,26 @@ TraceCache::reset_stats()
 }
 
 
+// All valid blocks, every line's least-recently used first, up to the MRU
+// blocks last
+void
+TraceCache::get_blocks_lru(vector<const TraceCacheBlock *>& dest) const
+{
+    vector<int> orders(n_lines * params.assoc);
+    for (long line_num = 0; line_num < n_lines; line_num++)
+        aarray_recency_order(cam, line_num, &orders[line_num * params.assoc]);
+    for (int rank = params.assoc - 1; rank >= 0; rank--) {
+        for (long line_num = 0; line_num < n_lines; line_num++) {
+            int way_num = orders[line_num * params.assoc + rank];
+            if (aarray_readkey(cam, line_num, way_num, NULL)) {
+                const TCEntry& ent = entries[line_num * params.assoc + way_num];
+                dest.push_back(&ent.block);
+            }
+        }
+    }
+}
+
+
 //
 // C interface to TraceCache
 //
@@ -443,6 +481,29 @@ tc_get_params(const TraceCache *tc, TraceCacheParams *params_ret)
     tc->get_params(params_ret);
 }
 
+TraceCacheBlock **
+tc_get_blocks(const TraceCache *tc, int *n_blocks_ret)
+{
+    vector<const TraceCacheBlock *> blocks;
+    tc->get_blocks_lru(blocks);
+    TraceCacheBlock **result = NULL;
+    int n_blocks = static_cast<int>(blocks.size());
+    if (n_blocks > 0) {
+        result = static_cast<TraceCacheBlock **>
+            (emalloc(n_blocks * sizeof(result[0])));
+        for (int i = 0; i < n_blocks; i++)
+            result[i] = tcb_copy(tc, blocks[i]);
+    }
+    *n_blocks_ret = n_blocks;
+    return result;
+}
+
+int
+tc_warm_fill(TraceCache *tc, const TraceCacheBlock *block)
+{
+    return tc->warm_fill(*block);
+}
+
 
 //
 // Trace cache block utility code
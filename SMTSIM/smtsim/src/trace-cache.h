@@ -111,6 +111,16 @@ void tc_inval(TraceCache *tc, const TraceCacheLookupInfo *lookup_info);
 void tc_get_stats(const TraceCache *tc, TraceCacheStats *stats_ret);
 void tc_get_params(const TraceCache *tc, TraceCacheParams *params_ret);
 
+// Warm-state checkpoint support: tc_get_blocks() returns a malloc'd array
+// of copies (see tcb_copy()) of the valid blocks, NULL if none, with the
+// count written to n_blocks_ret.  They're ordered for re-insertion: every
+// line's least-recently used block first, up to the MRU blocks last.  Free
+// each with tcb_free(), then the array with free().  tc_warm_fill() is like
+// tc_fill(), but changes no stats; it returns 0 without filling if the
+// block has more instructions or predictions than this cache's blocks hold.
+TraceCacheBlock **tc_get_blocks(const TraceCache *tc, int *n_blocks_ret);
+int tc_warm_fill(TraceCache *tc, const TraceCacheBlock *block);
+
 
 TraceCacheBlock *tcb_alloc(const TraceCache *tc);
 TraceCacheBlock *tcb_copy(const TraceCache *tc, const TraceCacheBlock *tcb);
@@ -280,6 +280,11 @@ public:
             last_output_cyc = cyc;
         }
     }
+
+    i64 next_output_cyc() const {
+        return (output_ready_blks.empty()) ? I64_MAX :
+            (last_output_cyc + params.output_interval);
+    }
 };
 
 
@@ -387,3 +392,10 @@ tfu_process_queue(TraceFillUnit *tfu)
 {
     tfu->process_queue();
 }
+
+
+i64
+tfu_next_output_cyc(const TraceFillUnit *tfu)
+{
+    return tfu->next_output_cyc();
+}
@@ -42,6 +42,9 @@ void tfu_inst_commit(TraceFillUnit *tfu, const struct context *ctx,
 void tfu_context_threadswap(TraceFillUnit *tfu, const struct context *ctx);
 
 void tfu_process_queue(TraceFillUnit *tfu);
+// The next cycle at which tfu_process_queue() will fill the trace cache, or
+// I64_MAX if there's nothing waiting
+i64 tfu_next_output_cyc(const TraceFillUnit *tfu);
 
 
 #ifdef __cplusplus
@@ -77,6 +77,19 @@ log2_exact(u64 val)
 }
 
 
+int
+lowest_set_bit_64(u64 val)
+{
+    int shifts = 0;
+    sim_assert(val != 0);
+    while (!(val & 1)) {
+        val >>= 1;
+        shifts++;
+    }
+    return shifts;
+}
+
+
 void *
 emalloc(size_t size)
 {
@@ -15,6 +15,7 @@ extern "C" {
 
 int floor_log2(u64 val, int *inexact_ret);
 int log2_exact(u64 val);                // <0 <=> val not a power of 2
+int lowest_set_bit_64(u64 val);         // val nonzero; see LOWEST_BIT_64()
 void *emalloc(size_t size);
 void *emalloc_zero(size_t size);
 void *erealloc(void *mem, size_t new_size);
@@ -142,6 +143,14 @@ i64 ceil_mult_i64(i64 val, i64 mult);
 #define SET_BIT_64(offset) (U64_LIT(1) << (offset))
 
 
+// Index of the least-significant set bit of a nonzero u64 value
+#if defined(__GNUC__)
+#   define LOWEST_BIT_64(val) __builtin_ctzll(val)
+#else
+#   define LOWEST_BIT_64(val) lowest_set_bit_64(val)
+#endif
+
+
 // Generate unsigned values with <width> consecutive bits set, shifted
 // left <offset> bits from bit 0.  <width> MUST be less than the width
 // of the underlying type.
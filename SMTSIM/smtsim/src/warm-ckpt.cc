@@ -0,0 +1,573 @@
+//
+// Warm-state checkpoints: save the contents of caches, TLBs, and branch
+// predictors to a compressed file, and load them into a later run, possibly
+// with different cache geometries
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sim-assert.h"
+#include "sys-types.h"
+#include "warm-ckpt.h"
+#include "utils.h"
+#include "utils-cc.h"
+#include "sim-params.h"
+#include "cache-array.h"
+#include "cache.h"
+#include "tlb-array.h"
+#include "btb-array.h"
+#include "pht-predict.h"
+#include "multi-bpredict.h"
+#include "trace-cache.h"
+#include "core-resources.h"
+#include "main.h"
+#include "gzstream.h"
+#include "ckpt-io.h"
+
+using std::istringstream;
+using std::map;
+using std::ostringstream;
+using std::pair;
+using std::string;
+using std::vector;
+
+
+namespace {
+
+const char *CkptMagic = "SMTSIM-WarmCkpt";
+const i32 CkptVersion = 1;
+
+enum WarmKind { WK_Cache, WK_TLB, WK_BTB, WK_PHT, WK_MultiBP, WK_TraceCache,
+                WarmKind_last };
+const char *WarmKind_names[] = {
+    "Cache", "TLB", "BTB", "PHT", "MultiBP", "TraceCache", NULL
+};
+
+// One structure in the simulated machine, with its checkpoint name
+struct WarmTarget {
+    string name;
+    WarmKind kind;
+    void *obj;
+    CoreResources *core;        // for caches: as for cachesim_reconfigure()
+    WarmTarget(const string& name_, WarmKind kind_, void *obj_,
+               CoreResources *core_)
+        : name(name_), kind(kind_), obj(obj_), core(core_) { }
+};
+
+// Serialized bodies, by name
+typedef map<string, pair<WarmKind, string> > RecordMap;
+
+struct {
+    string save_name;           // empty <=> not saving
+    string restore_name;
+    RecordMap *restore_records; // NULL <=> not restoring
+} WarmGlobals = { "", "", NULL };
+
+
+void
+list_targets(vector<WarmTarget>& dest)
+{
+    for (int core_id = 0; core_id < CoreCount; ++core_id) {
+        CoreResources *core = Cores[core_id];
+        const string pref = string("core") + fmt_i64(core_id) + ".";
+        dest.push_back(WarmTarget(pref + "ICache", WK_Cache, core->icache,
+                                  core));
+        dest.push_back(WarmTarget(pref + "DCache", WK_Cache, core->dcache,
+                                  core));
+        if (GlobalParams.mem.private_l2caches) {
+            dest.push_back(WarmTarget(pref + "L2Cache", WK_Cache,
+                                      core->l2cache, core));
+        }
+        dest.push_back(WarmTarget(pref + "ITLB", WK_TLB, core->itlb, core));
+        dest.push_back(WarmTarget(pref + "DTLB", WK_TLB, core->dtlb, core));
+        dest.push_back(WarmTarget(pref + "BTB", WK_BTB, core->btb, core));
+        dest.push_back(WarmTarget(pref + "PHT", WK_PHT, core->pht, core));
+        dest.push_back(WarmTarget(pref + "MultiBP", WK_MultiBP,
+                                  core->multi_bp, core));
+        dest.push_back(WarmTarget(pref + "TraceCache", WK_TraceCache,
+                                  core->tcache, core));
+    }
+    if (SharedL2Cache)
+        dest.push_back(WarmTarget("L2Cache", WK_Cache, SharedL2Cache, NULL));
+    if (SharedL3Cache)
+        dest.push_back(WarmTarget("L3Cache", WK_Cache, SharedL3Cache, NULL));
+
+    // (some structures are optional)
+    vector<WarmTarget> present;
+    FOR_CONST_ITER(vector<WarmTarget>, dest, iter) {
+        if (iter->obj)
+            present.push_back(*iter);
+    }
+    dest.swap(present);
+}
+
+
+void
+put_laddr(std::ostream& out, const LongAddr& addr)
+{
+    ckpt_put(out, addr.a);
+    ckpt_put(out, addr.id);
+}
+
+void
+get_laddr(std::istream& in, LongAddr& addr, const char *what)
+{
+    ckpt_get(in, addr.a, what);
+    ckpt_get(in, addr.id, what);
+}
+
+
+// Each save_*() writes a body and returns the number of entries; each
+// restore_*() reads one and returns the number of entries loaded.
+
+i32
+save_cache(std::ostream& out, const CacheArray *cache)
+{
+    int n_blocks;
+    CacheWarmBlock *blocks = cache_warm_export(cache, &n_blocks);
+    ckpt_put(out, i32(n_blocks));
+    for (int i = 0; i < n_blocks; i++) {
+        put_laddr(out, blocks[i].base_addr);
+        ckpt_put(out, i32(blocks[i].writeable));
+        ckpt_put(out, i32(blocks[i].dirty));
+    }
+    free(blocks);
+    return n_blocks;
+}
+
+i32
+restore_cache(std::istream& in, CacheArray *cache, CoreResources *core)
+{
+    i32 n_blocks;
+    ckpt_get(in, n_blocks, "cache block count");
+    vector<CacheWarmBlock> blocks(n_blocks);
+    for (int i = 0; i < n_blocks; i++) {
+        i32 writeable, dirty;
+        get_laddr(in, blocks[i].base_addr, "cache block");
+        ckpt_get(in, writeable, "cache block");
+        ckpt_get(in, dirty, "cache block");
+        blocks[i].writeable = writeable;
+        blocks[i].dirty = dirty;
+    }
+    return cachesim_warm_restore(core, cache,
+                                 (blocks.empty()) ? NULL : &blocks[0],
+                                 n_blocks);
+}
+
+
+i32
+save_tlb(std::ostream& out, const TLBArray *tlb)
+{
+    int n_tags;
+    LongAddr *tags = tlb_get_tags_lru(tlb, &n_tags);
+    ckpt_put(out, i32(n_tags));
+    for (int i = 0; i < n_tags; i++)
+        put_laddr(out, tags[i]);
+    free(tags);
+    return n_tags;
+}
+
+i32
+restore_tlb(std::istream& in, TLBArray *tlb)
+{
+    i32 n_tags;
+    ckpt_get(in, n_tags, "TLB entry count");
+    tlb_reset(tlb);
+    for (int i = 0; i < n_tags; i++) {
+        LongAddr addr;
+        get_laddr(in, addr, "TLB entry");
+        tlb_inject(tlb, 0, addr.a, addr.id);
+    }
+    return n_tags;
+}
+
+
+i32
+save_btb(std::ostream& out, const BTBArray *btb)
+{
+    int n_ents;
+    BTBWarmEntry *ents = btb_get_entries(btb, &n_ents);
+    ckpt_put(out, i32(n_ents));
+    for (int i = 0; i < n_ents; i++) {
+        ckpt_put(out, ents[i].addr);
+        ckpt_put(out, i32(ents[i].thread_id));
+        ckpt_put(out, ents[i].dest);
+    }
+    free(ents);
+    return n_ents;
+}
+
+i32
+restore_btb(std::istream& in, BTBArray *btb)
+{
+    i32 n_ents;
+    ckpt_get(in, n_ents, "BTB entry count");
+    btb_reset(btb);
+    for (int i = 0; i < n_ents; i++) {
+        u64 addr, dest;
+        i32 thread_id;
+        ckpt_get(in, addr, "BTB entry");
+        ckpt_get(in, thread_id, "BTB entry");
+        ckpt_get(in, dest, "BTB entry");
+        btb_inject(btb, addr, thread_id, dest);
+    }
+    return n_ents;
+}
+
+
+i32
+save_pht(std::ostream& out, const PHTPredict *pht)
+{
+    i64 n_ents = pht_get_size(pht);
+    vector<int> counters(n_ents);
+    pht_read_counters(pht, &counters[0]);
+    ckpt_put(out, n_ents);
+    for (i64 i = 0; i < n_ents; i++)
+        ckpt_put(out, u8(counters[i]));
+    return i32(n_ents);
+}
+
+i32
+restore_pht(std::istream& in, PHTPredict *pht, const string& name)
+{
+    i64 n_ents;
+    ckpt_get(in, n_ents, "PHT size");
+    if ((n_ents <= 0) || (n_ents & (n_ents - 1))) {
+        exit_printf("warm checkpoint: %s: bad PHT size %s\n", name.c_str(),
+                    fmt_i64(n_ents));
+    }
+    vector<int> counters(n_ents);
+    for (i64 i = 0; i < n_ents; i++) {
+        u8 val;
+        ckpt_get(in, val, "PHT counter");
+        counters[i] = val;
+    }
+    pht_write_counters(pht, &counters[0], n_ents);
+    return i32(pht_get_size(pht));
+}
+
+
+i32
+save_mbp(std::ostream& out, const MultiBPredict *mbp)
+{
+    MultiBPredictParams params;
+    mbp_get_params(mbp, &params);
+    vector<u32> rows(params.n_rows);
+    mbp_read_rows(mbp, &rows[0]);
+    ckpt_put(out, i32(params.predict_width));
+    ckpt_put(out, params.n_rows);
+    ckpt_put_bytes(out, &rows[0], rows.size() * sizeof(rows[0]));
+    return i32(params.n_rows);
+}
+
+i32
+restore_mbp(std::istream& in, MultiBPredict *mbp, const string& name)
+{
+    MultiBPredictParams params;
+    mbp_get_params(mbp, &params);
+    i32 width;
+    u32 n_rows;
+    ckpt_get(in, width, "MultiBP width");
+    ckpt_get(in, n_rows, "MultiBP rows");
+    if ((n_rows == 0) || (n_rows & (n_rows - 1))) {
+        exit_printf("warm checkpoint: %s: bad row count %s\n", name.c_str(),
+                    fmt_u64(n_rows));
+    }
+    vector<u32> rows(n_rows);
+    ckpt_get_bytes(in, &rows[0], rows.size() * sizeof(rows[0]),
+                   "MultiBP rows");
+    if (width != params.predict_width) {
+        printf("--Warm checkpoint: %s: saved predict_width %d doesn't match "
+               "%d; left cold\n", name.c_str(), int(width),
+               params.predict_width);
+        return 0;
+    }
+    mbp_write_rows(mbp, &rows[0], n_rows);
+    return i32(params.n_rows);
+}
+
+
+i32
+save_tcache(std::ostream& out, const TraceCache *tc)
+{
+    int n_blocks;
+    TraceCacheBlock **blocks = tc_get_blocks(tc, &n_blocks);
+    ckpt_put(out, i32(n_blocks));
+    for (int i = 0; i < n_blocks; i++) {
+        const TraceCacheBlock *blk = blocks[i];
+        ckpt_put(out, i32(blk->thread_id));
+        ckpt_put(out, i32(blk->inst_count));
+        ckpt_put(out, i32(blk->pred_count));
+        ckpt_put(out, blk->predict_bits);
+        ckpt_put(out, blk->fallthrough_pc);
+        for (int j = 0; j < blk->inst_count; j++) {
+            const TraceCacheInst& inst = blk->insts[j];
+            ckpt_put(out, inst.pc);
+            ckpt_put(out, inst.target_pc);
+            ckpt_put(out, inst.br_flags);
+            ckpt_put(out, inst.cgroup_flags);
+        }
+        tcb_free(blocks[i]);
+    }
+    free(blocks);
+    return n_blocks;
+}
+
+i32
+restore_tcache(std::istream& in, TraceCache *tc, const string& name)
+{
+    i32 n_blocks;
+    ckpt_get(in, n_blocks, "trace cache block count");
+    tc_reset(tc);
+    int n_filled = 0;
+    for (int i = 0; i < n_blocks; i++) {
+        TraceCacheBlock blk;
+        i32 thread_id, inst_count, pred_count;
+        ckpt_get(in, thread_id, "trace block");
+        ckpt_get(in, inst_count, "trace block");
+        ckpt_get(in, pred_count, "trace block");
+        ckpt_get(in, blk.predict_bits, "trace block");
+        ckpt_get(in, blk.fallthrough_pc, "trace block");
+        if (inst_count <= 0) {
+            exit_printf("warm checkpoint: %s: bad trace block length %d\n",
+                        name.c_str(), int(inst_count));
+        }
+        vector<TraceCacheInst> insts(inst_count);
+        for (int j = 0; j < inst_count; j++) {
+            TraceCacheInst& inst = insts[j];
+            ckpt_get(in, inst.pc, "trace inst");
+            ckpt_get(in, inst.target_pc, "trace inst");
+            ckpt_get(in, inst.br_flags, "trace inst");
+            ckpt_get(in, inst.cgroup_flags, "trace inst");
+        }
+        blk.thread_id = thread_id;
+        blk.inst_count = inst_count;
+        blk.pred_count = pred_count;
+        blk.insts = &insts[0];
+        if (tc_warm_fill(tc, &blk))
+            n_filled++;
+    }
+    return n_filled;
+}
+
+
+i32
+save_target(std::ostream& out, const WarmTarget& targ)
+{
+    i32 result = 0;
+    switch (targ.kind) {
+    case WK_Cache:
+        result = save_cache(out, static_cast<CacheArray *>(targ.obj));
+        break;
+    case WK_TLB:
+        result = save_tlb(out, static_cast<TLBArray *>(targ.obj));
+        break;
+    case WK_BTB:
+        result = save_btb(out, static_cast<BTBArray *>(targ.obj));
+        break;
+    case WK_PHT:
+        result = save_pht(out, static_cast<PHTPredict *>(targ.obj));
+        break;
+    case WK_MultiBP:
+        result = save_mbp(out, static_cast<MultiBPredict *>(targ.obj));
+        break;
+    case WK_TraceCache:
+        result = save_tcache(out, static_cast<TraceCache *>(targ.obj));
+        break;
+    default:
+        ENUM_ABORT(WarmKind, targ.kind);
+    }
+    return result;
+}
+
+
+i32
+restore_target(std::istream& in, const WarmTarget& targ)
+{
+    i32 result = 0;
+    switch (targ.kind) {
+    case WK_Cache:
+        result = restore_cache(in, static_cast<CacheArray *>(targ.obj),
+                               targ.core);
+        break;
+    case WK_TLB:
+        result = restore_tlb(in, static_cast<TLBArray *>(targ.obj));
+        break;
+    case WK_BTB:
+        result = restore_btb(in, static_cast<BTBArray *>(targ.obj));
+        break;
+    case WK_PHT:
+        result = restore_pht(in, static_cast<PHTPredict *>(targ.obj),
+                             targ.name);
+        break;
+    case WK_MultiBP:
+        result = restore_mbp(in, static_cast<MultiBPredict *>(targ.obj),
+                             targ.name);
+        break;
+    case WK_TraceCache:
+        result = restore_tcache(in, static_cast<TraceCache *>(targ.obj),
+                                targ.name);
+        break;
+    default:
+        ENUM_ABORT(WarmKind, targ.kind);
+    }
+    return result;
+}
+
+}       // Anonymous namespace close
+
+
+void
+warmckpt_save_open(const char *filename)
+{
+    sim_assert(WarmGlobals.save_name.empty());
+    if (!filename[0]) {
+        exit_printf("empty warm checkpoint filename\n");
+    }
+    WarmGlobals.save_name = filename;
+}
+
+
+int
+warmckpt_saving(void)
+{
+    return !WarmGlobals.save_name.empty();
+}
+
+
+void
+warmckpt_save_and_exit_maybe(void)
+{
+    if (!warmckpt_saving())
+        return;
+    const char *filename = WarmGlobals.save_name.c_str();
+    gzstream::ogzstream out(filename);
+    if (!out.is_open() || !out) {
+        exit_printf("couldn't open warm checkpoint \"%s\" for writing\n",
+                    filename);
+    }
+    ckpt_put_tag(out, CkptMagic);
+    ckpt_put(out, CkptVersion);
+
+    vector<WarmTarget> targets;
+    list_targets(targets);
+    FOR_CONST_ITER(vector<WarmTarget>, targets, iter) {
+        // (bodies are length-prefixed, so restoring can skip records for
+        // structures it doesn't have)
+        ostringstream body;
+        i32 n_ents = save_target(body, *iter);
+        ckpt_put_tag(out, "Struct");
+        ckpt_put_str(out, iter->name);
+        ckpt_put(out, i32(iter->kind));
+        ckpt_put_str(out, body.str());
+        printf("--Warm checkpoint: saved %s (%s entries)\n",
+               iter->name.c_str(), fmt_i64(n_ents));
+    }
+    ckpt_put_tag(out, "End");
+    bool ok = !out.fail();
+    out.close();
+    if (!ok) {
+        exit_printf("write to warm checkpoint \"%s\" failed\n", filename);
+    }
+    printf("--Warm checkpoint: wrote %d structures to \"%s\" at cyc %s\n",
+           intsize(targets), filename, fmt_now());
+    sim_exit_ok("warm checkpoint saved");
+}
+
+
+void
+warmckpt_restore_open(const char *filename)
+{
+    sim_assert(!WarmGlobals.restore_records);
+    WarmGlobals.restore_name = filename;
+    gzstream::igzstream in(filename);
+    if (!in.is_open() || !in) {
+        exit_printf("couldn't open warm checkpoint \"%s\" for reading\n",
+                    filename);
+    }
+    ckpt_expect_tag(in, CkptMagic);
+    i32 version;
+    ckpt_get(in, version, "version");
+    if (version != CkptVersion) {
+        exit_printf("warm checkpoint \"%s\" is version %d; this simulator "
+                    "reads version %d\n", filename, int(version),
+                    int(CkptVersion));
+    }
+
+    RecordMap *records = new RecordMap();
+    string tag;
+    for (;;) {
+        ckpt_get_str(in, tag, "section tag");
+        if (tag != "Struct")
+            break;
+        string name;
+        i32 kind;
+        ckpt_get_str(in, name, "structure name");
+        ckpt_get(in, kind, "structure kind");
+        if ((kind < 0) || (kind >= WarmKind_last)) {
+            exit_printf("warm checkpoint \"%s\": %s has unknown kind %d\n",
+                        filename, name.c_str(), int(kind));
+        }
+        pair<RecordMap::iterator, bool> ins =
+            records->insert(std::make_pair(name,
+                                           std::make_pair(WarmKind(kind),
+                                                          string())));
+        if (!ins.second) {
+            exit_printf("warm checkpoint \"%s\": duplicate record for %s\n",
+                        filename, name.c_str());
+        }
+        ckpt_get_str(in, ins.first->second.second, "structure record");
+    }
+    if (tag != "End") {
+        exit_printf("warm checkpoint format mismatch: expected section "
+                    "\"Struct\" or \"End\", found \"%s\"\n", tag.c_str());
+    }
+    WarmGlobals.restore_records = records;
+    printf("--Warm checkpoint: loaded %d structures from \"%s\"\n",
+           intsize(*records), filename);
+}
+
+
+void
+warmckpt_restore_apply(void)
+{
+    if (!WarmGlobals.restore_records)
+        return;
+    scoped_ptr<RecordMap> records(WarmGlobals.restore_records);
+    WarmGlobals.restore_records = NULL;
+
+    vector<WarmTarget> targets;
+    list_targets(targets);
+    FOR_CONST_ITER(vector<WarmTarget>, targets, iter) {
+        RecordMap::iterator found = records->find(iter->name);
+        if (found == records->end()) {
+            printf("--Warm checkpoint: no record for %s; left cold\n",
+                   iter->name.c_str());
+            continue;
+        }
+        if (found->second.first != iter->kind) {
+            exit_printf("warm checkpoint \"%s\": %s was saved as a %s, "
+                        "but is a %s here\n",
+                        WarmGlobals.restore_name.c_str(), iter->name.c_str(),
+                        WarmKind_names[found->second.first],
+                        WarmKind_names[iter->kind]);
+        }
+        istringstream body(found->second.second);
+        i32 n_ents = restore_target(body, *iter);
+        printf("--Warm checkpoint: restored %s (%s entries)\n",
+               iter->name.c_str(), fmt_i64(n_ents));
+        records->erase(found);
+    }
+    FOR_CONST_ITER(RecordMap, *records, iter) {
+        printf("--Warm checkpoint: ignoring record for %s (not present)\n",
+               iter->first.c_str());
+    }
+}
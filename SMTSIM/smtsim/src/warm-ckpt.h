@@ -0,0 +1,51 @@
+//
+// Warm-state checkpoints: save the contents of caches, TLBs, and branch
+// predictors to a compressed file, and load them into a later run, possibly
+// with different cache geometries
+//
+
+#ifndef WARM_CKPT_H
+#define WARM_CKPT_H
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A warm checkpoint holds one record per structure, named for its place in
+// the machine ("core0.DCache", "core1.BTB", "L2Cache", ...): cache blocks
+// with their permission/dirty state, TLB pages, BTB entries and trace cache
+// blocks, each listed in recency order, and PHT / multiple-branch predictor
+// counter tables.  Addresses carry app master IDs, so the jobs should be
+// set up the same way (e.g. restored from the matching "-ckpt-restore").
+//
+// Restoring loads each structure present in both the checkpoint and the
+// machine.  Caches, TLBs, BTBs and trace caches re-insert their entries
+// oldest-first into whatever geometry they now have, keeping the
+// most-recent ones when they're smaller (see cache_warm_import()); counter
+// tables are repeated or truncated to the new size.  Structures without a
+// saved record stay cold.
+
+// Save to "filename" (-warm-save), when detailed simulation of the measured
+// region would begin: see warmckpt_save_and_exit_maybe().
+void warmckpt_save_open(const char *filename);
+int warmckpt_saving(void);
+
+// If saving, write everything out and exit the simulator.  This is called
+// after the initial jobs are fast-forwarded (along with
+// appckpt_save_close()) if there's no "-wu" warmup, and otherwise when the
+// warmup ends.
+void warmckpt_save_and_exit_maybe(void);
+
+// Load the records from "filename" (-warm-restore); they're applied by
+// warmckpt_restore_apply(), which is a no-op without a checkpoint.  That's
+// called after the initial jobs are fast-forwarded (or restored), before
+// any "-wu" warmup.
+void warmckpt_restore_open(const char *filename);
+void warmckpt_restore_apply(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // WARM_CKPT_H
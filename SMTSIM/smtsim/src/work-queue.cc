@@ -38,6 +38,9 @@ const char RCSid_1187823723[] =
 #include "jtimer.h"
 #include "app-stats-log.h"
 #include "bbtracker.h"
+#include "app-ckpt.h"
+#include "func-warm.h"
+#include "cache.h"
 
 using std::string;
 using std::list;
@@ -82,6 +85,12 @@ fast_forward_single(AppState *as, i64 ff_dist)
     fast_forward_app(as, ff_dist);
     jtimer_startstop(ff_timer, 0);
     jtimer_startstop(SimTimer, sim_timer_was_running);
+    if (fwarm_ff_enabled() && (cyc == 0)) {
+        // Keep the warming accesses out of the stats for the detailed run
+        // (jobs fast-forwarded later on are just counted)
+        zero_cstats();
+        zero_pstats();
+    }
 
     JTimerTimes times;
     jtimer_read(ff_timer, &times);
@@ -400,11 +409,17 @@ JobInstance::JobInstance(i64 job_id_, const string& workload_path_,
             }
         }
 
-        as->extra->fast_forward_dist = ff_dist;
-        if (ff_dist > 0) {
+        if (appckpt_restore_app(as, job_id, workload_path.c_str(),
+                                &ff_dist)) {
+            // Checkpoint restore stands in for fast-forwarding
+        } else if (ff_dist > 0) {
             // May stop early, or call exit(), due to exit syscall
             fast_forward_single(as, ff_dist);
         }
+        as->extra->fast_forward_dist = ff_dist;
+        if (appckpt_saving()) {
+            appckpt_save_app(as, job_id, workload_path.c_str(), ff_dist);
+        }
     }
 
     app_params_destroy(app_params);